@@ -0,0 +1,101 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   AccessLog.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 20:31:47 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 20:31:47 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef ACCESSLOG_HPP
+#define ACCESSLOG_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <stdint.h>  // For uint64_t
+
+#include <cstddef>  // For std::size_t
+#include <ctime>    // For time_t
+#include <deque>    // For std::deque
+#include <string>   // For std::string
+
+#include "Trace.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// One access_log file as written by a single event loop. Records are formatted into a buffer
+// that is written out once it holds bufferSize bytes or its oldest record is flushInterval
+// seconds old, so a busy loop pays one write() per batch. Every loop (reactor thread or worker
+// process) opens the file on its own with O_APPEND; a batch only ever holds whole lines, so
+// lines from different loops do not interleave.
+//
+// reopen() is meant for log rotation: the buffer is written to the old file, then the path is
+// opened again.
+class AccessLog {
+public:
+    // A response from the moment its request was parsed until its last byte was sent. Responses
+    // are delimited by their offsets in everything queued on the connection
+    struct Record {
+        std::string  method;
+        std::string  path;
+        int          status;
+        uint64_t     started;       // When the request began arriving, see now()
+        uint64_t     parsed;        // When the request was complete
+        uint64_t     queued;        // When the whole response was queued
+        uint64_t     upstreamTime;  // Microseconds the CGI script or FastCGI upstream took
+        bool         hasUpstream;
+        std::size_t  requests;  // Requests served on the connection, this one included
+        std::size_t  begin;     // Offset of the first byte of the response
+        std::size_t  end;       // Offset just past its last byte
+        RequestTrace trace;     // Empty unless built with TRACE=1
+
+        Record();
+    };
+
+    typedef std::deque<Record> RecordQueue;
+
+    AccessLog();
+    ~AccessLog();
+
+    bool open(const std::string& path, const std::string& format, std::size_t bufferSize,
+              std::size_t flushInterval);
+    bool isEnabled() const;
+    bool hasPending() const;
+    void write(const Record& record, std::size_t bytesSent);
+    void flushIfDue(time_t now);
+    void flush();
+    bool reopen();
+
+    static uint64_t now();
+
+private:
+    std::string m_Path;
+    int         m_Fd;
+    bool        m_Json;
+    std::size_t m_BufferSize;
+    time_t      m_FlushInterval;
+    std::string m_Buffer;
+    time_t      m_FirstPending;  // When the oldest buffered record was added
+    time_t      m_TimeCached;    // Second m_TimeString was formatted for
+    std::string m_TimeString;
+
+    static int         openFile(const std::string& path);
+    static std::string escape(const std::string& value);
+    void               formatTime(time_t now);
+
+    AccessLog(const AccessLog& that);
+    AccessLog& operator=(const AccessLog& that);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -0,0 +1,86 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CgiProcess.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 11:04:18 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 11:04:18 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CGIPROCESS_HPP
+#define CGIPROCESS_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <sys/types.h>  // For pid_t
+
+#include <cstddef>  // For std::size_t
+#include <string>   // For std::string
+#include <vector>   // For std::vector
+
+#include "HttpRequest.hpp"
+#include "Logger.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// One running CGI script. start() forks the child with non-blocking pipes for its stdin and
+// stdout and returns at once; the Monitor registers the pipes in its event loop, feeds the
+// request body as stdin becomes writable and relays stdout to the client as it arrives. The
+// exit status is delivered by the loop when it reaps the child.
+class CgiProcess {
+public:
+    CgiProcess(const Logger& logger);
+    ~CgiProcess();
+
+    bool start(const std::vector<std::string>& argv, const std::vector<std::string>& env,
+               const HttpRequest& request);
+    bool writeInput();
+    void terminate();
+
+    pid_t getPid() const;
+    int   getInputFd() const;
+    int   getOutputFd() const;
+    void  releaseInputFd();
+    void  releaseOutputFd();
+    bool  hasPendingInput() const;
+
+    void setExitStatus(int status);
+    bool hasExited() const;
+    bool succeeded() const;
+
+    // Relay state kept for the event loop
+    int  getClientFd() const;
+    void setClientFd(int fdesc);
+    bool isOutputPaused() const;
+    void setOutputPaused(bool paused);
+
+private:
+    Logger      m_Logger;
+    pid_t       m_Pid;
+    int         m_InputFd;   // Write end of the child's stdin, -1 once closed
+    int         m_OutputFd;  // Read end of the child's stdout and stderr, -1 once closed
+    std::string m_Input;     // Request body still to be written to stdin
+    std::size_t m_InputOffset;
+    int         m_ExitStatus;
+    bool        m_Exited;
+    int         m_ClientFd;
+    bool        m_OutputPaused;  // Output fd left out of the loop until the client drains
+
+    CgiProcess(const CgiProcess& that);
+    CgiProcess& operator=(const CgiProcess& that);
+
+    static bool makePipe(int fds[2], int parentEnd);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
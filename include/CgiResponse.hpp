@@ -0,0 +1,73 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CgiResponse.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 16:12:40 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 16:12:40 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CGIRESPONSE_HPP
+#define CGIRESPONSE_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define CGI_HEADER_LIMIT 16384
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <cstddef>  // For std::size_t
+#include <string>   // For std::string
+
+#include "HttpResponse.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Header block a CGI script writes ahead of its body (RFC 3875, section 6). Output is fed in as
+// it arrives until the blank line that ends the block; whatever follows it is body and is left
+// for the caller to relay. Output that does not open with a header line, or whose first
+// CGI_HEADER_LIMIT bytes hold no complete block, is all body, served as text/html.
+class CgiResponse {
+public:
+    CgiResponse();
+
+    bool parse(const char* data, std::size_t length);
+    void finish();
+    void apply(HttpResponse& response) const;
+    void takeBody(std::string& body);
+    void clear();
+
+    bool isComplete() const;
+    int  getStatus() const;
+
+private:
+    std::string m_Buffer;   // Output received while the header block is incomplete
+    std::string m_Body;     // Body bytes received along with the header block
+    std::string m_Headers;  // Header lines passed through to the client, CRLF terminated
+    int         m_Status;   // 0 until a Status header sets it
+    std::string m_Reason;
+    bool        m_HasContentType;
+    bool        m_HasLocation;
+    bool        m_Complete;
+
+    bool        startsWithHeader() const;
+    void        parseBlock(std::size_t end);
+    void        parseLine(const std::string& line);
+    void        treatAsBody();
+    static bool isDropped(const std::string& name);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
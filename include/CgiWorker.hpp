@@ -0,0 +1,58 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CgiWorker.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 14:22:05 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 14:22:05 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CGIWORKER_HPP
+#define CGIWORKER_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define CGI_WORKER_PREFIX "worker:"  // Upstream address prefix of a worker pool
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <sys/types.h>  // For pid_t
+
+#include <string>  // For std::string
+#include <vector>  // For std::vector
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Pre-forked interpreters for Python and Perl CGI scripts. Each worker is a python3 or perl
+// process running a small bootstrap loop that reads FastCGI records from a socketpair on its
+// stdin, runs the requested script in-process with the CGI environment, stdin and stdout it
+// expects, and answers with STDOUT and END_REQUEST records. The Monitor pools workers like the
+// connections of a FastCGI upstream whose address is "worker:" plus the script extension.
+class CgiWorker {
+public:
+    static std::string              getPoolAddress(const std::string& filePath);
+    static std::vector<std::string> getPoolAddresses();
+    static bool                     isPoolAddress(const std::string& address);
+    static bool                     isAvailable(const std::string& address);
+    static int                      spawn(const std::string& address, pid_t& pid);
+
+private:
+    CgiWorker();
+
+    static std::string getInterpreter(const std::string& address);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -15,6 +15,7 @@
 
 #include <stdint.h>  // For int types
 
+#include <cstddef>  // For std::size_t
 #include <map>      // For std::map
 #include <set>      // For std::set
 #include <string>   // For std::string
@@ -25,7 +26,13 @@
 
 class Config {
 public:
-    typedef std::pair<uint32_t, uint16_t> Listen;
+    // Address and port in network byte order, followed by the socket options of the directive
+    struct Listen : public std::pair<uint32_t, uint16_t> {
+        int  backlog;   // Connections the kernel queues until they are accepted
+        bool deferred;  // Report a connection only once its first data arrived
+
+        Listen(uint32_t address, uint16_t port);
+    };
 
     struct Location {
         std::string              path;
@@ -34,6 +41,8 @@ public:
         bool                     autoindex;
         std::set<std::string>    allowMethods;
         std::size_t              clientMaxBodySize;
+        std::string              fastcgiPass;  // "unix:/path" or "host:port", empty runs CGI
+        bool                     metrics;      // Answers with the server metrics instead
     };
 
     struct Server {
@@ -54,12 +63,65 @@ public:
     bool load(const char* programName);
 
     const std::vector<Server>& getServers() const;
+    const std::string&         getEventBackend() const;
+    bool                       isEdgeTriggered() const;
+    std::size_t                getKeepaliveTimeout() const;
+    std::size_t                getKeepaliveRequests() const;
+    std::size_t                getClientHeaderTimeout() const;
+    std::size_t                getClientBodyTimeout() const;
+    std::size_t                getSendTimeout() const;
+    std::size_t                getOpenFileCache() const;
+    std::size_t                getOpenFileCacheValid() const;
+    std::size_t                getResponseCacheMaxFile() const;
+    std::size_t                getResponseCacheSize() const;
+    std::size_t                getFastcgiKeepalive() const;
+    std::size_t                getCgiWorkers() const;
+    std::size_t                getCgiWorkerRequests() const;
+    std::size_t                getWorkerProcesses() const;
+    std::size_t                getAcceptBatch() const;
+    std::size_t                getReactorThreads() const;
+    const std::string&         getReactorBalance() const;
+    const std::string&         getLogFile() const;
+    std::size_t                getLogBuffer() const;
+    bool                       isLogOverflowBlocking() const;
+    const std::string&         getAccessLog() const;
+    const std::string&         getAccessLogFormat() const;
+    std::size_t                getAccessLogBuffer() const;
+    std::size_t                getAccessLogFlush() const;
+    std::size_t                getTraceRing() const;
+    bool                       hasMetricsLocation() const;
 
 private:
     static const std::string defaultConfigFilename;
 
     Logger              m_Logger;
     std::vector<Server> m_Servers;
+    std::string         m_EventBackend;  // Empty selects the build default
+    bool                m_EdgeTriggered;
+    std::size_t         m_KeepaliveTimeout;      // Seconds an idle connection is kept, 0 disables
+    std::size_t         m_KeepaliveRequests;     // Requests served before a connection is closed
+    std::size_t         m_ClientHeaderTimeout;   // Seconds to receive a whole request head
+    std::size_t         m_ClientBodyTimeout;     // Seconds between two reads of a request body
+    std::size_t         m_SendTimeout;           // Seconds between two writes of a response
+    std::size_t         m_OpenFileCache;         // Cached static file paths, 0 disables
+    std::size_t         m_OpenFileCacheValid;    // Seconds a cached entry is trusted without stat
+    std::size_t         m_ResponseCacheMaxFile;  // Largest static file kept in memory
+    std::size_t         m_ResponseCacheSize;     // Memory for cached file content, 0 disables
+    std::size_t         m_FastcgiKeepalive;      // Pooled connections per FastCGI upstream
+    std::size_t         m_CgiWorkers;            // Warm interpreters per extension, 0 forks
+    std::size_t         m_CgiWorkerRequests;     // Requests before a worker is replaced, 0 never
+    std::size_t         m_WorkerProcesses;       // Processes serving the listen ports, 1 runs alone
+    std::size_t         m_AcceptBatch;           // Connections accepted per listen socket wakeup
+    std::size_t         m_ReactorThreads;        // Threads serving accepted clients, 0 disables
+    std::string         m_ReactorBalance;        // "round_robin" or "least_loaded"
+    std::string         m_LogFile;               // Empty logs to the standard output
+    std::size_t         m_LogBuffer;             // Lines queued for the flush thread, 0 writes inline
+    bool                m_LogOverflowBlocking;   // A full log buffer waits instead of dropping
+    std::string         m_AccessLog;             // Access log path, empty when off
+    std::string         m_AccessLogFormat;       // "text" or "json" (one object per line)
+    std::size_t         m_AccessLogBuffer;       // Bytes of records gathered into one write
+    std::size_t         m_AccessLogFlush;        // Seconds a buffered record waits at most
+    std::size_t         m_TraceRing;             // Request traces each loop keeps for SIGUSR1
 
     static std::string searchConfigFile(const char* programName);
 
@@ -75,6 +137,31 @@ private:
     static void handleAutoindex(Location& currentLocation, std::istringstream& iss);
     static void handleAllowMethods(Location& currentLocation, std::istringstream& iss);
     static void handleClientMaxBodySize(Location& currentLocation, std::istringstream& iss);
+    static void handleFastcgiPass(Location& currentLocation, std::istringstream& iss);
+    static void handleMetrics(Location& currentLocation, std::istringstream& iss);
+    void        handleEventBackend(std::istringstream& iss);
+    void        handleEdgeTriggered(std::istringstream& iss);
+    void        handleKeepaliveTimeout(std::istringstream& iss);
+    void        handleKeepaliveRequests(std::istringstream& iss);
+    void        handleClientHeaderTimeout(std::istringstream& iss);
+    void        handleClientBodyTimeout(std::istringstream& iss);
+    void        handleSendTimeout(std::istringstream& iss);
+    void        handleOpenFileCache(std::istringstream& iss);
+    void        handleOpenFileCacheValid(std::istringstream& iss);
+    void        handleResponseCacheMaxFile(std::istringstream& iss);
+    void        handleResponseCacheSize(std::istringstream& iss);
+    void        handleFastcgiKeepalive(std::istringstream& iss);
+    void        handleCgiWorkers(std::istringstream& iss);
+    void        handleCgiWorkerRequests(std::istringstream& iss);
+    void        handleWorkerProcesses(std::istringstream& iss);
+    void        handleAcceptBatch(std::istringstream& iss);
+    void        handleReactorThreads(std::istringstream& iss);
+    void        handleReactorBalance(std::istringstream& iss);
+    void        handleLogFile(std::istringstream& iss);
+    void        handleLogBuffer(std::istringstream& iss);
+    void        handleLogOverflow(std::istringstream& iss);
+    void        handleAccessLog(std::istringstream& iss);
+    void        handleTraceRing(std::istringstream& iss);
 
     static Listen      parseListen(const std::string& value);
     static std::size_t parseClientMaxBodySize(const std::string& value);
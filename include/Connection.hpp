@@ -0,0 +1,161 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Connection.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:40:12 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:40:12 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CONNECTION_HPP
+#define CONNECTION_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <stdint.h>     // For uint64_t
+#include <sys/types.h>  // For off_t
+
+#include <cstddef>  // For std::size_t
+#include <ctime>    // For time_t
+#include <deque>    // For std::deque
+#include <string>   // For std::string
+
+#include "AccessLog.hpp"
+#include "CgiResponse.hpp"
+#include "HttpRequest.hpp"
+#include "TimerWheel.hpp"
+#include "Trace.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+class CgiProcess;        // Forward declaration
+class FastCgiRequest;    // Forward declaration
+class UploadManager;     // Forward declaration
+struct FastCgiUpstream;  // Forward declaration
+
+// A response waiting to be sent: its serialized head, the body taken over from the HttpResponse
+// (swapped, never copied) and an optional file range that follows them on the wire.
+struct QueuedResponse {
+    std::string head;
+    std::string body;
+    std::size_t sent;           // Bytes of head and body already sent
+    int         fileFd;         // -1 unless a file body follows
+    off_t       fileOffset;     // Next file byte to send
+    std::size_t fileRemaining;
+
+    QueuedResponse() : sent(0), fileFd(-1), fileOffset(0), fileRemaining(0) {}
+
+    // In-memory bytes still to send; the file body is not counted
+    std::size_t unsent() const { return head.length() + body.length() - sent; }
+
+    // Drops body bytes already sent once they outweigh the rest, so a body that keeps growing
+    // while it is sent (relayed script output) holds only what the socket has not taken yet
+    void compact() {
+        if (sent <= head.length()) {
+            return;
+        }
+        std::size_t sentBody = sent - head.length();
+        if (sentBody >= body.length() - sentBody) {
+            body.erase(0, sentBody);
+            sent = head.length();
+        }
+    }
+};
+
+// One entry of the Monitor connection table. The event backend hands this pointer back with
+// every readiness event, so dispatching an event never has to search for its fd.
+//
+// Client connections advance through a small state machine, one read per readiness event:
+// STATE_READ_HEADERS feeds the read buffer to the incremental parser until the request head is
+// complete, then STATE_READ_BODY hands the announced Content-Length straight to its sink (the
+// request's own body, or a temp file for bodies over LARGE_FILE_THRESHOLD) before it is served.
+// Responses are queued in output and sent together as the socket accepts them; while part of
+// one is still queued the connection waits for writability instead of reading further requests.
+//
+// A request served by a CGI script leaves the client with a running CgiProcess: its stdin and
+// stdout pipes get table entries of their own that point at the same process, and the client
+// serves nothing else until the script's output has been relayed. A request for a FastCGI
+// upstream works the same way with a FastCgiRequest, carried by a pooled upstream connection
+// entry that outlives it.
+//
+// Closing an entry can close others along with it, such as a client's script pipes, whose events
+// may still be waiting in the batch being dispatched. Closed entries are therefore only marked,
+// skipped by the rest of the batch and freed once it is done.
+struct Connection {
+    enum Type {
+        CONNECTION_LISTENER,
+        CONNECTION_CLIENT,
+        CONNECTION_CGI_INPUT,   // Pipe to a CGI script's stdin
+        CONNECTION_CGI_OUTPUT,  // Pipe from a CGI script's stdout
+        CONNECTION_SIGNAL,      // Signal fd reporting exited CGI children
+        CONNECTION_FASTCGI,     // Pooled connection to a FastCGI upstream
+        CONNECTION_HANDOFF      // Wake pipe of a reactor's handoff queue
+    };
+
+    enum State { STATE_READ_HEADERS, STATE_READ_BODY, STATE_CONNECTING };
+
+    Type                       type;
+    State                      state;
+    int                        fd;
+    int                        port;        // Listen port the connection belongs to
+    std::string                readBuffer;  // Bytes not yet parsed: a partial head or pipelining
+    HttpRequest                request;     // Parser state of the request being received
+    UploadManager*             upload;      // Temp file sink, NULL for bodies kept in memory
+    CgiProcess*                cgi;         // Script serving the client, owned by the client entry
+    FastCgiRequest*            fastcgi;     // Upstream request serving the client, owned likewise
+    FastCgiUpstream*           upstream;    // Pool an upstream connection belongs to
+    std::deque<QueuedResponse> output;      // Responses the socket has not fully accepted yet
+    bool                       closeAfterWrite;  // Close once output drains instead of reading on
+    bool                       relayStarted;     // Head of a relayed script response is queued
+    bool                       relayChunked;     // Relayed body is sent with chunked encoding
+    CgiResponse                relay;            // Header block of the script being relayed
+    std::size_t                requestCount;     // Responses already sent on this connection
+    time_t                     lastActivity;     // Last time data was received or sent
+    time_t                     requestStarted;   // When the head of the current request began
+    TimerWheel::Node           timer;            // Deadline of whichever timeout applies now
+    uint64_t                   requestBegan;     // requestStarted in AccessLog::now() time
+    uint64_t                   scriptStarted;    // When the running script was started
+    std::size_t                bytesQueued;      // Output bytes ever queued: the stream offset
+    std::size_t                bytesSent;        // Output bytes the socket has accepted
+    AccessLog::Record          access;           // Request being served while a script runs
+    AccessLog::RecordQueue     accessPending;    // Responses queued but not completely sent
+    RequestTrace               trace;            // Steps of the request being received or served
+    bool                       closed;           // Closed, freed once the event batch is done
+
+    Connection(Type connectionType, int fdesc, int listenPort) :
+        type(connectionType),
+        state(STATE_READ_HEADERS),
+        fd(fdesc),
+        port(listenPort),
+        upload(NULL),
+        cgi(NULL),
+        fastcgi(NULL),
+        upstream(NULL),
+        closeAfterWrite(false),
+        relayStarted(false),
+        relayChunked(false),
+        requestCount(0),
+        lastActivity(time(NULL)),
+        requestStarted(lastActivity),
+        requestBegan(0),
+        scriptStarted(0),
+        bytesQueued(0),
+        bytesSent(0),
+        closed(false) {
+        timer.data = this;
+    }
+
+    bool hasPendingOutput() const { return !output.empty(); }
+
+    // Whether a CGI script or FastCGI upstream is still producing the client's response
+    bool hasScript() const { return cgi != NULL || fastcgi != NULL; }
+};
+
+#endif
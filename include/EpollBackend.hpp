@@ -0,0 +1,70 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EpollBackend.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:15:37 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:15:37 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef EPOLLBACKEND_HPP
+#define EPOLLBACKEND_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define EPOLL_MAX_EVENTS 256
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include "EventBackend.hpp"
+
+#ifdef WEBSERV_HAS_EPOLL
+
+#include <sys/epoll.h>  // For struct epoll_event
+
+#include <vector>  // For std::vector
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Linux epoll backend: only ready fds are returned, optionally edge-triggered (EPOLLET).
+// The registered pointer lives in epoll_data so events map straight back to their owner.
+class EpollBackend : public EventBackend {
+public:
+    explicit EpollBackend(bool edgeTriggered);
+    ~EpollBackend();
+
+    bool        isOpen() const;
+    bool        add(int fdesc, int interest, void* data);
+    bool        modify(int fdesc, int interest, void* data);
+    void        remove(int fdesc);
+    int         wait(EventList& ready, int timeoutMs);
+    const char* getName() const;
+    bool        isEdgeTriggered() const;
+
+private:
+    int                             m_EpollFd;
+    bool                            m_EdgeTriggered;
+    std::vector<struct epoll_event> m_Events;
+
+    EpollBackend(const EpollBackend& that);
+    EpollBackend& operator=(const EpollBackend& that);
+
+    bool control(int operation, int fdesc, int interest, void* data);
+};
+
+#endif
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
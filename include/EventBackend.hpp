@@ -0,0 +1,69 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EventBackend.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:12:40 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:12:40 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef EVENTBACKEND_HPP
+#define EVENTBACKEND_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#if defined(__linux__) && !defined(WEBSERV_NO_EPOLL)
+#define WEBSERV_HAS_EPOLL 1
+#endif
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <string>  // For std::string
+#include <vector>  // For std::vector
+
+#include "Logger.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Readiness notification interface used by Monitor. Each registered fd carries an opaque
+// pointer that is handed back untouched with its events, so dispatch needs no fd lookup.
+class EventBackend {
+public:
+    enum Interest { EVENT_READ = 1, EVENT_WRITE = 2 };
+
+    struct Event {
+        void* data;
+        bool  readable;
+        bool  writable;
+        bool  hangup;
+    };
+    typedef std::vector<Event> EventList;
+
+    virtual ~EventBackend();
+
+    virtual bool        add(int fdesc, int interest, void* data) = 0;
+    virtual bool        modify(int fdesc, int interest, void* data) = 0;
+    virtual void        remove(int fdesc) = 0;
+    virtual int         wait(EventList& ready, int timeoutMs) = 0;
+    virtual const char* getName() const = 0;
+    virtual bool        isEdgeTriggered() const = 0;
+
+    // Returns NULL if the requested backend is unknown or cannot be initialised
+    static EventBackend* create(const std::string& name, bool edgeTriggered, const Logger& logger);
+    static const char*   getDefaultName();
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -0,0 +1,78 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FastCgi.hpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 12:31:07 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 12:31:07 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FASTCGI_HPP
+#define FASTCGI_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define FCGI_VERSION_1   1
+#define FCGI_HEADER_LEN  8
+#define FCGI_MAX_CONTENT 65535
+#define FCGI_RESPONDER   1
+#define FCGI_KEEP_CONN   1
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <cstddef>  // For std::size_t
+#include <string>   // For std::string
+#include <vector>   // For std::vector
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// FastCGI record framing (FastCGI 1.0 specification, responder role only). Records are
+// appended to, and parsed from, plain byte buffers so they can be queued on a connection and
+// sent with the rest of its output.
+class FastCgi {
+public:
+    enum RecordType {
+        BEGIN_REQUEST = 1,
+        ABORT_REQUEST = 2,
+        END_REQUEST = 3,
+        PARAMS = 4,
+        STDIN = 5,
+        STDOUT = 6,
+        STDERR = 7
+    };
+
+    struct Record {
+        int         type;
+        int         requestId;
+        std::string content;
+    };
+
+    static void appendBeginRequest(std::string& out, int requestId, bool keepConnection);
+    static void appendParams(std::string& out, int requestId,
+                             const std::vector<std::string>& environment);
+    static void appendStream(std::string& out, int type, int requestId, const char* data,
+                             std::size_t length);
+    static bool parseRecord(const std::string& buffer, std::size_t& offset, Record& record);
+    static int  getAppStatus(const Record& endRequest);
+
+private:
+    FastCgi();
+
+    static void appendHeader(std::string& out, int type, int requestId, std::size_t length);
+    static void appendLength(std::string& out, std::size_t length);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -0,0 +1,75 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FastCgiRequest.hpp                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 12:58:40 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 12:58:40 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FASTCGIREQUEST_HPP
+#define FASTCGIREQUEST_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define FASTCGI_REQUEST_ID  1      // Upstream connections carry one request at a time
+#define FASTCGI_STDIN_CHUNK 65536  // Temp file bytes encoded per STDIN refill
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <string>  // For std::string
+#include <vector>  // For std::vector
+
+#include "HttpRequest.hpp"
+#include "Logger.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// One request for a FastCGI upstream. prepare() encodes the begin record, the parameters and an
+// in-memory body up front; a body streamed to a temp file is opened there and encoded in chunks
+// as the upstream connection drains, so it is never held in memory whole. The Monitor assigns
+// the request to a pooled upstream connection and relays the STDOUT records it gets back.
+class FastCgiRequest {
+public:
+    FastCgiRequest(const Logger& logger, const std::string& upstream);
+    ~FastCgiRequest();
+
+    bool prepare(const std::vector<std::string>& params, const HttpRequest& request);
+    bool takeInput(std::string& out);
+    bool hasPendingInput() const;
+
+    const std::string& getUpstream() const;
+    int                getClientFd() const;
+    void               setClientFd(int fdesc);
+    int                getUpstreamFd() const;
+    void               setUpstreamFd(int fdesc);
+    bool               isOutputPaused() const;
+    void               setOutputPaused(bool paused);
+
+private:
+    Logger      m_Logger;
+    std::string m_Upstream;    // fastcgi_pass address, also the pool key
+    std::string m_Records;     // Encoded records not yet handed to the connection
+    int         m_BodyFd;      // Temp file body still to be encoded, -1 if none
+    int         m_ClientFd;
+    int         m_UpstreamFd;  // -1 while waiting for a free upstream connection
+    bool        m_OutputPaused;
+
+    FastCgiRequest(const FastCgiRequest& that);
+    FastCgiRequest& operator=(const FastCgiRequest& that);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
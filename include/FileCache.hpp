@@ -0,0 +1,103 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FileCache.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:12:41 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:12:41 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FILECACHE_HPP
+#define FILECACHE_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <sys/stat.h>  // For struct stat
+
+#include <cstddef>  // For std::size_t
+#include <ctime>    // For time_t
+#include <list>     // For std::list
+#include <map>      // For std::map
+#include <string>   // For std::string
+
+#include "Logger.hpp"
+#include "Mutex.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Open fds and stat results of static files, keyed by resolved path. A hit younger than the
+// validity period costs no syscall; an older one is revalidated with a single stat() and
+// reopened only if the file was replaced or modified (inode, mtime or size changed). Entries are
+// evicted least recently used first once the cache holds maxEntries paths. With maxEntries 0
+// the cache is disabled: every lookup stats and opens the file afresh into a scratch entry that
+// the next lookup replaces.
+//
+// Regular files also get their entity header lines (Content-Type, Content-Length, ETag,
+// Last-Modified) serialized once, and files up to maxFileSize keep their whole content in
+// memory while the bodies fit in memoryBudget, so serving them needs neither a read nor any
+// header formatting. Bodies of the least recently used entries are dropped to make room.
+//
+// One cache may serve several reactor threads. Entries returned by lookup() are only valid while
+// the caller holds getMutex(); getInfo() copies the stat result out under the lock instead.
+class FileCache {
+public:
+    struct Entry {
+        struct stat info;
+        int         fd;  // Open read-only fd of a regular file, -1 when it cannot be read
+        time_t      validated;
+        std::string headers;  // Entity header lines of a readable regular file
+        std::string body;     // Whole content when materialized
+        bool        materialized;
+
+        std::list<std::string>::iterator lru;
+    };
+
+    FileCache(const Logger& logger, std::size_t maxEntries, std::size_t validSeconds,
+              std::size_t maxFileSize, std::size_t memoryBudget);
+    ~FileCache();
+
+    const Entry* lookup(const std::string& path);
+    bool         getInfo(const std::string& path, struct stat& result);
+    void         invalidate(const std::string& path);
+    void         clear();
+    std::size_t  size() const;
+    Mutex&       getMutex();
+
+private:
+    typedef std::map<std::string, Entry> EntryMap;
+
+    Logger                 m_Logger;
+    EntryMap               m_Entries;
+    std::list<std::string> m_Lru;  // Most recently used path first
+    std::size_t            m_MaxEntries;
+    std::size_t            m_ValidSeconds;
+    std::size_t            m_MaxFileSize;    // Largest file kept in memory
+    std::size_t            m_MemoryBudget;   // Bytes of file content kept in memory at most
+    std::size_t            m_MemoryUsed;
+    Entry                  m_Uncached;  // Last lookup while the cache is disabled
+    mutable Mutex          m_Mutex;
+
+    FileCache(const FileCache& that);
+    FileCache& operator=(const FileCache& that);
+
+    static bool        isSameFile(const struct stat& cached, const struct stat& current);
+    static std::string formatHeaders(const std::string& path, const struct stat& info);
+    void               load(const std::string& path, const struct stat& info, Entry& entry);
+    const Entry*       loadUncached(const std::string& path);
+    void               materialize(const std::string& path, Entry& entry);
+    void               dropBody(Entry& entry);
+    void               erase(EntryMap::iterator it);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -0,0 +1,74 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   HandoffQueue.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 18:20:37 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 18:20:37 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef HANDOFFQUEUE_HPP
+#define HANDOFFQUEUE_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define HANDOFF_QUEUE_SIZE 1024  // Accepted sockets waiting for one reactor at most
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <cstddef>  // For std::size_t
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Lock-free single-producer single-consumer ring that carries accepted client sockets from the
+// acceptor thread to one reactor thread. The producer only advances m_Tail and the consumer only
+// m_Head, so a push or pop is a pair of atomic loads and one release store.
+//
+// A pipe wakes the reactor from its event wait. The producer writes to it only when no wakeup
+// is already pending, so a busy acceptor costs the reactor at most one read per wait.
+class HandoffQueue {
+public:
+    struct Item {
+        int fd;
+        int port;  // Listen port the socket was accepted on
+    };
+
+    HandoffQueue();
+    ~HandoffQueue();
+
+    bool        init();
+    bool        push(int fdesc, int port);
+    bool        pop(Item& item);
+    void        wake();
+    void        drainWakeups();
+    void        close();
+    bool        isClosed() const;
+    std::size_t size() const;
+    int         getWakeFd() const;
+
+private:
+    Item        m_Items[HANDOFF_QUEUE_SIZE];
+    std::size_t m_Head;         // Next item to pop, written by the consumer
+    std::size_t m_Tail;         // Next free slot, written by the producer
+    int         m_WakePending;  // Set while a wakeup byte is unread
+    int         m_Closed;
+    int         m_WakeFds[2];   // Read end for the reactor, write end for the acceptor
+
+    HandoffQueue(const HandoffQueue& that);
+    HandoffQueue& operator=(const HandoffQueue& that);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
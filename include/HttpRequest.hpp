@@ -20,6 +20,7 @@
 #include <cstddef>  // For std::size_t
 #include <map>      // For std::map
 #include <string>   // For std::string
+#include <vector>   // For std::vector
 
 #include "Logger.hpp"
 
@@ -27,18 +28,28 @@
 /* |                             Class Section                              | */
 /* @------------------------------------------------------------------------@ */
 
+// Requests are parsed incrementally: feed() is handed the same growing buffer (the request must
+// start at its first byte) each time more data arrives and resumes where it stopped. The request
+// line and headers are recorded as offset/length spans into one private copy of the head, and
+// header values are only turned into strings when getHeader() asks for them. A caller that
+// streams the body itself switches to appendBody() once isHeaderComplete() is true.
 class HttpRequest {
 public:
+    enum ParseStatus { PARSE_INCOMPLETE, PARSE_COMPLETE, PARSE_ERROR };
+
     HttpRequest();
     HttpRequest(const Logger& logger);
     ~HttpRequest();
     HttpRequest(const HttpRequest& that);
     HttpRequest& operator=(const HttpRequest& that);
 
-    bool parse(const std::string& rawData);
-    bool isComplete() const;
-    bool isValid() const;
-    void clear();
+    ParseStatus feed(const char* data, std::size_t length);
+    ParseStatus appendBody(const char* data, std::size_t length);
+    bool        parse(const std::string& rawData);
+    bool        isHeaderComplete() const;
+    bool        isComplete() const;
+    bool        isValid() const;
+    void        clear();
 
     const std::string& getMethod() const;
     const std::string& getPath() const;
@@ -46,6 +57,10 @@ public:
     const std::string& getHeader(const std::string& key) const;
     const std::string& getBody() const;
     std::size_t        getContentLength() const;
+    std::size_t        getHeaderLength() const;
+    std::size_t        getBodyRemaining() const;
+    std::size_t        getRequestLength() const;
+    bool               isKeepAlive() const;
 
     // Large file upload support
     bool               hasLargeUpload() const;
@@ -54,23 +69,51 @@ public:
     std::string        readBodyFromTempFile() const;
 
 private:
-    Logger                             m_Logger;
-    std::string                        m_Method;
-    std::string                        m_Path;
-    std::string                        m_Version;
-    std::map<std::string, std::string> m_Headers;
-    std::string                        m_Body;
-    bool                               m_IsComplete;
-    bool                               m_IsValid;
-    std::string                        m_TempFilePath;
-
-    bool               parseRequestLine(const std::string& line);
-    bool               parseHeaders(const std::string& headerSection);
-    bool               parseBody(const std::string& rawData, std::size_t headerEnd);
+    struct Span {
+        std::size_t offset;
+        std::size_t length;
+
+        Span() : offset(0), length(0) {}
+        Span(std::size_t spanOffset, std::size_t spanLength) :
+            offset(spanOffset), length(spanLength) {}
+    };
+
+    struct HeaderSpan {
+        Span name;
+        Span value;
+
+        HeaderSpan(const Span& headerName, const Span& headerValue) :
+            name(headerName), value(headerValue) {}
+    };
+
+    enum ParseStage { STAGE_REQUEST_LINE, STAGE_HEADERS, STAGE_BODY, STAGE_DONE };
+
+    Logger                                     m_Logger;
+    ParseStage                                 m_Stage;
+    std::size_t                                m_ParseOffset;  // First byte not scanned yet
+    std::string                                m_Head;         // Request line and headers
+    std::vector<HeaderSpan>                    m_HeaderSpans;  // Spans into m_Head
+    mutable std::map<std::string, std::string> m_Headers;      // Values getHeader() built
+    std::string                                m_Method;
+    std::string                                m_Path;
+    std::string                                m_Version;
+    std::string                                m_Body;
+    std::size_t                                m_ContentLength;
+    std::size_t                                m_BodyReceived;  // Temp file bytes included
+    bool                                       m_IsComplete;
+    bool                                       m_IsValid;
+    std::string                                m_TempFilePath;
+
+    bool               parseRequestLine(const char* data, const Span& line);
+    void               parseHeaderLine(const char* data, const Span& line);
+    ParseStatus        parseBody(const char* data, std::size_t length);
+    const HeaderSpan*  findHeader(const std::string& lowerKey) const;
+    static Span        trimSpan(const char* data, const Span& span);
     static std::string toLowerCase(const std::string& str);
     static std::string trimWhitespace(const std::string& str);
     static bool        isValidMethod(const std::string& method);
     static bool        isValidVersion(const std::string& version);
+    static bool        hasToken(const std::string& list, const std::string& token);
 };
 
 /* @------------------------------------------------------------------------@ */
@@ -17,12 +17,21 @@
 /* |                            Include Section                             | */
 /* @------------------------------------------------------------------------@ */
 
+#include <sys/types.h>  // For off_t
+
 #include <cstddef>  // For std::size_t
+#include <ctime>    // For time_t
 #include <map>      // For std::map
 #include <string>   // For std::string
 
 #include "Logger.hpp"
 
+/* @------------------------------------------------------------------------@ */
+/* |                             Define Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#define FILE_BODY_THRESHOLD 65536  // Files from 64KB up are streamed from their fd
+
 /* @------------------------------------------------------------------------@ */
 /* |                             Class Section                              | */
 /* @------------------------------------------------------------------------@ */
@@ -43,8 +52,20 @@ public:
     void setHeader(const std::string& key, const std::string& value);
     void setBody(const std::string& body);
     void setBodyFromFile(const std::string& filePath);
+    void setBodyFromFile(const std::string& filePath, int fdesc, std::size_t length);
     void appendBody(const std::string& content);
 
+    // File bodies stay on disk: the response owns an open fd and the sender streams the range
+    // after the head (copies dup the fd, releaseFileBody hands it over to the caller)
+    bool        hasFileBody() const;
+    off_t       getFileOffset() const;
+    std::size_t getFileLength() const;
+    int         releaseFileBody();
+
+    // Pre-serialized entity header lines (Content-Type, Content-Length, ...) written verbatim
+    // after the other headers; set after the body, which they must describe
+    void setEntityHeaders(const std::string& headers);
+
     int                getStatusCode() const;
     const std::string& getStatusMessage() const;
     const std::string& getHeader(const std::string& key) const;
@@ -52,6 +73,8 @@ public:
     std::size_t        getContentLength() const;
 
     std::string toString() const;
+    void        serializeHead(std::string& head) const;
+    void        releaseBody(std::string& body);
     void        clear();
 
     // Static helper methods for common responses
@@ -61,18 +84,26 @@ public:
     static HttpResponse createBadRequest(const std::string& message = "");
     static HttpResponse createMethodNotAllowed(const std::string& message = "");
 
+    static std::string getContentType(const std::string& filePath);
+    static std::string formatHttpDate(time_t timestamp);
+
 private:
     Logger                             m_Logger;
     int                                m_StatusCode;
     std::string                        m_StatusMessage;
     std::map<std::string, std::string> m_Headers;
     std::string                        m_Body;
+    std::string                        m_EntityHeaders;
+    int                                m_FileFd;  // -1 unless the body is streamed from a file
+    off_t                              m_FileOffset;
+    std::size_t                        m_FileLength;
 
     static std::string getDefaultStatusMessage(int statusCode);
     static std::string getCurrentDateTime();
     static std::string toLowerCase(const std::string& str);
     void               setDefaultHeaders();
-    static std::string getContentType(const std::string& filePath);
+    void               openFileBody(const std::string& filePath);
+    void               closeFileBody();
 };
 
 /* @------------------------------------------------------------------------@ */
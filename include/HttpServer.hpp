@@ -31,6 +31,8 @@
 #define HTTP_URI_TOO_LONG          414
 #define HTTP_INTERNAL_ERROR        500
 #define HTTP_NOT_IMPLEMENTED       501
+#define HTTP_BAD_GATEWAY           502
+#define HTTP_SERVICE_UNAVAILABLE   503
 #define HTTP_VERSION_NOT_SUPPORTED 505
 #define CGI_BUFFER_SIZE            8192
 #define BYTES_PER_KB               1024
@@ -47,7 +49,10 @@
 
 #include <string>  // For std::string
 
+#include "CgiProcess.hpp"
 #include "Config.hpp"
+#include "FastCgiRequest.hpp"
+#include "FileCache.hpp"
 #include "HttpRequest.hpp"
 #include "HttpResponse.hpp"
 #include "Logger.hpp"
@@ -56,6 +61,17 @@
 /* |                             Class Section                              | */
 /* @------------------------------------------------------------------------@ */
 
+// Script a request started, handed to the caller that runs it. At most one of the two is set
+struct PendingScript {
+    CgiProcess*     cgi;
+    FastCgiRequest* fastcgi;
+
+    PendingScript() : cgi(NULL), fastcgi(NULL) {}
+};
+
+// Request handling shared by every event loop of the process. Nothing here depends on the
+// request being served before, so reactor threads use one HttpServer at once: scripts started
+// for a request are returned through PendingScript, and the file cache locks itself.
 class HttpServer {
 public:
     HttpServer(const Config& config, const Logger& logger);
@@ -64,6 +80,10 @@ public:
     HttpServer& operator=(const HttpServer& that);
 
     HttpResponse processRequest(const HttpRequest& request, int serverPort);
+    HttpResponse processRequest(const HttpRequest& request, int serverPort, PendingScript& script);
+    HttpResponse createErrorResponse(int statusCode, int serverPort);
+
+    static std::string findExecutable(const std::string& name);
 
     void setDocumentRoot(const std::string& root);
     void setDefaultIndex(const std::string& index);
@@ -81,21 +101,31 @@ public:
     std::string  testResolvePath(const std::string&      requestPath,
                                  const Config::Location& location) const;
     static std::string testJoinPath(const std::string& base, const std::string& path);
+    static const Config::Location* testFindMatchingLocation(const Config::Server& server,
+                                                            const std::string&    path);
+    static std::vector<std::string> testBuildCgiEnvironment(const HttpRequest& request,
+                                                            const std::string& filePath);
 
 private:
-    const Config&  m_Config;
-    mutable Logger m_Logger;
-    std::string    m_DocumentRoot;
-    std::string    m_DefaultIndex;
-
-    HttpResponse handleGET(const HttpRequest& request, const Config::Server& server);
-    HttpResponse handlePOST(const HttpRequest& request, const Config::Server& server);
+    const Config&   m_Config;
+    mutable Logger  m_Logger;
+    std::string     m_DocumentRoot;
+    std::string     m_DefaultIndex;
+    FileCache       m_FileCache;      // Static file metadata and open fds
+    unsigned int    m_UploadCounter;  // Last upload number handed out, updated atomically
+
+    HttpResponse handleGET(const HttpRequest& request, const Config::Server& server,
+                           PendingScript& script);
+    HttpResponse handlePOST(const HttpRequest& request, const Config::Server& server,
+                            PendingScript& script);
     HttpResponse handleDELETE(const HttpRequest& request, const Config::Server& server);
     HttpResponse handleHEAD(const HttpRequest& request, const Config::Server& server);
     HttpResponse handleCGI(const HttpRequest& request, const Config::Server& server,
-                           const std::string& filePath);
+                           const Config::Location* location, const std::string& filePath,
+                           PendingScript& script);
 
     HttpResponse serveStaticFile(const std::string& filePath, const Config::Server& server);
+    HttpResponse serveMetrics();
     HttpResponse generateDirectoryListing(const std::string&    dirPath,
                                           const std::string&    requestPath,
                                           const Config::Server& server);
@@ -107,6 +137,8 @@ private:
     static bool isMethodAllowed(const std::string& method, const Config::Location& location);
     static bool isPathSafe(const std::string& path);
     static bool isCGIFile(const std::string& filePath);
+    static std::vector<std::string> buildCgiEnvironment(const HttpRequest& request,
+                                                        const std::string& filePath);
     std::string resolvePath(const std::string& requestPath, const Config::Location& location) const;
     static std::string joinPath(const std::string& baseDir, const std::string& fileName);
 
@@ -124,6 +156,7 @@ private:
                                 std::size_t& fileSize);
     bool processRegularFileUpload(const HttpRequest& request, const std::string& filename,
                                   std::size_t& fileSize);
+    std::string claimUploadFilename(bool isLargeUpload);
 
     // Helper methods for HEAD request processing
     HttpResponse       validateHEADRequest(const HttpRequest& request, const Config::Server& server,
@@ -133,7 +166,6 @@ private:
                                                  const Config::Server& server, std::string& indexFile);
     std::string        constructHEADFilePath(const std::string& documentRoot,
                                              const std::string& requestPath, const std::string& indexFile);
-    static std::string determineContentTypeFromPath(const std::string& filePath);
 
     // Helper methods for directory listing generation
     bool collectDirectoryEntries(const std::string& dirPath, std::vector<std::string>& directories,
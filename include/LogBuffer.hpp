@@ -0,0 +1,88 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   LogBuffer.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 19:48:03 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 19:48:03 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef LOGBUFFER_HPP
+#define LOGBUFFER_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define LOG_FLUSH_MS    100    // Longest a logged line waits before it is written
+#define LOG_BATCH_BYTES 65536  // Lines gathered into one write to the sink at most
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <pthread.h>  // For pthread_t
+
+#include <cstddef>  // For std::size_t
+#include <ostream>  // For std::ostream
+#include <string>   // For std::string
+#include <vector>   // For std::vector
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Bounded lock-free queue of finished log lines, written to the sink by a thread of its own so
+// logging never costs the event loop a write. Any thread may push: each slot carries a sequence
+// number that tells producers and the flush thread whose turn it is, and a line is swapped into
+// its slot rather than copied.
+//
+// The flush thread wakes every LOG_FLUSH_MS, or as soon as the queue is half full, and writes
+// what it finds in batches. A full queue either blocks the producer until there is room or
+// drops the line; dropped lines are counted and reported in the log itself.
+class LogBuffer {
+public:
+    LogBuffer(std::ostream& sink, std::size_t capacity, bool blockWhenFull);
+    ~LogBuffer();
+
+    bool start();
+    void push(std::string& line);
+    void stop();
+
+private:
+    struct Slot {
+        std::size_t sequence;
+        std::string line;
+    };
+
+    std::ostream&     m_Sink;
+    std::vector<Slot> m_Slots;
+    std::size_t       m_Mask;
+    std::size_t       m_Tail;     // Next slot to claim, shared by producers
+    std::size_t       m_Head;     // Next slot to write, owned by the flush thread
+    std::size_t       m_Dropped;  // Lines dropped since the last report
+    bool              m_BlockWhenFull;
+    int               m_WakePending;
+    int               m_Stopping;
+    int               m_WakeFds[2];
+    pthread_t         m_Thread;
+    bool              m_Started;
+
+    bool        tryPush(std::string& line);
+    void        wake();
+    void        run();
+    bool        flush();
+    static void *runThread(void *buffer);
+
+    LogBuffer(const LogBuffer& that);
+    LogBuffer& operator=(const LogBuffer& that);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -13,6 +13,7 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <cstddef>  // For std::size_t
 #include <ostream>  // For std::ostream
 #include <sstream>  // For std::ostringstream
 #include <string>   // For std::string
@@ -50,6 +51,9 @@ public:
     LoggerStream warn();
     LoggerStream error();
 
+    bool        startAsync(std::size_t capacity, bool blockWhenFull);
+    static void stopAsync();
+
 private:
     std::ostream& m_Out;
     bool          m_EnableColour;
@@ -0,0 +1,79 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Master.hpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 17:02:11 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 17:02:11 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef MASTER_HPP
+#define MASTER_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define WORKER_INIT_FAILED   3  // Exit status of a worker that could not start its Monitor
+#define WORKER_RESPAWN_DELAY 1  // Seconds a worker must survive to be restarted at once
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <sys/types.h>  // For pid_t
+
+#include <csignal>  // For sig_atomic_t
+#include <ctime>    // For time_t
+#include <map>      // For std::map
+
+#include "Config.hpp"
+#include "Logger.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Supervisor of worker_processes workers. Each worker is a forked process running a Monitor of
+// its own on SO_REUSEPORT listen sockets, so the kernel balances connections between them and
+// nothing is shared once they have started. A worker that dies is replaced, after a short delay
+// if it died right after starting; one that cannot start at all stops the whole server.
+// SIGINT or SIGTERM stops the master along with its workers; SIGHUP and SIGUSR1 are passed on
+// to them.
+class Master {
+public:
+    Master(const Config& config, const Logger& logger);
+    ~Master();
+
+    int run();
+
+private:
+    Master();
+    Master(const Master& that);
+    Master& operator=(const Master& that);
+
+    const Config&           m_Config;
+    Logger                  m_Logger;
+    std::map<pid_t, time_t> m_Workers;  // Start time of each running worker
+
+    static volatile sig_atomic_t s_Stop;
+    static volatile sig_atomic_t s_Reopen;
+    static volatile sig_atomic_t s_Dump;
+
+    static void handleStop(int signum);
+    static void handleReopen(int signum);
+    static void handleDump(int signum);
+    bool        startWorker();
+    void        runWorker(pid_t masterPid);
+    void        signalWorkers(int signum);
+    void        stopWorkers();
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -0,0 +1,122 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Metrics.hpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 21:12:26 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 21:12:26 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define METRICS_CACHE_LINE    64
+#define HISTOGRAM_SUB_BUCKETS 4    // Buckets per power of two, so a bucket spans at most 25%
+#define HISTOGRAM_BUCKETS     100  // Up to 2^26 microseconds (67s); the last one takes the rest
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <stdint.h>     // For uint64_t
+#include <sys/types.h>  // For pid_t
+
+#include <cstddef>  // For std::size_t
+#include <string>   // For std::string
+
+#include "Config.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Server metrics, shown in Prometheus text format by locations with "metrics on".
+//
+// Every event loop (the only one, each reactor thread, each worker process) claims a Slot of
+// its own and is the only one to write it, so counting is a plain load and store with no lock
+// and no bus-locked instruction. Slots are cache-line aligned so two loops never write the same
+// line. They live in one shared mapping created before workers fork; a scrape served by any
+// loop adds all slots up. A slot outlives its owner, so totals survive worker restarts.
+//
+// Latencies go into log-linear histograms in the manner of HdrHistogram: values below
+// HISTOGRAM_SUB_BUCKETS microseconds get a bucket each, above that every power of two is split
+// into HISTOGRAM_SUB_BUCKETS buckets.
+class Metrics {
+public:
+    enum Counter {
+        REQUESTS_1XX,
+        REQUESTS_2XX,
+        REQUESTS_3XX,
+        REQUESTS_4XX,
+        REQUESTS_5XX,
+        BYTES_RECEIVED,
+        BYTES_SENT,
+        CGI_SPAWNS,
+        COUNTER_COUNT
+    };
+
+    enum Gauge { ACTIVE_CONNECTIONS, ACTIVE_UPLOADS, GAUGE_COUNT };
+
+    enum Phase {
+        PHASE_PARSE,   // First byte of the request until it is complete
+        PHASE_HANDLE,  // Complete request until its whole response is queued
+        PHASE_SEND,    // Queued response until the socket took its last byte
+        PHASE_COUNT
+    };
+
+    struct Histogram {
+        uint64_t buckets[HISTOGRAM_BUCKETS];
+        uint64_t sum;  // Microseconds
+        uint64_t count;
+    };
+
+    struct Slot {
+        pid_t     owner;  // Process of the loop writing the slot, 0 while free
+        uint64_t  counters[COUNTER_COUNT];
+        uint64_t  gauges[GAUGE_COUNT];  // Wrapping arithmetic: the sum over slots is exact
+        Histogram phases[PHASE_COUNT];
+
+        void add(Counter counter, uint64_t value) { increase(counters[counter], value); }
+        void adjust(Gauge gauge, int delta) {
+            increase(gauges[gauge], static_cast<uint64_t>(static_cast<int64_t>(delta)));
+        }
+        void countStatus(int status);
+        void record(Phase phase, uint64_t micros);
+
+    private:
+        // Single writer: readers only need to see whole values, never a locked update
+        static void increase(uint64_t& value, uint64_t delta) {
+            __atomic_store_n(&value, __atomic_load_n(&value, __ATOMIC_RELAXED) + delta,
+                             __ATOMIC_RELAXED);
+        }
+    } __attribute__((aligned(METRICS_CACHE_LINE)));
+
+    static bool  init(const Config& config);
+    static Slot* claimSlot();
+    static void  releaseSlot(Slot* slot);
+    static void  releaseSlots(pid_t owner);
+    static void  render(std::string& output);
+
+private:
+    static Slot*       s_Slots;
+    static std::size_t s_SlotCount;
+
+    static std::size_t getBucket(uint64_t micros);
+    static uint64_t    getBucketBound(std::size_t bucket);
+    static uint64_t    load(const uint64_t& value);
+
+    Metrics();
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -13,120 +13,226 @@
 #ifndef MONITOR_HPP
 #define MONITOR_HPP
 
-#define POLLFD_SIZE           10
-#define LISTEN_BACKLOG        10
+#define CONNECTION_TABLE_SIZE 64
+#define DEFER_ACCEPT_SECONDS  5  // Wait for a deferred connection's first data at most
 #define POLL_WAIT             30000
-#define BUFFER_SIZE           500
-#define CONTENT_LENGTH_HEADER 15
+#define CHILD_POLL_MS         1000  // Reaping interval for CGI children without a signal fd
+#define BUFFER_SIZE           16384
 #define DEFAULT_SERVER_PORT   8080
-#define POLL_TIMEOUT_MS       5000
+#define TIMEOUT_RECHECK       5  // Seconds until a client with no timeout running is checked again
+#define OUTPUT_BATCH          16  // Pipelined responses gathered into one writev()
+#define CGI_OUTPUT_LIMIT      65536  // Unsent CGI output that pauses reading from the script
+#define FASTCGI_QUEUE_LIMIT   256    // Requests waiting per upstream before 503 is returned
+#define ACCESS_LOG_CHECK_MS   1000   // Wakeup interval while access log records are buffered
 
 /* @------------------------------------------------------------------------@ */
 /* |                            Include Section                             | */
 /* @------------------------------------------------------------------------@ */
 
-#include <map>     // For std::map
-#include <vector>  // For std::vector
+#include <pthread.h>    // For pthread_t
+#include <sys/types.h>  // For pid_t
 
+#include <csignal>  // For sig_atomic_t
+#include <cstddef>  // For std::size_t
+#include <ctime>    // For time_t
+#include <deque>    // For std::deque
+#include <map>      // For std::map
+#include <string>   // For std::string
+#include <vector>   // For std::vector
+
+#include "AccessLog.hpp"
 #include "Config.hpp"
+#include "Connection.hpp"
+#include "EventBackend.hpp"
+#include "HandoffQueue.hpp"
 #include "HttpServer.hpp"
 #include "Logger.hpp"
-
-class UploadManager;  // Forward declaration
-class HttpResponse;   // Forward declaration
-class HttpRequest;    // Forward declaration
-
-struct UploadState {
-    UploadManager *manager;
-    std::size_t    totalReceived;
-    std::size_t    totalContentLength;
-    std::string    rawRequest;
-
-    // Constructor parameters are logically ordered and unlikely to be swapped
-    UploadState(UploadManager *mgr,
-                std::size_t    received,  // NOLINT(bugprone-easily-swappable-parameters)
-                std::size_t total, const std::string &request) :
-        manager(mgr), totalReceived(received), totalContentLength(total), rawRequest(request) {}
+#include "Metrics.hpp"
+#include "TimerWheel.hpp"
+
+class HttpResponse;  // Forward declaration
+class HttpRequest;   // Forward declaration
+
+// Pool of persistent connections to one fastcgi_pass address, or of pre-forked CGI workers (see
+// CgiWorker). Requests beyond limit busy connections wait in line for the next one to come free;
+// once FASTCGI_QUEUE_LIMIT are waiting, further ones are turned away.
+struct FastCgiUpstream {
+    std::string                  address;
+    std::size_t                  limit;        // fastcgi_keepalive, or cgi_workers for workers
+    std::size_t                  maxRequests;  // Requests before a connection is replaced, 0 never
+    std::vector<int>             idle;         // Connected fds with no request assigned
+    std::size_t                  open;         // Connections open or still connecting
+    std::map<int, pid_t>         workers;      // Worker process behind each fd of a worker pool
+    std::deque<FastCgiRequest *> waiting;      // Requests queued while every connection is busy
+
+    FastCgiUpstream() : limit(0), maxRequests(0), open(0) {}
 };
 
-/* @------------------------------------------------------------------------@ */
-/* |                             Class Section                              | */
-/* @------------------------------------------------------------------------@ */
+class Monitor;  // Forward declaration
+
+// A thread running a Monitor of its own over the clients the acceptor hands it through queue
+struct Reactor {
+    Monitor      *monitor;
+    HandoffQueue *queue;
+    pthread_t     thread;
+    bool          started;
 
-struct pollfd;
+    Reactor() : monitor(NULL), queue(NULL), thread(), started(false) {}
+};
 
+// Runs the event loop over listen sockets, clients and script pipes. With reactor_threads set,
+// the Monitor built by init() only accepts: each socket goes to one of the reactors, Monitors
+// with no listen socket that share its HttpServer and run the same loop on their own thread.
+// A client never changes thread once handed off, so nothing below HttpServer is shared.
 class Monitor {
 private:
-    Logger                       logger;
-    HttpServer                  *httpServer;
-    Config                       config;
-    std::vector<Config::Server>  servers;  // Store servers for HTTP processing
-    struct pollfd               *fds;
-    int                         *listenFds;
-    int                         *listenPorts;      // Track which port each listen fd is for
-    int                         *connectionPorts;  // Track which port each connection fd came from
-    int                          listenCount;
-    int                          fdCount;
-    int                          maxFd;
-    std::map<int, UploadState *> activeUploads;
+    Logger                        logger;
+    HttpServer                   *httpServer;
+    Config                        config;
+    std::vector<Config::Server>   servers;  // Store servers for HTTP processing
+    EventBackend                 *eventBackend;
+    EventBackend::EventList       readyEvents;
+    std::vector<Connection *>     connections;      // Connection table indexed by fd
+    std::size_t                   connectionCount;  // Registered fds, listeners included
+    std::size_t                   maxConnections;   // Table cap derived from RLIMIT_NOFILE
+    std::vector<Connection *>     closedConnections;  // Closed this batch, freed after it
+    int                          *listenFds;
+    int                          *listenPorts;  // Track which port each listen fd is for
+    int                           listenCount;
+    TimerWheel                    timers;  // Client timeouts
+    int                           childSignalFd;  // signalfd for SIGCHLD, -1 where unavailable
+    std::map<pid_t, CgiProcess *> cgiProcesses;   // Unreaped children; NULL once abandoned
+    std::map<std::string, FastCgiUpstream> fastCgiUpstreams;  // Keyed by fastcgi_pass address
+    HandoffQueue                 *handoff;      // Sockets from the acceptor, NULL unless a reactor
+    std::size_t                   clientCount;  // Open clients, read by the acceptor to balance
+    std::vector<Reactor>          reactors;     // Threads the acceptor hands its clients to
+    std::size_t                   nextReactor;  // Next round_robin pick
+    AccessLog                     accessLog;    // This loop's own buffer and fd of access_log
+    int                           reopenSeen;   // reopenRequests when the logs were last opened
+    Metrics::Slot                *metrics;      // This loop's counters, NULL when not collected
+    AccessLog::RecordQueue        traces;       // Last traceLimit requests served, oldest first
+    std::size_t                   traceLimit;   // 0 unless trace_ring is set in a TRACE=1 build
+    int                           dumpSeen;     // dumpRequests when the traces were last dumped
+
+    static volatile sig_atomic_t stopRequested;   // Set by SIGINT or SIGTERM
+    static int                   reopenRequests;  // SIGHUPs received, read by every loop
+    static int                   dumpRequests;    // SIGUSR1s received, read likewise
 
     enum InitResult { INIT_SUCCESS, INIT_MEMORY_ERROR, INIT_LISTEN_ERROR };
 
     enum ExecResult { EXEC_SUCCESS, EXEC_CONNECTION_ERROR, EXEC_FATAL_ERROR };
 
-    void       addPollFd(int fdesc);
-    void       addPollFd(int fdesc, int port);
-    void       closePollFd(int fdesc);
-    void       cleanPollFds();
-    int        isPollFd(int fdesc) const;
-    int        isListenFd(int fdesc) const;
-    int        getPortForFd(int fdesc) const;
-    int        getPortForConnection(int fdesc) const;
-    InitResult initData(std::vector<Config::Server> servers);
-    static int initListenFd(struct sockaddr_in &address);
-    int        eventInit(int ready);
-    int        eventExec(int fdesc, int &ready);
-    ExecResult eventExecType(int fdesc, int &ready);
-    ExecResult eventExecConnection(int fdesc, int &ready);
-    ExecResult eventExecRequest(int fdesc, int &ready);
-    struct HeaderPosition {
-        std::size_t value;
-        explicit HeaderPosition(std::size_t pos) : value(pos) {}
-    };
-
-    struct ContentLength {
-        std::size_t value;
-        explicit ContentLength(std::size_t len) : value(len) {}
-    };
-
-    struct UploadInfo {
-        std::size_t headerEndPos;
-        std::size_t totalContentLength;
-
-        UploadInfo(const HeaderPosition &headerPos, const ContentLength &contentLen) :
-            headerEndPos(headerPos.value), totalContentLength(contentLen.value) {}
-    };
-
-    ExecResult handleLargeUpload(int fdesc, const std::string &rawRequest,
-                                 const UploadInfo &uploadInfo, int &ready);
-
-    // Helper methods to reduce cognitive complexity
-    std::string        readHttpRequest(int fdesc);
-    bool               processContentLength(const std::string &rawRequest, std::size_t headerEndPos,
-                                            std::size_t &totalContentLength, std::string &fullRequest, int fdesc);
-    ExecResult         processHttpRequest(int fdesc, const std::string &rawRequest, int &ready);
-    ExecResult         streamRemainingData(int fdesc, UploadManager &uploadManager,
-                                           std::size_t &totalReceived, std::size_t totalContentLength);
-    static std::size_t extractContentLength(const std::string &rawRequest,
-                                            std::size_t        contentLengthPos);
-    HttpResponse       generateHttpResponse(const HttpRequest &httpRequest, int fdesc);
-    static void        sendHttpResponse(int fdesc, const HttpResponse &httpResponse);
-
-    // Upload state management
-    UploadState *getUploadState(int fdesc);
-    void         addUploadState(int fdesc, UploadState *state);
-    void         removeUploadState(int fdesc);
-    ExecResult   continueUpload(int fdesc, int &ready);
+    enum ReadResult { READ_AGAIN, READ_PEER_CLOSED, READ_SINK_ERROR };
+
+    enum ServeResult { SERVE_NEED_INPUT, SERVE_FLUSH, SERVE_CLOSE };
+
+    enum FlushResult { FLUSH_DONE, FLUSH_PENDING, FLUSH_ERROR };
+
+    bool        addPollFd(int fdesc, int port, Connection::Type type,
+                          int interest = EventBackend::EVENT_READ);
+    void        closePollFd(int fdesc);
+    static void destroyConnection(Connection *connection);
+    void        freeClosedConnections();
+    void        cleanPollFds();
+    int         isPollFd(int fdesc) const;
+    int         getPortForConnection(int fdesc) const;
+    bool        isTrackingRequests() const;
+    void        adjustMetric(Metrics::Gauge gauge, int delta);
+    void        scheduleTimeout(Connection *connection);
+    time_t      getDeadline(const Connection *connection, const char *&name) const;
+    void        expireTimeouts();
+    void        initConnectionLimit();
+    void        initChildSignal();
+    bool        initAccessLog();
+    static void initSignalHandlers();
+    static void handleStop(int signum);
+    static void handleReopen(int signum);
+    static void handleDump(int signum);
+    bool        reopenLogs();
+    void        initTraceRing();
+    void        keepTrace(const AccessLog::Record &record);
+    bool        dumpTraces();
+    void        initCgiWorkers();
+    bool        initEventBackend();
+    InitResult  initData(std::vector<Config::Server> servers);
+    static int  initListenFd(struct sockaddr_in &address, const Config::Listen &options,
+                             bool reusePort);
+    int         eventInit(int ready);
+    int         eventExec(const EventBackend::Event &event, int &ready);
+    ExecResult  eventExecType(const EventBackend::Event &event, int &ready);
+    ExecResult  eventExecConnection(Connection *listener, int &ready);
+    static int  acceptClient(int listenFd);
+    ExecResult  eventExecRequest(Connection *connection, const EventBackend::Event &event,
+                                 int &ready);
+    ExecResult  eventExecWrite(Connection *connection, const EventBackend::Event &event,
+                               int &ready);
+
+    // Reactor threads the acceptor spreads accepted clients over
+    bool        initReactors();
+    Monitor    *createReactor(HandoffQueue *queue) const;
+    static void *runReactor(void *monitor);
+    void        handOff(int fdesc, int port);
+    ExecResult  eventExecHandoff(Connection *entry);
+    void        wakeReactors();
+    void        stopReactors();
+    std::size_t getClientCount() const;
+
+    // Per-connection request state machine
+    ReadResult         readConnection(Connection *connection);
+    ExecResult         processConnection(Connection *connection, int &ready);
+    ServeResult        serveBufferedRequests(Connection *connection, int &ready);
+    bool               beginRequestBody(Connection *connection);
+    bool               deliverBody(Connection *connection, const char *data, std::size_t length,
+                                   std::size_t &used);
+    bool               serveRequest(Connection *connection, int &ready);
+    HttpResponse       generateHttpResponse(const HttpRequest &httpRequest, int fdesc,
+                                            PendingScript &script);
+    static void        queueResponse(Connection *connection, HttpResponse &httpResponse);
+    static FlushResult flushConnection(Connection *connection);
+    static FlushResult flushFileBody(Connection *connection, QueuedResponse &response);
+    void               beginAccessRecord(Connection *connection);
+    static void        queueAccessRecord(Connection *connection, int status);
+    void               logSentResponses(Connection *connection, bool closing);
+    bool               keepConnectionAlive(Connection *connection, const HttpRequest &httpRequest,
+                                           HttpResponse &httpResponse) const;
+    void               setConnectionHeaders(const Connection *connection,
+                                            HttpResponse &httpResponse, bool keepAlive) const;
+
+    // Script output relayed to the client as it arrives, from CGI and FastCGI alike
+    void        relayOutput(Connection *client, const char *data, std::size_t length);
+    void        startRelay(Connection *client);
+    static void appendRelayBody(Connection *client, const char *data, std::size_t length);
+    void        sendRelayedOutput(Connection *client, bool wasPending);
+    static bool isRelayBacklogged(const Connection *client);
+    void        finishRelay(Connection *client, int failureStatus);
+
+    // CGI scripts running alongside the loop
+    bool startCgi(Connection *client, CgiProcess *process);
+    void releaseCgi(Connection *client);
+    void eventExecCgiInput(Connection *entry, const EventBackend::Event &event);
+    void eventExecCgiOutput(Connection *entry);
+    void eventExecChildSignal(Connection *entry);
+    void resumeCgiOutput(CgiProcess *process);
+    void finishCgi(CgiProcess *process);
+    void reapChildren();
+
+    // FastCGI upstreams and CGI worker pools reached over pooled connections
+    int              startFastCgi(Connection *client, FastCgiRequest *request);
+    void             releaseFastCgi(Connection *client);
+    FastCgiUpstream *getFastCgiUpstream(const std::string &address);
+    void             prestartFastCgi(FastCgiUpstream *upstream);
+    bool             attachFastCgi(FastCgiUpstream *upstream, FastCgiRequest *request);
+    void             dispatchFastCgi(FastCgiUpstream *upstream);
+    Connection      *openFastCgiConnection(FastCgiUpstream *upstream);
+    static int       connectUpstream(const std::string &address, bool &connecting);
+    void             forgetFastCgiConnection(Connection *entry);
+    void             eventExecFastCgi(Connection *entry, const EventBackend::Event &event);
+    bool             writeFastCgi(Connection *entry);
+    void             readFastCgi(Connection *entry, bool hangup);
+    bool             processFastCgiRecords(Connection *entry);
+    void             completeFastCgi(Connection *entry, int appStatus);
+    void             failFastCgi(Connection *entry);
+    void             resumeFastCgiOutput(FastCgiRequest *request);
 
 public:
     Monitor(const Logger &logger);
@@ -0,0 +1,60 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Mutex.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 17:48:03 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 17:48:03 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef MUTEX_HPP
+#define MUTEX_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <pthread.h>  // For pthread_mutex_t
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Plain pthread mutex for state shared by reactor threads. Uncontended locking costs no
+// syscall, so single-threaded servers pay next to nothing for it.
+class Mutex {
+public:
+    Mutex() { pthread_mutex_init(&m_Mutex, NULL); }
+    ~Mutex() { pthread_mutex_destroy(&m_Mutex); }
+
+    void lock() { pthread_mutex_lock(&m_Mutex); }
+    void unlock() { pthread_mutex_unlock(&m_Mutex); }
+
+private:
+    pthread_mutex_t m_Mutex;
+
+    Mutex(const Mutex& that);
+    Mutex& operator=(const Mutex& that);
+};
+
+// Holds a Mutex for the rest of the enclosing scope
+class MutexLock {
+public:
+    explicit MutexLock(Mutex& mutex) : m_Mutex(mutex) { m_Mutex.lock(); }
+    ~MutexLock() { m_Mutex.unlock(); }
+
+private:
+    Mutex& m_Mutex;
+
+    MutexLock(const MutexLock& that);
+    MutexLock& operator=(const MutexLock& that);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -0,0 +1,58 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   PollBackend.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:14:02 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:14:02 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef POLLBACKEND_HPP
+#define POLLBACKEND_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <poll.h>  // For struct pollfd
+
+#include <vector>  // For std::vector
+
+#include "EventBackend.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Portable fallback: poll() over a dense pollfd array, fd -> slot index, swap-and-pop removal
+class PollBackend : public EventBackend {
+public:
+    PollBackend();
+    ~PollBackend();
+
+    bool        add(int fdesc, int interest, void* data);
+    bool        modify(int fdesc, int interest, void* data);
+    void        remove(int fdesc);
+    int         wait(EventList& ready, int timeoutMs);
+    const char* getName() const;
+    bool        isEdgeTriggered() const;
+
+private:
+    std::vector<struct pollfd> m_PollSet;
+    std::vector<void*>         m_Data;   // Parallel to m_PollSet
+    std::vector<int>           m_Slots;  // Poll slot of each fd, -1 if not registered
+
+    PollBackend(const PollBackend& that);
+    PollBackend& operator=(const PollBackend& that);
+
+    static short toPollEvents(int interest);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
@@ -0,0 +1,84 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TimerWheel.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 19:05:12 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 19:05:12 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+#define TIMER_WHEEL_SLOTS 256  // One slot per second; later deadlines wrap around
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <ctime>  // For time_t
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Hashed timer wheel with one-second slots. Timers are nodes embedded in their owner and linked
+// into the slot of their deadline, so scheduling, rescheduling and cancelling are O(1) and the
+// wheel allocates nothing. A deadline more than TIMER_WHEEL_SLOTS seconds away shares a slot
+// with nearer ones and is simply passed over until its turn comes.
+//
+// advance() moves every timer that is due onto an expired list, which the owner drains with
+// popExpired(). A node unlinks itself when destroyed, so an owner deleted while others expire
+// just drops out of the list.
+class TimerWheel {
+public:
+    struct Node {
+        Node*  prev;
+        Node*  next;
+        time_t expires;
+        void*  data;  // Handed back untouched by popExpired()
+
+        Node() : prev(NULL), next(NULL), expires(0), data(NULL) {}
+        ~Node() { unlink(); }
+
+        bool isLinked() const { return next != NULL; }
+        void unlink();
+
+    private:
+        Node(const Node& that);
+        Node& operator=(const Node& that);
+    };
+
+    TimerWheel();
+    ~TimerWheel();
+
+    void  schedule(Node& node, time_t expires);
+    void  advance(time_t now);
+    Node* popExpired();
+    int   getWaitMs(time_t now, int maxMs) const;
+
+private:
+    Node   m_Slots[TIMER_WHEEL_SLOTS];  // List heads, never timers themselves
+    Node   m_Expired;
+    time_t m_Current;  // Last second advance() has processed
+
+    static void initHead(Node& head);
+    static void append(Node& head, Node& node);
+    static bool isEmpty(const Node& head);
+
+    TimerWheel(const TimerWheel& that);
+    TimerWheel& operator=(const TimerWheel& that);
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
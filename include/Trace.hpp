@@ -0,0 +1,88 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Trace.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 21:05:12 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 21:05:12 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Define Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// Trace points are only compiled in by "make TRACE=1"; otherwise they expand to nothing and
+// every trace stays empty
+#ifdef WEBSERV_TRACE
+#define TRACE_ENABLED             true
+#define TRACE_MARK(trace, point)  Trace::mark(trace, RequestTrace::point)
+#define TRACE_MARK_CURRENT(point) Trace::markCurrent(RequestTrace::point)
+#define TRACE_ENTER(trace)        Trace::enter(&(trace))
+#define TRACE_LEAVE()             Trace::enter(NULL)
+#define TRACE_RESTART(trace)      (trace).restart()
+#else
+#define TRACE_ENABLED             false
+#define TRACE_MARK(trace, point)  ((void)0)
+#define TRACE_MARK_CURRENT(point) ((void)0)
+#define TRACE_ENTER(trace)        ((void)0)
+#define TRACE_LEAVE()             ((void)0)
+#define TRACE_RESTART(trace)      ((void)0)
+#endif
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Include Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+#include <stdint.h>  // For uint64_t
+
+#include <ostream>  // For std::ostream
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Class Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// When one request reached each step on its way through the server, in AccessLog::now() time.
+// A step the request never reached stays 0
+struct RequestTrace {
+    enum Point {
+        ACCEPTED,          // The connection joined its event loop, shared by all its requests
+        FIRST_BYTE,        // First byte of the request head
+        HEADERS_PARSED,    // feed() completed the head, the body may still be on its way
+        LOCATION_MATCHED,  // Location block chosen
+        HANDLED,           // Handler returned the response, or started the script
+        SERIALIZED,        // serializeHead() filled the head into the output queue
+        LAST_BYTE,         // Socket took the last byte of the response
+        POINT_COUNT
+    };
+
+    uint64_t at[POINT_COUNT];
+
+    RequestTrace();
+
+    void restart();
+};
+
+// Records the trace points. The HttpServer does not know which connection it serves, so the
+// loop enters the trace of the request it hands over and the server marks the current one
+class Trace {
+public:
+    static void mark(RequestTrace& trace, RequestTrace::Point point);
+    static void enter(RequestTrace* trace);
+    static void markCurrent(RequestTrace::Point point);
+    static void write(std::ostream& out, const RequestTrace& trace, bool json);
+
+private:
+    Trace();
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Function Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+#endif
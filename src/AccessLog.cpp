@@ -0,0 +1,203 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   AccessLog.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 20:31:47 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 20:31:47 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "AccessLog.hpp"
+
+#include <fcntl.h>   // For open
+#include <stdint.h>  // For uint64_t
+#include <unistd.h>  // For write, close
+
+#include <cstddef>  // For std::size_t
+#include <ctime>    // For time, gmtime_r, strftime, clock_gettime
+#include <sstream>  // For std::ostringstream
+#include <string>   // For std::string
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+AccessLog::Record::Record() :
+    status(0),
+    started(0),
+    parsed(0),
+    queued(0),
+    upstreamTime(0),
+    hasUpstream(false),
+    requests(0),
+    begin(0),
+    end(0) {}
+
+AccessLog::AccessLog() :
+    m_Fd(-1),
+    m_Json(false),
+    m_BufferSize(0),
+    m_FlushInterval(0),
+    m_FirstPending(0),
+    m_TimeCached(0) {}
+
+AccessLog::~AccessLog() {
+    flush();
+    if (m_Fd >= 0) {
+        close(m_Fd);
+    }
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+bool AccessLog::open(const std::string& path, const std::string& format, std::size_t bufferSize,
+                     std::size_t flushInterval) {
+    m_Fd = openFile(path);
+    if (m_Fd < 0) {
+        return false;
+    }
+    m_Path = path;
+    m_Json = format == "json";
+    m_BufferSize = bufferSize;
+    m_FlushInterval = static_cast<time_t>(flushInterval);
+    m_Buffer.reserve(bufferSize);
+    return true;
+}
+
+bool AccessLog::isEnabled() const { return m_Fd >= 0; }
+
+bool AccessLog::hasPending() const { return !m_Buffer.empty(); }
+
+// Adds the record of a response of which bytesSent bytes reached the client
+void AccessLog::write(const Record& record, std::size_t bytesSent) {
+    const time_t       current = time(NULL);
+    const uint64_t     total = now() - record.started;
+    std::ostringstream line;
+
+    if (m_Buffer.empty()) {
+        m_FirstPending = current;
+    }
+    formatTime(current);
+    if (m_Json) {
+        line << "{\"time\":\"" << m_TimeString << "\",\"method\":\"" << escape(record.method)
+             << "\",\"path\":\"" << escape(record.path) << "\",\"status\":" << record.status
+             << ",\"bytes\":" << bytesSent << ",\"upstream_us\":";
+        if (record.hasUpstream) {
+            line << record.upstreamTime;
+        } else {
+            line << "null";
+        }
+        line << ",\"total_us\":" << total << ",\"requests\":" << record.requests;
+        if (TRACE_ENABLED) {
+            line << ",\"trace\":";
+            Trace::write(line, record.trace, true);
+        }
+        line << "}\n";
+    } else {
+        line << m_TimeString << " \"" << escape(record.method) << ' ' << escape(record.path)
+             << "\" " << record.status << ' ' << bytesSent << ' ';
+        if (record.hasUpstream) {
+            line << record.upstreamTime;
+        } else {
+            line << '-';
+        }
+        line << ' ' << total << ' ' << record.requests;
+        if (TRACE_ENABLED) {
+            line << ' ';
+            Trace::write(line, record.trace, false);
+        }
+        line << '\n';
+    }
+    m_Buffer += line.str();
+    if (m_Buffer.length() >= m_BufferSize) {
+        flush();
+    }
+}
+
+void AccessLog::flushIfDue(time_t now) {
+    if (!m_Buffer.empty() && now - m_FirstPending >= m_FlushInterval) {
+        flush();
+    }
+}
+
+// A failed write (a full disk) drops the batch rather than keeping it for a retry that would let
+// the buffer grow without bound
+void AccessLog::flush() {
+    if (m_Fd >= 0 && !m_Buffer.empty()) {
+        const ssize_t written = ::write(m_Fd, m_Buffer.data(), m_Buffer.length());
+        (void)written;
+    }
+    m_Buffer.clear();
+}
+
+// Keeps the old file when the path cannot be opened again
+bool AccessLog::reopen() {
+    if (m_Fd < 0) {
+        return true;
+    }
+    flush();
+    const int fdesc = openFile(m_Path);
+    if (fdesc < 0) {
+        return false;
+    }
+    close(m_Fd);
+    m_Fd = fdesc;
+    return true;
+}
+
+// Monotonic microseconds, so latencies survive changes to the wall clock
+uint64_t AccessLog::now() {
+    struct timespec current;
+    clock_gettime(CLOCK_MONOTONIC, &current);
+    return static_cast<uint64_t>(current.tv_sec) * 1000000 +
+           static_cast<uint64_t>(current.tv_nsec) / 1000;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Private Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+int AccessLog::openFile(const std::string& path) {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+
+// Formats the timestamp at most once per second
+void AccessLog::formatTime(time_t now) {
+    if (now == m_TimeCached && !m_TimeString.empty()) {
+        return;
+    }
+    struct tm parts;
+    char      formatted[32];
+    gmtime_r(&now, &parts);
+    strftime(formatted, sizeof(formatted), "%Y-%m-%dT%H:%M:%SZ", &parts);
+    m_TimeString = formatted;
+    m_TimeCached = now;
+}
+
+// Quotes, backslashes and control characters are escaped the same way in both formats, so a
+// crafted path can neither break a JSON string nor forge a line
+std::string AccessLog::escape(const std::string& value) {
+    std::string escaped;
+
+    escaped.reserve(value.length());
+    for (std::size_t i = 0; i < value.length(); i++) {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += static_cast<char>(c);
+        } else if (c < 0x20 || c == 0x7f) {
+            static const char hex[] = "0123456789abcdef";
+            escaped += "\\u00";
+            escaped += hex[c >> 4];
+            escaped += hex[c & 0xf];
+        } else {
+            escaped += static_cast<char>(c);
+        }
+    }
+    return escaped;
+}
@@ -0,0 +1,194 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CgiProcess.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 11:04:18 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 11:04:18 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "CgiProcess.hpp"
+
+#include <fcntl.h>     // For open, fcntl
+#include <signal.h>    // For kill, sigprocmask
+#include <sys/wait.h>  // For WIFEXITED, WEXITSTATUS
+#include <unistd.h>    // For fork, execve, pipe, pipe2, dup2, close
+
+#include <string>  // For std::string
+#include <vector>  // For std::vector
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+CgiProcess::CgiProcess(const Logger& logger) :
+    m_Logger(logger),
+    m_Pid(-1),
+    m_InputFd(-1),
+    m_OutputFd(-1),
+    m_InputOffset(0),
+    m_ExitStatus(0),
+    m_Exited(false),
+    m_ClientFd(-1),
+    m_OutputPaused(false) {}
+
+// Pipes still open here were never handed to the event loop
+CgiProcess::~CgiProcess() {
+    terminate();
+    if (m_InputFd >= 0) {
+        close(m_InputFd);
+    }
+    if (m_OutputFd >= 0) {
+        close(m_OutputFd);
+    }
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// Forks and execs argv with env. The argument and environment arrays are built before the fork
+// so the child only calls async-signal-safe functions. A body streamed to a temp file is opened
+// here, before the caller gets to delete the file, and becomes the child's stdin directly
+bool CgiProcess::start(const std::vector<std::string>& argv, const std::vector<std::string>& env,
+                       const HttpRequest& request) {
+    std::vector<char*> argvPointers;
+    std::vector<char*> envPointers;
+    for (std::size_t i = 0; i < argv.size(); i++) {
+        argvPointers.push_back(const_cast<char*>(argv[i].c_str()));
+    }
+    argvPointers.push_back(NULL);
+    for (std::size_t i = 0; i < env.size(); i++) {
+        envPointers.push_back(const_cast<char*>(env[i].c_str()));
+    }
+    envPointers.push_back(NULL);
+
+    int stdinPipe[2] = {-1, -1};
+    int stdoutPipe[2] = {-1, -1};
+    int bodyFd = -1;
+    if (request.hasLargeUpload()) {
+        bodyFd = open(request.getTempFilePath().c_str(), O_RDONLY);
+    } else {
+        m_Input = request.getBody();
+    }
+    if ((request.hasLargeUpload() && bodyFd < 0) || !makePipe(stdinPipe, 1) ||
+        !makePipe(stdoutPipe, 0)) {
+        m_Logger.error() << "Failed to create pipes for CGI";
+        int fds[] = {bodyFd, stdinPipe[0], stdinPipe[1], stdoutPipe[0], stdoutPipe[1]};
+        for (std::size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+            if (fds[i] >= 0) {
+                close(fds[i]);
+            }
+        }
+        return false;
+    }
+
+    m_Pid = fork();
+    if (m_Pid == 0) {
+        // The server's signal setup must not leak into the script
+        sigset_t noSignals;
+        sigemptyset(&noSignals);
+        sigprocmask(SIG_SETMASK, &noSignals, NULL);
+        signal(SIGPIPE, SIG_DFL);
+
+        dup2(bodyFd >= 0 ? bodyFd : stdinPipe[0], STDIN_FILENO);
+        dup2(stdoutPipe[1], STDOUT_FILENO);
+        dup2(stdoutPipe[1], STDERR_FILENO);
+        execve(argvPointers[0], &argvPointers[0], &envPointers[0]);
+        _exit(1);
+    }
+
+    close(stdinPipe[0]);
+    close(stdoutPipe[1]);
+    if (bodyFd >= 0) {
+        close(bodyFd);
+    }
+    m_InputFd = stdinPipe[1];
+    m_OutputFd = stdoutPipe[0];
+    if (m_Pid < 0) {
+        m_Logger.error() << "Failed to fork for CGI execution";
+        return false;
+    }
+    // Without a body the script sees end of file on stdin right away
+    if (!hasPendingInput()) {
+        close(m_InputFd);
+        m_InputFd = -1;
+    }
+    return true;
+}
+
+// Writes as much of the body as the pipe accepts; true once all of it has been written
+bool CgiProcess::writeInput() {
+    while (m_InputOffset < m_Input.length()) {
+        ssize_t written =
+            write(m_InputFd, m_Input.data() + m_InputOffset, m_Input.length() - m_InputOffset);
+        if (written <= 0) {
+            return false;
+        }
+        m_InputOffset += static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+// Kills a child that is still running; the loop reaps it like any other
+void CgiProcess::terminate() {
+    if (m_Pid > 0 && !m_Exited) {
+        kill(m_Pid, SIGKILL);
+    }
+}
+
+pid_t CgiProcess::getPid() const { return m_Pid; }
+
+int CgiProcess::getInputFd() const { return m_InputFd; }
+
+int CgiProcess::getOutputFd() const { return m_OutputFd; }
+
+// The event loop took over the fd and has closed it
+void CgiProcess::releaseInputFd() { m_InputFd = -1; }
+
+void CgiProcess::releaseOutputFd() { m_OutputFd = -1; }
+
+bool CgiProcess::hasPendingInput() const { return m_InputOffset < m_Input.length(); }
+
+void CgiProcess::setExitStatus(int status) {
+    m_ExitStatus = status;
+    m_Exited = true;
+}
+
+bool CgiProcess::hasExited() const { return m_Exited; }
+
+bool CgiProcess::succeeded() const {
+    return m_Exited && WIFEXITED(m_ExitStatus) && WEXITSTATUS(m_ExitStatus) == 0;
+}
+
+int CgiProcess::getClientFd() const { return m_ClientFd; }
+
+void CgiProcess::setClientFd(int fdesc) { m_ClientFd = fdesc; }
+
+bool CgiProcess::isOutputPaused() const { return m_OutputPaused; }
+
+void CgiProcess::setOutputPaused(bool paused) { m_OutputPaused = paused; }
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Private Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// The server's end is non-blocking; both ends are close-on-exec so no other CGI child inherits
+// them (an inherited stdin write end would keep the script from ever seeing end of file). With
+// reactor threads forking side by side, only pipe2() sets the flag before another fork can run
+bool CgiProcess::makePipe(int fds[2], int parentEnd) {
+#ifdef __linux__
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+#else
+    if (pipe(fds) < 0) {
+#endif
+        fds[0] = -1;
+        fds[1] = -1;
+        return false;
+    }
+    return fcntl(fds[parentEnd], F_SETFL, O_NONBLOCK) == 0 &&
+           fcntl(fds[0], F_SETFD, FD_CLOEXEC) == 0 && fcntl(fds[1], F_SETFD, FD_CLOEXEC) == 0;
+}
@@ -0,0 +1,214 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CgiResponse.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 16:12:40 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 16:12:40 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "CgiResponse.hpp"
+
+#include <cctype>   // For std::isdigit, std::tolower
+#include <cstddef>  // For std::size_t
+#include <cstdlib>  // For std::atoi
+#include <cstring>  // For std::strchr
+#include <string>   // For std::string
+
+#include "HttpResponse.hpp"
+#include "HttpServer.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+CgiResponse::CgiResponse() :
+    m_Status(0),
+    m_HasContentType(false),
+    m_HasLocation(false),
+    m_Complete(false) {}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// Returns true once the header block is complete; body bytes that came with it are then
+// available from takeBody()
+bool CgiResponse::parse(const char* data, std::size_t length) {
+    if (m_Complete) {
+        m_Body.append(data, length);
+        return true;
+    }
+    // The blank line may straddle two reads
+    const std::size_t searchFrom = m_Buffer.length() > 2 ? m_Buffer.length() - 2 : 0;
+    m_Buffer.append(data, length);
+    if (!startsWithHeader()) {
+        treatAsBody();
+        return true;
+    }
+
+    std::size_t end = m_Buffer.find("\n\n", searchFrom);
+    std::size_t crlfEnd = m_Buffer.find("\n\r\n", searchFrom);
+    std::size_t bodyStart = end + 2;
+    if (crlfEnd != std::string::npos && crlfEnd < end) {
+        end = crlfEnd;
+        bodyStart = crlfEnd + 3;
+    }
+    if (end == std::string::npos) {
+        if (m_Buffer.length() > CGI_HEADER_LIMIT) {
+            treatAsBody();
+        }
+        return m_Complete;
+    }
+    parseBlock(end);
+    m_Body.assign(m_Buffer, bodyStart, std::string::npos);
+    m_Buffer.clear();
+    m_Complete = true;
+    return true;
+}
+
+// Output ended before a blank line: a header block cut short still counts as headers
+void CgiResponse::finish() {
+    if (m_Complete) {
+        return;
+    }
+    if (m_Buffer.empty() || !startsWithHeader()) {
+        treatAsBody();
+        return;
+    }
+    parseBlock(m_Buffer.length());
+    m_Buffer.clear();
+    m_Complete = true;
+}
+
+// Sets the status line and entity headers of the response that carries the script's body. A
+// Location without a Status is a redirect; Content-Type falls back to text/html
+void CgiResponse::apply(HttpResponse& response) const {
+    int status = m_Status;
+    if (status == 0) {
+        status = m_HasLocation ? HTTP_FOUND : HTTP_OK;
+    }
+    if (m_Reason.empty()) {
+        response.setStatus(status);
+    } else {
+        response.setStatus(status, m_Reason);
+    }
+    if (m_HasContentType || m_HasLocation) {
+        response.setEntityHeaders(m_Headers);
+    } else {
+        response.setEntityHeaders("Content-Type: text/html\r\n" + m_Headers);
+    }
+}
+
+void CgiResponse::takeBody(std::string& body) {
+    body.clear();
+    body.swap(m_Body);
+}
+
+void CgiResponse::clear() {
+    m_Buffer.clear();
+    m_Body.clear();
+    m_Headers.clear();
+    m_Status = 0;
+    m_Reason.clear();
+    m_HasContentType = false;
+    m_HasLocation = false;
+    m_Complete = false;
+}
+
+bool CgiResponse::isComplete() const {
+    return m_Complete;
+}
+
+int CgiResponse::getStatus() const {
+    return m_Status;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Private Methods                            | */
+/* @------------------------------------------------------------------------@ */
+
+// Whether the buffered output opens with "name:", or may still turn out to once more arrives
+bool CgiResponse::startsWithHeader() const {
+    for (std::size_t i = 0; i < m_Buffer.length(); i++) {
+        const unsigned char c = static_cast<unsigned char>(m_Buffer[i]);
+        if (c == ':') {
+            return i > 0;
+        }
+        if (c <= ' ' || c >= 127 || std::strchr("\"(),/;<=>?@[\\]{}", c) != NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CgiResponse::parseBlock(std::size_t end) {
+    std::size_t start = 0;
+
+    while (start < end) {
+        std::size_t lineEnd = m_Buffer.find('\n', start);
+        if (lineEnd == std::string::npos || lineEnd > end) {
+            lineEnd = end;
+        }
+        std::size_t length = lineEnd - start;
+        if (length > 0 && m_Buffer[lineEnd - 1] == '\r') {
+            length--;
+        }
+        parseLine(m_Buffer.substr(start, length));
+        start = lineEnd + 1;
+    }
+}
+
+// Status is turned into the status line; framing and hop-by-hop headers are dropped because
+// the server decides how the body is delimited; the rest reaches the client unchanged
+void CgiResponse::parseLine(const std::string& line) {
+    std::size_t colon = line.find(':');
+    if (colon == std::string::npos || colon == 0) {
+        return;
+    }
+    std::string name = line.substr(0, colon);
+    for (std::size_t i = 0; i < name.length(); i++) {
+        name[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(name[i])));
+    }
+    std::size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+    std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+
+    if (name == "status") {
+        if (value.length() >= 3 && std::isdigit(static_cast<unsigned char>(value[0])) &&
+            std::isdigit(static_cast<unsigned char>(value[1])) &&
+            std::isdigit(static_cast<unsigned char>(value[2])) &&
+            (value.length() == 3 || value[3] == ' ')) {
+            int status = std::atoi(value.substr(0, 3).c_str());
+            if (status >= 100 && status <= 599) {
+                m_Status = status;
+                std::size_t reasonStart = value.find_first_not_of(' ', 3);
+                m_Reason = reasonStart == std::string::npos ? "" : value.substr(reasonStart);
+            }
+        }
+        return;
+    }
+    if (isDropped(name)) {
+        return;
+    }
+    if (name == "content-type") {
+        m_HasContentType = true;
+    } else if (name == "location") {
+        m_HasLocation = true;
+    }
+    m_Headers += line.substr(0, colon) + ": " + value + "\r\n";
+}
+
+// Output that is not a header block is handed back as body
+void CgiResponse::treatAsBody() {
+    m_Body.swap(m_Buffer);
+    m_Buffer.clear();
+    m_Complete = true;
+}
+
+bool CgiResponse::isDropped(const std::string& name) {
+    return name == "content-length" || name == "transfer-encoding" || name == "connection" ||
+           name == "keep-alive" || name == "date" || name == "server";
+}
@@ -0,0 +1,344 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   CgiWorker.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 14:22:05 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 14:22:05 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "CgiWorker.hpp"
+
+#include <fcntl.h>       // For open, fcntl
+#include <signal.h>      // For sigprocmask, signal
+#include <sys/socket.h>  // For socketpair
+#include <unistd.h>      // For fork, execve, dup2, close, access, environ
+
+#include <string>  // For std::string
+#include <vector>  // For std::vector
+
+#include "HttpServer.hpp"
+
+// Reactor threads fork side by side, so close-on-exec is best set by socketpair() itself
+#ifdef SOCK_CLOEXEC
+#define SOCKET_CLOEXEC SOCK_CLOEXEC
+#else
+#define SOCKET_CLOEXEC 0
+#endif
+
+// Worker loop for python3 -c. Scripts run through runpy with stdout and stderr wrapped into
+// STDOUT and STDERR records, so output streams out as it is written
+static const char* const PYTHON_BOOTSTRAP =
+    "import io, os, runpy, struct, sys, traceback\n"
+    "base = dict(os.environ)\n"
+    "def recv(n):\n"
+    "    data = b''\n"
+    "    while len(data) < n:\n"
+    "        chunk = os.read(0, n - len(data))\n"
+    "        if not chunk:\n"
+    "            os._exit(0)\n"
+    "        data += chunk\n"
+    "    return data\n"
+    "def send(kind, rid, data=b''):\n"
+    "    while True:\n"
+    "        chunk, data = data[:65535], data[65535:]\n"
+    "        pad = -len(chunk) % 8\n"
+    "        header = struct.pack('>BBHHBx', 1, kind, rid, len(chunk), pad)\n"
+    "        view = memoryview(header + chunk + bytes(pad))\n"
+    "        while view:\n"
+    "            view = view[os.write(0, view):]\n"
+    "        if not data:\n"
+    "            return\n"
+    "class Stream(io.RawIOBase):\n"
+    "    def __init__(self, kind, rid):\n"
+    "        self.kind, self.rid = kind, rid\n"
+    "    def writable(self):\n"
+    "        return True\n"
+    "    def write(self, data):\n"
+    "        if len(data):\n"
+    "            send(self.kind, self.rid, bytes(data))\n"
+    "        return len(data)\n"
+    "def params(data):\n"
+    "    env, i = {}, 0\n"
+    "    while i < len(data):\n"
+    "        sizes = []\n"
+    "        for _ in range(2):\n"
+    "            if data[i] & 0x80:\n"
+    "                sizes.append(struct.unpack('>I', data[i:i + 4])[0] & 0x7fffffff)\n"
+    "                i += 4\n"
+    "            else:\n"
+    "                sizes.append(data[i])\n"
+    "                i += 1\n"
+    "        name, value = data[i:i + sizes[0]], data[i + sizes[0]:i + sizes[0] + sizes[1]]\n"
+    "        env[name.decode('latin-1')] = value.decode('latin-1')\n"
+    "        i += sizes[0] + sizes[1]\n"
+    "    return env\n"
+    "while True:\n"
+    "    encoded, body = b'', []\n"
+    "    while True:\n"
+    "        kind, rid, length, pad = struct.unpack('>xBHHBx', recv(8))\n"
+    "        content = recv(length + pad)[:length]\n"
+    "        if kind == 4:\n"
+    "            encoded += content\n"
+    "        elif kind == 5:\n"
+    "            if not content:\n"
+    "                break\n"
+    "            body.append(content)\n"
+    "    env = params(encoded)\n"
+    "    script = env.get('SCRIPT_FILENAME', '')\n"
+    "    out = io.TextIOWrapper(io.BufferedWriter(Stream(6, rid)), encoding='utf-8')\n"
+    "    err = io.TextIOWrapper(io.BufferedWriter(Stream(7, rid)), encoding='utf-8')\n"
+    "    os.environ.clear()\n"
+    "    os.environ.update(base)\n"
+    "    os.environ.update(env)\n"
+    "    sys.stdin = io.TextIOWrapper(io.BytesIO(b''.join(body)), encoding='utf-8')\n"
+    "    sys.stdout, sys.stderr, sys.argv = out, err, [script]\n"
+    "    sys.path[0] = os.path.dirname(script)\n"
+    "    status = 0\n"
+    "    try:\n"
+    "        runpy.run_path(script, run_name='__main__')\n"
+    "    except SystemExit as exit:\n"
+    "        status = exit.code if isinstance(exit.code, int) else int(exit.code is not None)\n"
+    "    except BaseException:\n"
+    "        traceback.print_exc()\n"
+    "        status = 1\n"
+    "    for stream in (out, err):\n"
+    "        try:\n"
+    "            stream.flush()\n"
+    "        except Exception:\n"
+    "            pass\n"
+    "    sys.stdout, sys.stderr = sys.__stdout__, sys.__stderr__\n"
+    "    send(6, rid)\n"
+    "    send(3, rid, struct.pack('>IB3x', status & 0xffffffff, 0))\n";
+
+// Worker loop for perl -e. Scripts run through do FILE with STDOUT and STDERR tied to record
+// streams; exit is overridden to end only the script, not the worker. do FILE searches @INC
+// for bare relative paths, so those are anchored to the working directory first
+static const char* const PERL_BOOTSTRAP =
+    "BEGIN {\n"
+    "    *CORE::GLOBAL::exit = sub { die bless([defined $_[0] ? $_[0] : 0], 'Worker::Exit') };\n"
+    "}\n"
+    "package Worker::Stream;\n"
+    "sub TIEHANDLE {\n"
+    "    my ($class, $kind) = @_;\n"
+    "    return bless { kind => $kind, data => '' }, $class;\n"
+    "}\n"
+    "sub PRINT {\n"
+    "    my $self = shift;\n"
+    "    $self->{data} .= join(defined $, ? $, : '', @_) . (defined $\\ ? $\\ : '');\n"
+    "    $self->FLUSH() if length($self->{data}) >= 8192;\n"
+    "    return 1;\n"
+    "}\n"
+    "sub PRINTF {\n"
+    "    my $self = shift;\n"
+    "    my $format = shift;\n"
+    "    return $self->PRINT(sprintf($format, @_));\n"
+    "}\n"
+    "sub WRITE {\n"
+    "    my ($self, $buffer, $length, $offset) = @_;\n"
+    "    $self->PRINT(substr($buffer, $offset || 0, $length));\n"
+    "    return $length;\n"
+    "}\n"
+    "sub FLUSH {\n"
+    "    my $self = shift;\n"
+    "    main::send_record($self->{kind}, $self->{data}) if length $self->{data};\n"
+    "    $self->{data} = '';\n"
+    "}\n"
+    "sub BINMODE { return 1; }\n"
+    "sub FILENO { return -1; }\n"
+    "sub CLOSE { return 1; }\n"
+    "package main;\n"
+    "our $rid = 0;\n"
+    "my %base = %ENV;\n"
+    "open(SOCKET, '+<&=', 0) or CORE::exit(1);\n"
+    "binmode(SOCKET);\n"
+    "sub receive {\n"
+    "    my ($length) = @_;\n"
+    "    my $data = '';\n"
+    "    while (length($data) < $length) {\n"
+    "        my $read = sysread(SOCKET, $data, $length - length($data), length($data));\n"
+    "        CORE::exit(0) unless $read;\n"
+    "    }\n"
+    "    return $data;\n"
+    "}\n"
+    "sub send_record {\n"
+    "    my ($kind, $data) = @_;\n"
+    "    do {\n"
+    "        my $chunk = substr($data, 0, 65535, '');\n"
+    "        my $pad = (8 - length($chunk) % 8) % 8;\n"
+    "        my $record = pack('CCnnCx', 1, $kind, $rid, length($chunk), $pad);\n"
+    "        $record .= $chunk . (\"\\0\" x $pad);\n"
+    "        while (length $record) {\n"
+    "            my $written = syswrite(SOCKET, $record);\n"
+    "            CORE::exit(0) unless defined $written;\n"
+    "            substr($record, 0, $written, '');\n"
+    "        }\n"
+    "    } while (length $data);\n"
+    "}\n"
+    "sub decode {\n"
+    "    my ($data) = @_;\n"
+    "    my (%env, @sizes);\n"
+    "    my $i = 0;\n"
+    "    while ($i < length $data) {\n"
+    "        @sizes = ();\n"
+    "        for (1 .. 2) {\n"
+    "            my $byte = ord(substr($data, $i, 1));\n"
+    "            if ($byte & 0x80) {\n"
+    "                push @sizes, unpack('N', substr($data, $i, 4)) & 0x7fffffff;\n"
+    "                $i += 4;\n"
+    "            } else {\n"
+    "                push @sizes, $byte;\n"
+    "                $i += 1;\n"
+    "            }\n"
+    "        }\n"
+    "        $env{substr($data, $i, $sizes[0])} = substr($data, $i + $sizes[0], $sizes[1]);\n"
+    "        $i += $sizes[0] + $sizes[1];\n"
+    "    }\n"
+    "    return %env;\n"
+    "}\n"
+    "while (1) {\n"
+    "    my ($encoded, $body) = ('', '');\n"
+    "    while (1) {\n"
+    "        my (undef, $kind, $id, $length, $pad) = unpack('CCnnC', receive(8));\n"
+    "        my $content = substr(receive($length + $pad), 0, $length);\n"
+    "        $rid = $id;\n"
+    "        if ($kind == 4) {\n"
+    "            $encoded .= $content;\n"
+    "        } elsif ($kind == 5) {\n"
+    "            last unless length $content;\n"
+    "            $body .= $content;\n"
+    "        }\n"
+    "    }\n"
+    "    my %env = decode($encoded);\n"
+    "    my $script = defined $env{SCRIPT_FILENAME} ? $env{SCRIPT_FILENAME} : '';\n"
+    "    my $status = 0;\n"
+    "    %ENV = (%base, %env);\n"
+    "    @ARGV = ();\n"
+    "    local $0 = $script;\n"
+    "    close(STDIN);\n"
+    "    open(STDIN, '<', \\$body);\n"
+    "    my $out = tie *STDOUT, 'Worker::Stream', 6;\n"
+    "    my $err = tie *STDERR, 'Worker::Stream', 7;\n"
+    "    my $ok = eval {\n"
+    "        die \"Cannot read $script\\n\" unless -r $script;\n"
+    "        my $path = $script =~ m{^\\.{0,2}/} ? $script : \"./$script\";\n"
+    "        $! = 0;\n"
+    "        my $result = do $path;\n"
+    "        die $@ if $@;\n"
+    "        die \"Cannot run $script: $!\\n\" if !defined $result && $!;\n"
+    "        1;\n"
+    "    };\n"
+    "    unless ($ok) {\n"
+    "        if (ref $@ eq 'Worker::Exit') {\n"
+    "            $status = $@->[0];\n"
+    "        } else {\n"
+    "            print STDERR $@;\n"
+    "            $status = 1;\n"
+    "        }\n"
+    "    }\n"
+    "    $out->FLUSH();\n"
+    "    $err->FLUSH();\n"
+    "    undef $out;\n"
+    "    undef $err;\n"
+    "    untie *STDOUT;\n"
+    "    untie *STDERR;\n"
+    "    send_record(6, '');\n"
+    "    send_record(3, pack('NCx3', $status & 0xffffffff, 0));\n"
+    "}\n";
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// The pool serving filePath, or an empty string for scripts that are always forked
+std::string CgiWorker::getPoolAddress(const std::string& filePath) {
+    std::string::size_type dotPos = filePath.find_last_of('.');
+    if (dotPos == std::string::npos) {
+        return "";
+    }
+    std::string extension = filePath.substr(dotPos);
+    if (extension != ".py" && extension != ".pl") {
+        return "";
+    }
+    return CGI_WORKER_PREFIX + extension;
+}
+
+std::vector<std::string> CgiWorker::getPoolAddresses() {
+    std::vector<std::string> addresses;
+    addresses.push_back(CGI_WORKER_PREFIX ".py");
+    addresses.push_back(CGI_WORKER_PREFIX ".pl");
+    return addresses;
+}
+
+bool CgiWorker::isPoolAddress(const std::string& address) {
+    return address.compare(0, sizeof(CGI_WORKER_PREFIX) - 1, CGI_WORKER_PREFIX) == 0;
+}
+
+// Whether the pool's interpreter can be found on PATH
+bool CgiWorker::isAvailable(const std::string& address) {
+    std::string interpreter = getInterpreter(address);
+    return interpreter.find('/') != std::string::npos && access(interpreter.c_str(), X_OK) == 0;
+}
+
+// Starts a worker for the pool at address. Returns the server's end of its socketpair,
+// non-blocking and close-on-exec, or -1; the worker exits once that end is closed
+int CgiWorker::spawn(const std::string& address, pid_t& pid) {
+    const bool               python = address == CGI_WORKER_PREFIX ".py";
+    std::vector<std::string> argv;
+    argv.push_back(getInterpreter(address));
+    argv.push_back(python ? "-c" : "-e");
+    argv.push_back(python ? PYTHON_BOOTSTRAP : PERL_BOOTSTRAP);
+
+    std::vector<char*> argvPointers;
+    for (std::size_t i = 0; i < argv.size(); i++) {
+        argvPointers.push_back(const_cast<char*>(argv[i].c_str()));
+    }
+    argvPointers.push_back(NULL);
+
+    int fds[2] = {-1, -1};
+    int nullFd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (nullFd < 0 || socketpair(AF_UNIX, SOCK_STREAM | SOCKET_CLOEXEC, 0, fds) < 0 ||
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC) < 0 || fcntl(fds[1], F_SETFD, FD_CLOEXEC) < 0 ||
+        fcntl(fds[0], F_SETFL, O_NONBLOCK) < 0) {
+        int opened[] = {nullFd, fds[0], fds[1]};
+        for (std::size_t i = 0; i < sizeof(opened) / sizeof(opened[0]); i++) {
+            if (opened[i] >= 0) {
+                close(opened[i]);
+            }
+        }
+        return -1;
+    }
+
+    pid = fork();
+    if (pid == 0) {
+        // The server's signal setup must not leak into the worker
+        sigset_t noSignals;
+        sigemptyset(&noSignals);
+        sigprocmask(SIG_SETMASK, &noSignals, NULL);
+        signal(SIGPIPE, SIG_DFL);
+
+        // Records travel over stdin; stray writes to stdout must not reach the server's log
+        dup2(fds[1], STDIN_FILENO);
+        dup2(nullFd, STDOUT_FILENO);
+        execve(argvPointers[0], &argvPointers[0], environ);
+        _exit(1);
+    }
+    close(fds[1]);
+    close(nullFd);
+    if (pid < 0) {
+        close(fds[0]);
+        return -1;
+    }
+    return fds[0];
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Private Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+std::string CgiWorker::getInterpreter(const std::string& address) {
+    return HttpServer::findExecutable(address == CGI_WORKER_PREFIX ".py" ? "python3" : "perl");
+}
@@ -15,7 +15,9 @@
 #include <netinet/in.h>  // For INADDR_ANY, htonl, htons
 #include <stdint.h>      // For int types
 #include <sys/stat.h>    // For stat
+#include <unistd.h>      // For sysconf
 
+#include <climits>    // For INT_MAX
 #include <cstddef>    // For std::size_t
 #include <exception>  // For std::exception
 #include <fstream>    // For std::ifstream
@@ -42,6 +44,29 @@ static std::size_t stringToNumber(const std::string& str) {
 
 #define DECIMAL 10
 
+#define DEFAULT_KEEPALIVE_TIMEOUT       15
+#define DEFAULT_KEEPALIVE_REQUESTS      100
+#define DEFAULT_CLIENT_HEADER_TIMEOUT   60
+#define DEFAULT_CLIENT_BODY_TIMEOUT     60
+#define DEFAULT_SEND_TIMEOUT            60
+#define DEFAULT_OPEN_FILE_CACHE         1024
+#define DEFAULT_OPEN_FILE_CACHE_VALID   1
+#define DEFAULT_RESPONSE_CACHE_MAX_FILE 65536
+#define DEFAULT_RESPONSE_CACHE_SIZE     (16 * 1024 * 1024)
+#define DEFAULT_FASTCGI_KEEPALIVE       8
+#define DEFAULT_CGI_WORKERS             0
+#define DEFAULT_CGI_WORKER_REQUESTS     1000
+#define DEFAULT_WORKER_PROCESSES        1
+#define DEFAULT_ACCEPT_BATCH            64
+#define DEFAULT_LISTEN_BACKLOG          511
+#define DEFAULT_REACTOR_THREADS         0
+#define DEFAULT_REACTOR_BALANCE         "round_robin"
+#define DEFAULT_LOG_BUFFER              4096
+#define DEFAULT_ACCESS_LOG_FORMAT       "text"
+#define DEFAULT_ACCESS_LOG_BUFFER       65536
+#define DEFAULT_ACCESS_LOG_FLUSH        1
+#define DEFAULT_TRACE_RING              0
+
 #define MEGABYTE (int)(1024 * 1024)
 #define BYTE     256
 
@@ -52,18 +77,125 @@ static std::size_t stringToNumber(const std::string& str) {
 
 const std::string Config::defaultConfigFilename = "default.conf";
 
-Config::Config(const Logger& logger) : m_Logger(logger) {}
-
-Config::Config() : m_Logger(std::cout, true) {}
+Config::Listen::Listen(uint32_t address, uint16_t port) :
+    std::pair<uint32_t, uint16_t>(address, port),
+    backlog(DEFAULT_LISTEN_BACKLOG),
+    deferred(false) {}
+
+Config::Config(const Logger& logger) :
+    m_Logger(logger),
+    m_EdgeTriggered(false),
+    m_KeepaliveTimeout(DEFAULT_KEEPALIVE_TIMEOUT),
+    m_KeepaliveRequests(DEFAULT_KEEPALIVE_REQUESTS),
+    m_ClientHeaderTimeout(DEFAULT_CLIENT_HEADER_TIMEOUT),
+    m_ClientBodyTimeout(DEFAULT_CLIENT_BODY_TIMEOUT),
+    m_SendTimeout(DEFAULT_SEND_TIMEOUT),
+    m_OpenFileCache(DEFAULT_OPEN_FILE_CACHE),
+    m_OpenFileCacheValid(DEFAULT_OPEN_FILE_CACHE_VALID),
+    m_ResponseCacheMaxFile(DEFAULT_RESPONSE_CACHE_MAX_FILE),
+    m_ResponseCacheSize(DEFAULT_RESPONSE_CACHE_SIZE),
+    m_FastcgiKeepalive(DEFAULT_FASTCGI_KEEPALIVE),
+    m_CgiWorkers(DEFAULT_CGI_WORKERS),
+    m_CgiWorkerRequests(DEFAULT_CGI_WORKER_REQUESTS),
+    m_WorkerProcesses(DEFAULT_WORKER_PROCESSES),
+    m_AcceptBatch(DEFAULT_ACCEPT_BATCH),
+    m_ReactorThreads(DEFAULT_REACTOR_THREADS),
+    m_ReactorBalance(DEFAULT_REACTOR_BALANCE),
+    m_LogBuffer(DEFAULT_LOG_BUFFER),
+    m_LogOverflowBlocking(true),
+    m_AccessLogFormat(DEFAULT_ACCESS_LOG_FORMAT),
+    m_AccessLogBuffer(DEFAULT_ACCESS_LOG_BUFFER),
+    m_AccessLogFlush(DEFAULT_ACCESS_LOG_FLUSH),
+    m_TraceRing(DEFAULT_TRACE_RING) {}
+
+Config::Config() :
+    m_Logger(std::cout, true),
+    m_EdgeTriggered(false),
+    m_KeepaliveTimeout(DEFAULT_KEEPALIVE_TIMEOUT),
+    m_KeepaliveRequests(DEFAULT_KEEPALIVE_REQUESTS),
+    m_ClientHeaderTimeout(DEFAULT_CLIENT_HEADER_TIMEOUT),
+    m_ClientBodyTimeout(DEFAULT_CLIENT_BODY_TIMEOUT),
+    m_SendTimeout(DEFAULT_SEND_TIMEOUT),
+    m_OpenFileCache(DEFAULT_OPEN_FILE_CACHE),
+    m_OpenFileCacheValid(DEFAULT_OPEN_FILE_CACHE_VALID),
+    m_ResponseCacheMaxFile(DEFAULT_RESPONSE_CACHE_MAX_FILE),
+    m_ResponseCacheSize(DEFAULT_RESPONSE_CACHE_SIZE),
+    m_FastcgiKeepalive(DEFAULT_FASTCGI_KEEPALIVE),
+    m_CgiWorkers(DEFAULT_CGI_WORKERS),
+    m_CgiWorkerRequests(DEFAULT_CGI_WORKER_REQUESTS),
+    m_WorkerProcesses(DEFAULT_WORKER_PROCESSES),
+    m_AcceptBatch(DEFAULT_ACCEPT_BATCH),
+    m_ReactorThreads(DEFAULT_REACTOR_THREADS),
+    m_ReactorBalance(DEFAULT_REACTOR_BALANCE),
+    m_LogBuffer(DEFAULT_LOG_BUFFER),
+    m_LogOverflowBlocking(true),
+    m_AccessLogFormat(DEFAULT_ACCESS_LOG_FORMAT),
+    m_AccessLogBuffer(DEFAULT_ACCESS_LOG_BUFFER),
+    m_AccessLogFlush(DEFAULT_ACCESS_LOG_FLUSH),
+    m_TraceRing(DEFAULT_TRACE_RING) {}
 
 Config::~Config() {}
 
-Config::Config(const Config& that) : m_Logger(that.m_Logger), m_Servers(that.m_Servers) {}
+Config::Config(const Config& that) :
+    m_Logger(that.m_Logger),
+    m_Servers(that.m_Servers),
+    m_EventBackend(that.m_EventBackend),
+    m_EdgeTriggered(that.m_EdgeTriggered),
+    m_KeepaliveTimeout(that.m_KeepaliveTimeout),
+    m_KeepaliveRequests(that.m_KeepaliveRequests),
+    m_ClientHeaderTimeout(that.m_ClientHeaderTimeout),
+    m_ClientBodyTimeout(that.m_ClientBodyTimeout),
+    m_SendTimeout(that.m_SendTimeout),
+    m_OpenFileCache(that.m_OpenFileCache),
+    m_OpenFileCacheValid(that.m_OpenFileCacheValid),
+    m_ResponseCacheMaxFile(that.m_ResponseCacheMaxFile),
+    m_ResponseCacheSize(that.m_ResponseCacheSize),
+    m_FastcgiKeepalive(that.m_FastcgiKeepalive),
+    m_CgiWorkers(that.m_CgiWorkers),
+    m_CgiWorkerRequests(that.m_CgiWorkerRequests),
+    m_WorkerProcesses(that.m_WorkerProcesses),
+    m_AcceptBatch(that.m_AcceptBatch),
+    m_ReactorThreads(that.m_ReactorThreads),
+    m_ReactorBalance(that.m_ReactorBalance),
+    m_LogFile(that.m_LogFile),
+    m_LogBuffer(that.m_LogBuffer),
+    m_LogOverflowBlocking(that.m_LogOverflowBlocking),
+    m_AccessLog(that.m_AccessLog),
+    m_AccessLogFormat(that.m_AccessLogFormat),
+    m_AccessLogBuffer(that.m_AccessLogBuffer),
+    m_AccessLogFlush(that.m_AccessLogFlush),
+    m_TraceRing(that.m_TraceRing) {}
 
 Config& Config::operator=(const Config& that) {
     if (this != &that) {
         m_Logger = that.m_Logger;
         m_Servers = that.m_Servers;
+        m_EventBackend = that.m_EventBackend;
+        m_EdgeTriggered = that.m_EdgeTriggered;
+        m_KeepaliveTimeout = that.m_KeepaliveTimeout;
+        m_KeepaliveRequests = that.m_KeepaliveRequests;
+        m_ClientHeaderTimeout = that.m_ClientHeaderTimeout;
+        m_ClientBodyTimeout = that.m_ClientBodyTimeout;
+        m_SendTimeout = that.m_SendTimeout;
+        m_OpenFileCache = that.m_OpenFileCache;
+        m_OpenFileCacheValid = that.m_OpenFileCacheValid;
+        m_ResponseCacheMaxFile = that.m_ResponseCacheMaxFile;
+        m_ResponseCacheSize = that.m_ResponseCacheSize;
+        m_FastcgiKeepalive = that.m_FastcgiKeepalive;
+        m_CgiWorkers = that.m_CgiWorkers;
+        m_CgiWorkerRequests = that.m_CgiWorkerRequests;
+        m_WorkerProcesses = that.m_WorkerProcesses;
+        m_AcceptBatch = that.m_AcceptBatch;
+        m_ReactorThreads = that.m_ReactorThreads;
+        m_ReactorBalance = that.m_ReactorBalance;
+        m_LogFile = that.m_LogFile;
+        m_LogBuffer = that.m_LogBuffer;
+        m_LogOverflowBlocking = that.m_LogOverflowBlocking;
+        m_AccessLog = that.m_AccessLog;
+        m_AccessLogFormat = that.m_AccessLogFormat;
+        m_AccessLogBuffer = that.m_AccessLogBuffer;
+        m_AccessLogFlush = that.m_AccessLogFlush;
+        m_TraceRing = that.m_TraceRing;
     }
     return (*this);
 }
@@ -126,6 +258,13 @@ static std::string getValue(std::istringstream& iss) {
     return (value);
 }
 
+static std::size_t parseCount(const std::string& value) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+    return stringToNumber(value);
+}
+
 static std::vector<std::string> getValues(std::istringstream& iss) {
     std::vector<std::string> values;
     std::string              value;
@@ -165,8 +304,25 @@ void Config::handleClosedContext(Server& server, Location& currentLocation, bool
     }
 }
 
+// listen [address:]port [backlog=N] [deferred]
 void Config::handleListen(Server& server, std::istringstream& iss) {
-    server.listens.push_back(parseListen(getValue(iss)));
+    Listen      listen = parseListen(getValue(iss));
+    std::string option;
+
+    while (!(option = getValue(iss)).empty()) {
+        if (option.compare(0, 8, "backlog=") == 0) {
+            std::size_t backlog = parseCount(option.substr(8));
+            if (backlog == 0 || backlog > static_cast<std::size_t>(INT_MAX)) {
+                throw(std::exception());  // TODO(srvariable): InvalidValueException
+            }
+            listen.backlog = static_cast<int>(backlog);
+        } else if (option == "deferred") {
+            listen.deferred = true;
+        } else {
+            throw(std::exception());  // TODO(srvariable): InvalidListenException
+        }
+    }
+    server.listens.push_back(listen);
 }
 
 void Config::handleRoot(Server& server, Location& currentLocation, bool& inLocation,
@@ -224,6 +380,177 @@ void Config::handleClientMaxBodySize(Location& currentLocation, std::istringstre
     currentLocation.clientMaxBodySize = parseClientMaxBodySize(getValue(iss));
 }
 
+void Config::handleFastcgiPass(Location& currentLocation, std::istringstream& iss) {
+    currentLocation.fastcgiPass = getValue(iss);
+}
+
+void Config::handleMetrics(Location& currentLocation, std::istringstream& iss) {
+    std::string value = getValue(iss);
+    if (value == "on") {
+        currentLocation.metrics = true;
+    } else if (value == "off") {
+        currentLocation.metrics = false;
+    } else {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+}
+
+void Config::handleEventBackend(std::istringstream& iss) {
+    std::string value = getValue(iss);
+    if (value != "poll" && value != "epoll") {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+    m_EventBackend = value;
+}
+
+void Config::handleEdgeTriggered(std::istringstream& iss) {
+    std::string value = getValue(iss);
+    if (value == "on") {
+        m_EdgeTriggered = true;
+    } else if (value == "off") {
+        m_EdgeTriggered = false;
+    } else {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+}
+
+void Config::handleKeepaliveTimeout(std::istringstream& iss) {
+    m_KeepaliveTimeout = parseCount(getValue(iss));
+}
+
+void Config::handleKeepaliveRequests(std::istringstream& iss) {
+    m_KeepaliveRequests = parseCount(getValue(iss));
+}
+
+// A timeout of 0 disables it
+void Config::handleClientHeaderTimeout(std::istringstream& iss) {
+    m_ClientHeaderTimeout = parseCount(getValue(iss));
+}
+
+void Config::handleClientBodyTimeout(std::istringstream& iss) {
+    m_ClientBodyTimeout = parseCount(getValue(iss));
+}
+
+void Config::handleSendTimeout(std::istringstream& iss) {
+    m_SendTimeout = parseCount(getValue(iss));
+}
+
+void Config::handleOpenFileCache(std::istringstream& iss) {
+    m_OpenFileCache = parseCount(getValue(iss));
+}
+
+void Config::handleOpenFileCacheValid(std::istringstream& iss) {
+    m_OpenFileCacheValid = parseCount(getValue(iss));
+}
+
+// Sizes accept the same M suffix as client_max_body_size
+void Config::handleResponseCacheMaxFile(std::istringstream& iss) {
+    m_ResponseCacheMaxFile = parseClientMaxBodySize(getValue(iss));
+}
+
+void Config::handleResponseCacheSize(std::istringstream& iss) {
+    m_ResponseCacheSize = parseClientMaxBodySize(getValue(iss));
+}
+
+// At least one connection is needed to reach an upstream at all
+void Config::handleFastcgiKeepalive(std::istringstream& iss) {
+    m_FastcgiKeepalive = parseCount(getValue(iss));
+    if (m_FastcgiKeepalive == 0) {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+}
+
+void Config::handleCgiWorkers(std::istringstream& iss) {
+    m_CgiWorkers = parseCount(getValue(iss));
+}
+
+void Config::handleCgiWorkerRequests(std::istringstream& iss) {
+    m_CgiWorkerRequests = parseCount(getValue(iss));
+}
+
+// "auto" starts one worker per online CPU
+void Config::handleWorkerProcesses(std::istringstream& iss) {
+    std::string value = getValue(iss);
+    if (value == "auto") {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        m_WorkerProcesses = cpus > 0 ? static_cast<std::size_t>(cpus) : 1;
+        return;
+    }
+    m_WorkerProcesses = parseCount(value);
+    if (m_WorkerProcesses == 0) {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+}
+
+// "auto" starts one reactor per online CPU
+void Config::handleReactorThreads(std::istringstream& iss) {
+    std::string value = getValue(iss);
+    if (value == "auto") {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        m_ReactorThreads = cpus > 0 ? static_cast<std::size_t>(cpus) : 1;
+        return;
+    }
+    m_ReactorThreads = parseCount(value);
+}
+
+void Config::handleReactorBalance(std::istringstream& iss) {
+    m_ReactorBalance = getValue(iss);
+    if (m_ReactorBalance != "round_robin" && m_ReactorBalance != "least_loaded") {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+}
+
+// At least one connection has to be taken per wakeup or the listen socket would never drain
+void Config::handleAcceptBatch(std::istringstream& iss) {
+    m_AcceptBatch = parseCount(getValue(iss));
+    if (m_AcceptBatch == 0) {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+}
+
+void Config::handleLogFile(std::istringstream& iss) {
+    m_LogFile = getValue(iss);
+}
+
+void Config::handleLogBuffer(std::istringstream& iss) {
+    m_LogBuffer = parseCount(getValue(iss));
+}
+
+void Config::handleTraceRing(std::istringstream& iss) {
+    m_TraceRing = parseCount(getValue(iss));
+}
+
+// "drop" never stalls a loop on a slow log sink, "block" never loses a line
+void Config::handleLogOverflow(std::istringstream& iss) {
+    std::string value = getValue(iss);
+    if (value != "drop" && value != "block") {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+    m_LogOverflowBlocking = value == "block";
+}
+
+// access_log off | path [text|json] [buffer=size] [flush=seconds]
+void Config::handleAccessLog(std::istringstream& iss) {
+    std::string path = getValue(iss);
+    std::string option;
+
+    if (path.empty()) {
+        throw(std::exception());  // TODO(srvariable): InvalidValueException
+    }
+    m_AccessLog = path == "off" ? "" : path;
+    while (!(option = getValue(iss)).empty()) {
+        if (option == "text" || option == "json") {
+            m_AccessLogFormat = option;
+        } else if (option.compare(0, 7, "buffer=") == 0) {
+            m_AccessLogBuffer = parseClientMaxBodySize(option.substr(7));
+        } else if (option.compare(0, 6, "flush=") == 0) {
+            m_AccessLogFlush = parseCount(option.substr(6));
+        } else {
+            throw(std::exception());  // TODO(srvariable): InvalidValueException
+        }
+    }
+}
+
 // TODO(srvariable): Test with invalid configs
 void Config::parseLine(const std::string& line, Server& server, Location& currentLocation,
                        bool& inLocation) {
@@ -259,6 +586,56 @@ void Config::parseLine(const std::string& line, Server& server, Location& curren
         handleAllowMethods(currentLocation, iss);
     } else if (key == "client_max_body_size") {
         handleClientMaxBodySize(currentLocation, iss);
+    } else if (key == "fastcgi_pass") {
+        handleFastcgiPass(currentLocation, iss);
+    } else if (key == "metrics") {
+        handleMetrics(currentLocation, iss);
+    } else if (key == "event_backend") {
+        handleEventBackend(iss);
+    } else if (key == "edge_triggered") {
+        handleEdgeTriggered(iss);
+    } else if (key == "keepalive_timeout") {
+        handleKeepaliveTimeout(iss);
+    } else if (key == "keepalive_requests") {
+        handleKeepaliveRequests(iss);
+    } else if (key == "client_header_timeout") {
+        handleClientHeaderTimeout(iss);
+    } else if (key == "client_body_timeout") {
+        handleClientBodyTimeout(iss);
+    } else if (key == "send_timeout") {
+        handleSendTimeout(iss);
+    } else if (key == "open_file_cache") {
+        handleOpenFileCache(iss);
+    } else if (key == "open_file_cache_valid") {
+        handleOpenFileCacheValid(iss);
+    } else if (key == "response_cache_max_file") {
+        handleResponseCacheMaxFile(iss);
+    } else if (key == "response_cache_size") {
+        handleResponseCacheSize(iss);
+    } else if (key == "fastcgi_keepalive") {
+        handleFastcgiKeepalive(iss);
+    } else if (key == "cgi_workers") {
+        handleCgiWorkers(iss);
+    } else if (key == "cgi_worker_requests") {
+        handleCgiWorkerRequests(iss);
+    } else if (key == "worker_processes") {
+        handleWorkerProcesses(iss);
+    } else if (key == "accept_batch") {
+        handleAcceptBatch(iss);
+    } else if (key == "reactor_threads") {
+        handleReactorThreads(iss);
+    } else if (key == "reactor_balance") {
+        handleReactorBalance(iss);
+    } else if (key == "log_file") {
+        handleLogFile(iss);
+    } else if (key == "log_buffer") {
+        handleLogBuffer(iss);
+    } else if (key == "log_overflow") {
+        handleLogOverflow(iss);
+    } else if (key == "access_log") {
+        handleAccessLog(iss);
+    } else if (key == "trace_ring") {
+        handleTraceRing(iss);
     } else {
         m_Logger.warn() << "unknown context/directive: " << key;
     }
@@ -305,7 +682,7 @@ bool Config::load(const std::string& configFilename) {
     m_Logger.info() << "Parsing '" << configFilename << "'";
 
     Server      server;
-    Location    currentLocation;
+    Location    currentLocation = Location();  // Value-initialized: its flags start off
     bool        inLocation = false;
     std::string line;
     int         lineNumber = 0;
@@ -381,3 +758,68 @@ bool Config::load(const char* programName) {
 }
 
 const std::vector<Config::Server>& Config::getServers() const { return m_Servers; }
+
+const std::string& Config::getEventBackend() const { return m_EventBackend; }
+
+bool Config::isEdgeTriggered() const { return m_EdgeTriggered; }
+
+std::size_t Config::getKeepaliveTimeout() const { return m_KeepaliveTimeout; }
+
+std::size_t Config::getKeepaliveRequests() const { return m_KeepaliveRequests; }
+
+std::size_t Config::getClientHeaderTimeout() const { return m_ClientHeaderTimeout; }
+
+std::size_t Config::getClientBodyTimeout() const { return m_ClientBodyTimeout; }
+
+std::size_t Config::getSendTimeout() const { return m_SendTimeout; }
+
+std::size_t Config::getOpenFileCache() const { return m_OpenFileCache; }
+
+std::size_t Config::getOpenFileCacheValid() const { return m_OpenFileCacheValid; }
+
+std::size_t Config::getResponseCacheMaxFile() const { return m_ResponseCacheMaxFile; }
+
+std::size_t Config::getResponseCacheSize() const { return m_ResponseCacheSize; }
+
+std::size_t Config::getFastcgiKeepalive() const { return m_FastcgiKeepalive; }
+
+std::size_t Config::getCgiWorkers() const { return m_CgiWorkers; }
+
+std::size_t Config::getCgiWorkerRequests() const { return m_CgiWorkerRequests; }
+
+std::size_t Config::getWorkerProcesses() const { return m_WorkerProcesses; }
+
+std::size_t Config::getAcceptBatch() const { return m_AcceptBatch; }
+
+std::size_t Config::getReactorThreads() const { return m_ReactorThreads; }
+
+const std::string& Config::getReactorBalance() const { return m_ReactorBalance; }
+
+const std::string& Config::getLogFile() const { return m_LogFile; }
+
+std::size_t Config::getLogBuffer() const { return m_LogBuffer; }
+
+bool Config::isLogOverflowBlocking() const { return m_LogOverflowBlocking; }
+
+const std::string& Config::getAccessLog() const { return m_AccessLog; }
+
+const std::string& Config::getAccessLogFormat() const { return m_AccessLogFormat; }
+
+std::size_t Config::getAccessLogBuffer() const { return m_AccessLogBuffer; }
+
+std::size_t Config::getAccessLogFlush() const { return m_AccessLogFlush; }
+
+std::size_t Config::getTraceRing() const { return m_TraceRing; }
+
+// Metrics are only collected when some location can show them
+bool Config::hasMetricsLocation() const {
+    for (std::size_t i = 0; i < m_Servers.size(); i++) {
+        const std::vector<Location>& locations = m_Servers[i].locations;
+        for (std::size_t j = 0; j < locations.size(); j++) {
+            if (locations[j].metrics) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
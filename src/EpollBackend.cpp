@@ -0,0 +1,97 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EpollBackend.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:31:06 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:31:06 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "EpollBackend.hpp"
+
+#ifdef WEBSERV_HAS_EPOLL
+
+#include <sys/epoll.h>  // For epoll_create1, epoll_ctl, epoll_wait
+#include <unistd.h>     // For close
+
+#include <cstddef>  // For std::size_t
+#include <vector>   // For std::vector
+
+EpollBackend::EpollBackend(bool edgeTriggered) :
+    m_EpollFd(epoll_create1(EPOLL_CLOEXEC)), m_EdgeTriggered(edgeTriggered) {
+    m_Events.resize(EPOLL_MAX_EVENTS);
+}
+
+EpollBackend::~EpollBackend() {
+    if (m_EpollFd >= 0) {
+        close(m_EpollFd);
+    }
+}
+
+bool EpollBackend::isOpen() const { return m_EpollFd >= 0; }
+
+bool EpollBackend::add(int fdesc, int interest, void* data) {
+    return control(EPOLL_CTL_ADD, fdesc, interest, data);
+}
+
+bool EpollBackend::modify(int fdesc, int interest, void* data) {
+    return control(EPOLL_CTL_MOD, fdesc, interest, data);
+}
+
+void EpollBackend::remove(int fdesc) {
+    struct epoll_event unused;  // Kernels before 2.6.9 reject a NULL event pointer
+    unused.events = 0;
+    unused.data.ptr = NULL;
+    epoll_ctl(m_EpollFd, EPOLL_CTL_DEL, fdesc, &unused);
+}
+
+int EpollBackend::wait(EventList& ready, int timeoutMs) {
+    ready.clear();
+
+    int count = epoll_wait(m_EpollFd, &m_Events[0], static_cast<int>(m_Events.size()), timeoutMs);
+    if (count <= 0) {
+        return count;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const struct epoll_event& raw = m_Events[i];
+
+        Event event;
+        event.data = raw.data.ptr;
+        event.readable = (raw.events & (EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0;
+        event.writable = (raw.events & EPOLLOUT) != 0;
+        event.hangup = (raw.events & (EPOLLHUP | EPOLLERR)) != 0;
+        ready.push_back(event);
+    }
+
+    // A full batch means more fds are probably ready; grow so the next wakeup drains them
+    if (static_cast<std::size_t>(count) == m_Events.size()) {
+        m_Events.resize(m_Events.size() * 2);
+    }
+    return count;
+}
+
+const char* EpollBackend::getName() const { return "epoll"; }
+
+bool EpollBackend::isEdgeTriggered() const { return m_EdgeTriggered; }
+
+bool EpollBackend::control(int operation, int fdesc, int interest, void* data) {
+    struct epoll_event event;
+    event.events = EPOLLRDHUP;
+    if ((interest & EVENT_READ) != 0) {
+        event.events |= EPOLLIN;
+    }
+    if ((interest & EVENT_WRITE) != 0) {
+        event.events |= EPOLLOUT;
+    }
+    if (m_EdgeTriggered) {
+        event.events |= EPOLLET;
+    }
+    event.data.ptr = data;
+    return epoll_ctl(m_EpollFd, operation, fdesc, &event) == 0;
+}
+
+#endif
@@ -0,0 +1,60 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EventBackend.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:21:18 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:21:18 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "EventBackend.hpp"
+
+#include <cstddef>  // For NULL
+#include <string>   // For std::string
+
+#include "EpollBackend.hpp"
+#include "Logger.hpp"
+#include "PollBackend.hpp"
+
+EventBackend::~EventBackend() {}
+
+const char* EventBackend::getDefaultName() {
+#ifdef WEBSERV_HAS_EPOLL
+    return "epoll";
+#else
+    return "poll";
+#endif
+}
+
+EventBackend* EventBackend::create(const std::string& name, bool edgeTriggered,
+                                   const Logger& logger) {
+    Logger log(logger);
+
+    if (name == "poll") {
+        if (edgeTriggered) {
+            log.warn() << "edge_triggered is ignored by the poll backend";
+        }
+        return new PollBackend();
+    }
+
+    if (name == "epoll") {
+#ifdef WEBSERV_HAS_EPOLL
+        EpollBackend* backend = new EpollBackend(edgeTriggered);
+        if (!backend->isOpen()) {
+            log.error() << "epoll_create() failed";
+            delete backend;
+            return NULL;
+        }
+        return backend;
+#else
+        log.error() << "epoll backend is not available in this build";
+        return NULL;
+#endif
+    }
+
+    log.error() << "Unknown event backend: " << name;
+    return NULL;
+}
@@ -0,0 +1,123 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FastCgi.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 12:31:07 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 12:31:07 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "FastCgi.hpp"
+
+#include <cstddef>  // For std::size_t
+#include <string>   // For std::string
+#include <vector>   // For std::vector
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+void FastCgi::appendBeginRequest(std::string& out, int requestId, bool keepConnection) {
+    appendHeader(out, BEGIN_REQUEST, requestId, 8);
+    out += static_cast<char>(0);
+    out += static_cast<char>(FCGI_RESPONDER);
+    out += static_cast<char>(keepConnection ? FCGI_KEEP_CONN : 0);
+    out.append(5, '\0');
+}
+
+// Sends "NAME=value" entries as FastCGI name-value pairs, followed by the empty record that
+// ends the stream
+void FastCgi::appendParams(std::string& out, int requestId,
+                           const std::vector<std::string>& environment) {
+    std::string pairs;
+
+    for (std::size_t i = 0; i < environment.size(); i++) {
+        std::size_t separator = environment[i].find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        appendLength(pairs, separator);
+        appendLength(pairs, environment[i].length() - separator - 1);
+        pairs.append(environment[i], 0, separator);
+        pairs.append(environment[i], separator + 1, std::string::npos);
+    }
+    appendStream(out, PARAMS, requestId, pairs.data(), pairs.length());
+    appendStream(out, PARAMS, requestId, NULL, 0);
+}
+
+// Splits data into records of at most FCGI_MAX_CONTENT bytes. An empty length appends the
+// empty record that ends a stream
+void FastCgi::appendStream(std::string& out, int type, int requestId, const char* data,
+                           std::size_t length) {
+    if (length == 0) {
+        appendHeader(out, type, requestId, 0);
+        return;
+    }
+    for (std::size_t offset = 0; offset < length; offset += FCGI_MAX_CONTENT) {
+        std::size_t chunk = length - offset;
+        if (chunk > FCGI_MAX_CONTENT) {
+            chunk = FCGI_MAX_CONTENT;
+        }
+        appendHeader(out, type, requestId, chunk);
+        out.append(data + offset, chunk);
+    }
+}
+
+// Takes the record starting at offset if the buffer holds all of it, padding included, and
+// advances offset past it. Returns false when more bytes are needed
+bool FastCgi::parseRecord(const std::string& buffer, std::size_t& offset, Record& record) {
+    if (buffer.length() - offset < FCGI_HEADER_LEN) {
+        return false;
+    }
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(buffer.data() + offset);
+    std::size_t          contentLength = (static_cast<std::size_t>(header[4]) << 8) | header[5];
+    std::size_t          paddingLength = header[6];
+    if (buffer.length() - offset < FCGI_HEADER_LEN + contentLength + paddingLength) {
+        return false;
+    }
+    record.type = header[1];
+    record.requestId = (header[2] << 8) | header[3];
+    record.content.assign(buffer, offset + FCGI_HEADER_LEN, contentLength);
+    offset += FCGI_HEADER_LEN + contentLength + paddingLength;
+    return true;
+}
+
+// Exit status reported by the application in an END_REQUEST record
+int FastCgi::getAppStatus(const Record& endRequest) {
+    if (endRequest.content.length() < 4) {
+        return -1;
+    }
+    const unsigned char* body = reinterpret_cast<const unsigned char*>(endRequest.content.data());
+    return static_cast<int>((static_cast<unsigned int>(body[0]) << 24) | (body[1] << 16) |
+                            (body[2] << 8) | body[3]);
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Private Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+void FastCgi::appendHeader(std::string& out, int type, int requestId, std::size_t length) {
+    out += static_cast<char>(FCGI_VERSION_1);
+    out += static_cast<char>(type);
+    out += static_cast<char>((requestId >> 8) & 0xFF);
+    out += static_cast<char>(requestId & 0xFF);
+    out += static_cast<char>((length >> 8) & 0xFF);
+    out += static_cast<char>(length & 0xFF);
+    out += static_cast<char>(0);  // No padding
+    out += static_cast<char>(0);
+}
+
+// Name and value lengths take one byte below 128 and four bytes with the top bit set otherwise
+void FastCgi::appendLength(std::string& out, std::size_t length) {
+    if (length < 128) {
+        out += static_cast<char>(length);
+        return;
+    }
+    out += static_cast<char>(((length >> 24) & 0x7F) | 0x80);
+    out += static_cast<char>((length >> 16) & 0xFF);
+    out += static_cast<char>((length >> 8) & 0xFF);
+    out += static_cast<char>(length & 0xFF);
+}
@@ -0,0 +1,106 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FastCgiRequest.cpp                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 12:58:40 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 12:58:40 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "FastCgiRequest.hpp"
+
+#include <fcntl.h>   // For open
+#include <unistd.h>  // For read, close
+
+#include <string>  // For std::string
+#include <vector>  // For std::vector
+
+#include "FastCgi.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+FastCgiRequest::FastCgiRequest(const Logger& logger, const std::string& upstream) :
+    m_Logger(logger),
+    m_Upstream(upstream),
+    m_BodyFd(-1),
+    m_ClientFd(-1),
+    m_UpstreamFd(-1),
+    m_OutputPaused(false) {}
+
+FastCgiRequest::~FastCgiRequest() {
+    if (m_BodyFd >= 0) {
+        close(m_BodyFd);
+    }
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// The temp file is opened here, before the caller gets to delete it
+bool FastCgiRequest::prepare(const std::vector<std::string>& params, const HttpRequest& request) {
+    FastCgi::appendBeginRequest(m_Records, FASTCGI_REQUEST_ID, true);
+    FastCgi::appendParams(m_Records, FASTCGI_REQUEST_ID, params);
+    if (request.hasLargeUpload()) {
+        m_BodyFd = open(request.getTempFilePath().c_str(), O_RDONLY);
+        if (m_BodyFd < 0) {
+            m_Logger.error() << "Failed to open request body for FastCGI: "
+                             << request.getTempFilePath();
+            return false;
+        }
+        return true;
+    }
+    // An empty stream record would end stdin early, so an empty body sends only the final one
+    const std::string& body = request.getBody();
+    if (!body.empty()) {
+        FastCgi::appendStream(m_Records, FastCgi::STDIN, FASTCGI_REQUEST_ID, body.data(),
+                              body.length());
+    }
+    FastCgi::appendStream(m_Records, FastCgi::STDIN, FASTCGI_REQUEST_ID, NULL, 0);
+    return true;
+}
+
+// Moves the next encoded records into out, refilling from the temp file body when the
+// prepared ones are gone. Returns false once everything has been handed out
+bool FastCgiRequest::takeInput(std::string& out) {
+    if (m_Records.empty() && m_BodyFd >= 0) {
+        char    buffer[FASTCGI_STDIN_CHUNK];
+        ssize_t bytesRead = read(m_BodyFd, buffer, sizeof(buffer));
+        if (bytesRead > 0) {
+            FastCgi::appendStream(m_Records, FastCgi::STDIN, FASTCGI_REQUEST_ID, buffer,
+                                  static_cast<std::size_t>(bytesRead));
+        } else {
+            // End of file, or a failed read, ends the stdin stream
+            FastCgi::appendStream(m_Records, FastCgi::STDIN, FASTCGI_REQUEST_ID, NULL, 0);
+            close(m_BodyFd);
+            m_BodyFd = -1;
+        }
+    }
+    if (m_Records.empty()) {
+        return false;
+    }
+    out.swap(m_Records);
+    m_Records.clear();
+    return true;
+}
+
+bool FastCgiRequest::hasPendingInput() const { return !m_Records.empty() || m_BodyFd >= 0; }
+
+const std::string& FastCgiRequest::getUpstream() const { return m_Upstream; }
+
+int FastCgiRequest::getClientFd() const { return m_ClientFd; }
+
+void FastCgiRequest::setClientFd(int fdesc) { m_ClientFd = fdesc; }
+
+int FastCgiRequest::getUpstreamFd() const { return m_UpstreamFd; }
+
+void FastCgiRequest::setUpstreamFd(int fdesc) { m_UpstreamFd = fdesc; }
+
+bool FastCgiRequest::isOutputPaused() const { return m_OutputPaused; }
+
+void FastCgiRequest::setOutputPaused(bool paused) { m_OutputPaused = paused; }
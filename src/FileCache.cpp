@@ -0,0 +1,224 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FileCache.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:12:41 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:12:41 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "FileCache.hpp"
+
+#include <fcntl.h>   // For open
+#include <unistd.h>  // For close, pread
+
+#include <sstream>  // For std::ostringstream
+#include <string>   // For std::string
+
+#include "HttpResponse.hpp"
+#include "Mutex.hpp"
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+FileCache::FileCache(const Logger& logger, std::size_t maxEntries, std::size_t validSeconds,
+                     std::size_t maxFileSize, std::size_t memoryBudget) :
+    m_Logger(logger),
+    m_MaxEntries(maxEntries),
+    m_ValidSeconds(validSeconds),
+    m_MaxFileSize(maxFileSize),
+    m_MemoryBudget(memoryBudget),
+    m_MemoryUsed(0) {
+    m_Uncached.fd = -1;
+    m_Uncached.validated = 0;
+    m_Uncached.materialized = false;
+}
+
+FileCache::~FileCache() { clear(); }
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// Returns the cached stat result (and fd, for readable regular files) of path, or NULL when it
+// does not exist. The caller holds getMutex(), and the pointer stays valid until it lets go
+const FileCache::Entry* FileCache::lookup(const std::string& path) {
+    const time_t       now = time(NULL);
+    EntryMap::iterator it = m_Entries.find(path);
+    struct stat        current;
+
+    if (it != m_Entries.end()) {
+        Entry& entry = it->second;
+        if (static_cast<std::size_t>(now - entry.validated) < m_ValidSeconds) {
+            m_Lru.splice(m_Lru.begin(), m_Lru, entry.lru);
+            return &entry;
+        }
+        if (stat(path.c_str(), &current) == 0 && isSameFile(entry.info, current)) {
+            entry.validated = now;
+            m_Lru.splice(m_Lru.begin(), m_Lru, entry.lru);
+            return &entry;
+        }
+        erase(it);
+    } else if (m_MaxEntries == 0) {
+        return loadUncached(path);
+    }
+
+    if (stat(path.c_str(), &current) != 0) {
+        return NULL;
+    }
+    if (m_Entries.size() >= m_MaxEntries) {
+        erase(m_Entries.find(m_Lru.back()));
+    }
+
+    Entry& entry = m_Entries[path];
+    load(path, current, entry);
+    m_Lru.push_front(path);
+    entry.lru = m_Lru.begin();
+    if (entry.fd >= 0) {
+        materialize(path, entry);
+    }
+    return &entry;
+}
+
+// Stat result of path through the cache, for callers that need nothing else; false when it
+// does not exist
+bool FileCache::getInfo(const std::string& path, struct stat& result) {
+    MutexLock    lock(m_Mutex);
+    const Entry* entry = lookup(path);
+    if (entry == NULL) {
+        return false;
+    }
+    result = entry->info;
+    return true;
+}
+
+// Drops path so the next lookup sees the file system again; used after the server itself
+// modified or deleted the file
+void FileCache::invalidate(const std::string& path) {
+    MutexLock          lock(m_Mutex);
+    EntryMap::iterator it = m_Entries.find(path);
+    if (it != m_Entries.end()) {
+        erase(it);
+    }
+}
+
+void FileCache::clear() {
+    MutexLock lock(m_Mutex);
+    while (!m_Entries.empty()) {
+        erase(m_Entries.begin());
+    }
+    if (m_Uncached.fd >= 0) {
+        close(m_Uncached.fd);
+        m_Uncached.fd = -1;
+    }
+}
+
+std::size_t FileCache::size() const {
+    MutexLock lock(m_Mutex);
+    return m_Entries.size();
+}
+
+Mutex& FileCache::getMutex() { return m_Mutex; }
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Private Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+bool FileCache::isSameFile(const struct stat& cached, const struct stat& current) {
+    return cached.st_ino == current.st_ino && cached.st_dev == current.st_dev &&
+           cached.st_mtime == current.st_mtime && cached.st_size == current.st_size;
+}
+
+// Fills entry from a fresh stat result, opening regular files and formatting their headers
+void FileCache::load(const std::string& path, const struct stat& info, Entry& entry) {
+    entry.info = info;
+    // Cached fds must not leak into CGI children
+    entry.fd = S_ISREG(info.st_mode) ? open(path.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+    entry.validated = time(NULL);
+    entry.materialized = false;
+    entry.headers.clear();
+
+    if (S_ISREG(info.st_mode) && entry.fd < 0) {
+        m_Logger.warn() << "FileCache: cannot open " << path;
+    } else if (entry.fd >= 0) {
+        entry.headers = formatHeaders(path, info);
+    }
+}
+
+// Disabled cache: the previous scratch entry is released and path is stat'ed and opened again
+const FileCache::Entry* FileCache::loadUncached(const std::string& path) {
+    struct stat current;
+
+    if (m_Uncached.fd >= 0) {
+        close(m_Uncached.fd);
+        m_Uncached.fd = -1;
+    }
+    if (stat(path.c_str(), &current) != 0) {
+        return NULL;
+    }
+    load(path, current, m_Uncached);
+    return &m_Uncached;
+}
+
+// Content-Length and the validators come from the same stat() the entry is revalidated against,
+// so they change together with the file
+std::string FileCache::formatHeaders(const std::string& path, const struct stat& info) {
+    std::ostringstream headers;
+
+    headers << "Content-Type: " << HttpResponse::getContentType(path) << "\r\n"
+            << "Content-Length: " << info.st_size << "\r\n"
+            << "ETag: \"" << std::hex << info.st_mtime << "-" << info.st_size << std::dec
+            << "\"\r\n"
+            << "Last-Modified: " << HttpResponse::formatHttpDate(info.st_mtime) << "\r\n";
+    return headers.str();
+}
+
+void FileCache::materialize(const std::string& path, Entry& entry) {
+    const std::size_t size = static_cast<std::size_t>(entry.info.st_size);
+
+    if (size > m_MaxFileSize || size > m_MemoryBudget) {
+        return;
+    }
+    // Make room by dropping the bodies of the least recently used entries
+    std::list<std::string>::reverse_iterator victim = m_Lru.rbegin();
+    while (m_MemoryUsed + size > m_MemoryBudget && victim != m_Lru.rend()) {
+        dropBody(m_Entries[*victim]);
+        ++victim;
+    }
+
+    std::string content(size, '\0');
+    std::size_t total = 0;
+    while (total < size) {
+        ssize_t bytesRead = pread(entry.fd, &content[total], size - total,
+                                  static_cast<off_t>(total));
+        if (bytesRead <= 0) {
+            m_Logger.warn() << "FileCache: short read on " << path;
+            return;
+        }
+        total += static_cast<std::size_t>(bytesRead);
+    }
+    entry.body.swap(content);
+    entry.materialized = true;
+    m_MemoryUsed += size;
+}
+
+void FileCache::dropBody(Entry& entry) {
+    if (entry.materialized) {
+        m_MemoryUsed -= entry.body.length();
+        std::string().swap(entry.body);
+        entry.materialized = false;
+    }
+}
+
+void FileCache::erase(EntryMap::iterator it) {
+    dropBody(it->second);
+    if (it->second.fd >= 0) {
+        close(it->second.fd);
+    }
+    m_Lru.erase(it->second.lru);
+    m_Entries.erase(it);
+}
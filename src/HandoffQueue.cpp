@@ -0,0 +1,116 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   HandoffQueue.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 18:20:37 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 18:20:37 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "HandoffQueue.hpp"
+
+#include <fcntl.h>   // For fcntl
+#include <unistd.h>  // For pipe, read, write, close
+
+#include <cstddef>  // For std::size_t
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+HandoffQueue::HandoffQueue() : m_Head(0), m_Tail(0), m_WakePending(0), m_Closed(0) {
+    m_WakeFds[0] = -1;
+    m_WakeFds[1] = -1;
+}
+
+// Sockets still queued were never seen by a reactor and are closed here
+HandoffQueue::~HandoffQueue() {
+    Item item;
+    while (pop(item)) {
+        ::close(item.fd);
+    }
+    for (std::size_t i = 0; i < 2; i++) {
+        if (m_WakeFds[i] >= 0) {
+            ::close(m_WakeFds[i]);
+        }
+    }
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+bool HandoffQueue::init() {
+    if (pipe(m_WakeFds) < 0) {
+        return false;
+    }
+    for (std::size_t i = 0; i < 2; i++) {
+        if (fcntl(m_WakeFds[i], F_SETFL, O_NONBLOCK) < 0 ||
+            fcntl(m_WakeFds[i], F_SETFD, FD_CLOEXEC) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Producer side: false when the reactor already has HANDOFF_QUEUE_SIZE sockets waiting
+bool HandoffQueue::push(int fdesc, int port) {
+    const std::size_t tail = m_Tail;
+    const std::size_t head = __atomic_load_n(&m_Head, __ATOMIC_ACQUIRE);
+    if (tail - head == HANDOFF_QUEUE_SIZE) {
+        return false;
+    }
+    m_Items[tail % HANDOFF_QUEUE_SIZE].fd = fdesc;
+    m_Items[tail % HANDOFF_QUEUE_SIZE].port = port;
+    __atomic_store_n(&m_Tail, tail + 1, __ATOMIC_RELEASE);
+    wake();
+    return true;
+}
+
+// Consumer side
+bool HandoffQueue::pop(Item& item) {
+    const std::size_t head = m_Head;
+    if (head == __atomic_load_n(&m_Tail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    item = m_Items[head % HANDOFF_QUEUE_SIZE];
+    __atomic_store_n(&m_Head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Also used on its own to make the reactor look at state other than the queue
+void HandoffQueue::wake() {
+    const char byte = 0;
+    if (__atomic_exchange_n(&m_WakePending, 1, __ATOMIC_ACQ_REL) == 0) {
+        // A full pipe already guarantees a wakeup
+        if (write(m_WakeFds[1], &byte, 1) < 0) {
+            return;
+        }
+    }
+}
+
+// Consumer side, before popping: a push that follows writes a new wakeup
+void HandoffQueue::drainWakeups() {
+    char buffer[64];
+    __atomic_store_n(&m_WakePending, 0, __ATOMIC_SEQ_CST);
+    while (read(m_WakeFds[0], buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+// Tells the reactor to leave its loop
+void HandoffQueue::close() {
+    __atomic_store_n(&m_Closed, 1, __ATOMIC_RELEASE);
+    wake();
+}
+
+bool HandoffQueue::isClosed() const { return __atomic_load_n(&m_Closed, __ATOMIC_ACQUIRE) != 0; }
+
+// Sockets pushed but not yet popped, as seen by the producer
+std::size_t HandoffQueue::size() const {
+    return m_Tail - __atomic_load_n(&m_Head, __ATOMIC_ACQUIRE);
+}
+
+int HandoffQueue::getWakeFd() const { return m_WakeFds[0]; }
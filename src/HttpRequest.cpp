@@ -12,10 +12,13 @@
 
 #include "HttpRequest.hpp"
 
+#include <cstring>   // For std::memchr
 #include <fstream>   // For std::ifstream
 #include <iostream>  // For std::cout
-#include <sstream>   // For std::istringstream
-#include <string>    // For std::string, getline
+#include <sstream>   // For std::ostringstream
+#include <string>    // For std::string
+
+#include "UploadManager.hpp"  // For LARGE_FILE_THRESHOLD
 
 static std::size_t stringToNumber(const std::string& str) {
     const std::size_t decimal = 10;
@@ -35,31 +38,56 @@ static std::size_t stringToNumber(const std::string& str) {
 /* |                        Constructor/Destructor                          | */
 /* @------------------------------------------------------------------------@ */
 
-HttpRequest::HttpRequest() : m_Logger(std::cout, false), m_IsComplete(false), m_IsValid(false) {}
+HttpRequest::HttpRequest() :
+    m_Logger(std::cout, false),
+    m_Stage(STAGE_REQUEST_LINE),
+    m_ParseOffset(0),
+    m_ContentLength(0),
+    m_BodyReceived(0),
+    m_IsComplete(false),
+    m_IsValid(false) {}
 
 HttpRequest::HttpRequest(const Logger& logger) :
-    m_Logger(logger), m_IsComplete(false), m_IsValid(false) {}
+    m_Logger(logger),
+    m_Stage(STAGE_REQUEST_LINE),
+    m_ParseOffset(0),
+    m_ContentLength(0),
+    m_BodyReceived(0),
+    m_IsComplete(false),
+    m_IsValid(false) {}
 
 HttpRequest::~HttpRequest() {}
 
 HttpRequest::HttpRequest(const HttpRequest& that) :
     m_Logger(that.m_Logger),
+    m_Stage(that.m_Stage),
+    m_ParseOffset(that.m_ParseOffset),
+    m_Head(that.m_Head),
+    m_HeaderSpans(that.m_HeaderSpans),
+    m_Headers(that.m_Headers),
     m_Method(that.m_Method),
     m_Path(that.m_Path),
     m_Version(that.m_Version),
-    m_Headers(that.m_Headers),
     m_Body(that.m_Body),
+    m_ContentLength(that.m_ContentLength),
+    m_BodyReceived(that.m_BodyReceived),
     m_IsComplete(that.m_IsComplete),
     m_IsValid(that.m_IsValid),
     m_TempFilePath(that.m_TempFilePath) {}
 
 HttpRequest& HttpRequest::operator=(const HttpRequest& that) {
     if (this != &that) {
+        m_Stage = that.m_Stage;
+        m_ParseOffset = that.m_ParseOffset;
+        m_Head = that.m_Head;
+        m_HeaderSpans = that.m_HeaderSpans;
+        m_Headers = that.m_Headers;
         m_Method = that.m_Method;
         m_Path = that.m_Path;
         m_Version = that.m_Version;
-        m_Headers = that.m_Headers;
         m_Body = that.m_Body;
+        m_ContentLength = that.m_ContentLength;
+        m_BodyReceived = that.m_BodyReceived;
         m_IsComplete = that.m_IsComplete;
         m_IsValid = that.m_IsValid;
         m_TempFilePath = that.m_TempFilePath;
@@ -71,54 +99,100 @@ HttpRequest& HttpRequest::operator=(const HttpRequest& that) {
 /* |                             Public Methods                             | */
 /* @------------------------------------------------------------------------@ */
 
-bool HttpRequest::parse(const std::string& rawData) {
-    clear();
+// Scans only the bytes added since the previous call, one line at a time, until the head ends;
+// the body is then taken once Content-Length bytes are available
+HttpRequest::ParseStatus HttpRequest::feed(const char* data, std::size_t length) {
+    while (m_Stage == STAGE_REQUEST_LINE || m_Stage == STAGE_HEADERS) {
+        const void* newline = std::memchr(data + m_ParseOffset, '\n', length - m_ParseOffset);
+        if (newline == NULL) {
+            return PARSE_INCOMPLETE;
+        }
 
-    std::size_t headerEnd = rawData.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
-        return false;
+        std::size_t lineEnd = static_cast<const char*>(newline) - data;
+        Span        line(m_ParseOffset, lineEnd - m_ParseOffset);
+        if (line.length > 0 && data[lineEnd - 1] == '\r') {
+            --line.length;
+        }
+        m_ParseOffset = lineEnd + 1;
+
+        if (m_Stage == STAGE_REQUEST_LINE) {
+            // Empty lines before the request line are tolerated, as RFC 9112 asks
+            if (line.length == 0) {
+                continue;
+            }
+            if (!parseRequestLine(data, line)) {
+                m_Stage = STAGE_DONE;
+                return PARSE_ERROR;
+            }
+            m_Stage = STAGE_HEADERS;
+        } else if (line.length == 0) {
+            // The spans point into the caller's buffer until the head is copied here
+            m_Head.assign(data, m_ParseOffset);
+            m_ContentLength = stringToNumber(getHeader("content-length"));
+            m_Stage = STAGE_BODY;
+        } else {
+            parseHeaderLine(data, line);
+        }
     }
 
-    std::string        headerSection = rawData.substr(0, headerEnd);
-    std::istringstream headerStream(headerSection);
-    std::string        requestLine;
-
-    if (!std::getline(headerStream, requestLine) || requestLine.empty()) {
-        m_Logger.error() << "Failed to read request line";
-        return false;
+    if (m_Stage == STAGE_BODY) {
+        return parseBody(data, length);
     }
+    return m_IsComplete ? PARSE_COMPLETE : PARSE_ERROR;
+}
 
-    if (requestLine[requestLine.length() - 1] == '\r') {
-        requestLine.erase(requestLine.length() - 1);
+// Body bytes are appended by length, so binary payloads survive intact. With a temp file set the
+// caller has already written them there and they are only counted
+HttpRequest::ParseStatus HttpRequest::appendBody(const char* data, std::size_t length) {
+    if (m_Stage != STAGE_BODY) {
+        return m_IsComplete ? PARSE_COMPLETE : PARSE_ERROR;
     }
 
-    if (!parseRequestLine(requestLine)) {
-        return false;
+    if (length > getBodyRemaining()) {
+        length = getBodyRemaining();
     }
-
-    if (!parseHeaders(headerSection.substr(requestLine.length() + 2))) {
-        return false;
+    if (m_TempFilePath.empty()) {
+        if (m_Body.empty()) {
+            m_Body.reserve(m_ContentLength);
+        }
+        m_Body.append(data, length);
     }
+    m_BodyReceived += length;
 
-    if (!parseBody(rawData, headerEnd + 4)) {
-        return false;
+    if (m_BodyReceived < m_ContentLength) {
+        return PARSE_INCOMPLETE;
     }
-
+    m_Stage = STAGE_DONE;
     m_IsComplete = true;
     m_IsValid = true;
-    return true;
+    return PARSE_COMPLETE;
+}
+
+// One-shot parse of a whole request for tests and tools. The event loop calls feed() itself as
+// data arrives, so the head trace point is taken there rather than here
+bool HttpRequest::parse(const std::string& rawData) {
+    clear();
+    return feed(rawData.data(), rawData.length()) == PARSE_COMPLETE;
 }
 
+bool HttpRequest::isHeaderComplete() const { return m_Stage == STAGE_BODY || m_IsComplete; }
+
 bool HttpRequest::isComplete() const { return m_IsComplete; }
 
 bool HttpRequest::isValid() const { return m_IsValid; }
 
 void HttpRequest::clear() {
+    m_Stage = STAGE_REQUEST_LINE;
+    m_ParseOffset = 0;
+    m_Head.clear();
+    m_HeaderSpans.clear();
+    m_Headers.clear();
     m_Method.clear();
     m_Path.clear();
     m_Version.clear();
-    m_Headers.clear();
     m_Body.clear();
+    m_ContentLength = 0;
+    m_BodyReceived = 0;
     m_IsComplete = false;
     m_IsValid = false;
     // Don't clear m_TempFilePath as it may be set before parsing for large uploads
@@ -130,125 +204,187 @@ const std::string& HttpRequest::getPath() const { return m_Path; }
 
 const std::string& HttpRequest::getVersion() const { return m_Version; }
 
+// Header values are materialized on first lookup and cached, so unused headers cost nothing
 const std::string& HttpRequest::getHeader(const std::string& key) const {
     std::string                                        lowerKey = toLowerCase(key);
     std::map<std::string, std::string>::const_iterator it = m_Headers.find(lowerKey);
     if (it != m_Headers.end()) {
         return it->second;
     }
-    static const std::string empty;
-    return empty;
+
+    const HeaderSpan* header = findHeader(lowerKey);
+    if (header == NULL) {
+        static const std::string empty;
+        return empty;
+    }
+    std::string& value = m_Headers[lowerKey];
+    value.assign(m_Head, header->value.offset, header->value.length);
+    return value;
 }
 
 const std::string& HttpRequest::getBody() const { return m_Body; }
 
-std::size_t HttpRequest::getContentLength() const {
-    const std::string& contentLengthStr = getHeader("content-length");
-    if (contentLengthStr.empty()) {
+std::size_t HttpRequest::getContentLength() const { return m_ContentLength; }
+
+std::size_t HttpRequest::getHeaderLength() const { return m_Head.length(); }
+
+std::size_t HttpRequest::getBodyRemaining() const {
+    if (m_Stage != STAGE_BODY) {
         return 0;
     }
-    return stringToNumber(contentLengthStr);
+    return m_ContentLength - m_BodyReceived;
+}
+
+std::size_t HttpRequest::getRequestLength() const {
+    if (!m_IsComplete) {
+        return 0;
+    }
+    return m_Head.length() + m_Body.length();
+}
+
+// HTTP/1.1 connections persist unless the client says "close"; HTTP/1.0 ones only persist when
+// the client explicitly asks for "keep-alive"
+bool HttpRequest::isKeepAlive() const {
+    const std::string& connection = getHeader("connection");
+    if (m_Version == "HTTP/1.1") {
+        return !hasToken(connection, "close");
+    }
+    return hasToken(connection, "keep-alive");
 }
 
 /* @------------------------------------------------------------------------@ */
 /* |                             Private Methods                            | */
 /* @------------------------------------------------------------------------@ */
 
-bool HttpRequest::parseRequestLine(const std::string& line) {
-    std::istringstream iss(line);
-    std::string        method;
-    std::string        path;
-    std::string        version;
+bool HttpRequest::parseRequestLine(const char* data, const Span& line) {
+    const std::size_t requestLineParts = 3;
+    Span              parts[requestLineParts];
+    std::size_t       count = 0;
+    std::size_t       pos = line.offset;
+    std::size_t       end = line.offset + line.length;
 
-    if (!(iss >> method >> path >> version)) {
-        m_Logger.error() << "Invalid request line format: " << line;
-        return false;
+    while (count < requestLineParts) {
+        while (pos < end && (data[pos] == ' ' || data[pos] == '\t')) {
+            ++pos;
+        }
+        if (pos == end) {
+            break;
+        }
+        std::size_t start = pos;
+        while (pos < end && data[pos] != ' ' && data[pos] != '\t') {
+            ++pos;
+        }
+        parts[count++] = Span(start, pos - start);
     }
 
-    if (!isValidMethod(method)) {
-        m_Logger.error() << "Invalid HTTP method: " << method;
+    if (count < requestLineParts) {
+        m_Logger.error() << "Invalid request line format: "
+                         << std::string(data + line.offset, line.length);
         return false;
     }
 
-    if (path.empty() || path[0] != '/') {
-        m_Logger.error() << "Invalid path: " << path;
+    m_Method.assign(data + parts[0].offset, parts[0].length);
+    m_Path.assign(data + parts[1].offset, parts[1].length);
+    m_Version.assign(data + parts[2].offset, parts[2].length);
+
+    if (!isValidMethod(m_Method)) {
+        m_Logger.error() << "Invalid HTTP method: " << m_Method;
         return false;
     }
 
-    if (!isValidVersion(version)) {
-        m_Logger.error() << "Invalid HTTP version: " << version;
+    if (m_Path[0] != '/') {
+        m_Logger.error() << "Invalid path: " << m_Path;
         return false;
     }
 
-    m_Method = method;
-    m_Path = path;
-    m_Version = version;
+    if (!isValidVersion(m_Version)) {
+        m_Logger.error() << "Invalid HTTP version: " << m_Version;
+        return false;
+    }
 
     return true;
 }
 
-bool HttpRequest::parseHeaders(const std::string& headerSection) {
-    std::istringstream headerStream(headerSection);
-    std::string        line;
+void HttpRequest::parseHeaderLine(const char* data, const Span& line) {
+    const void* colon = std::memchr(data + line.offset, ':', line.length);
+    if (colon == NULL) {
+        m_Logger.warn() << "Invalid header line (no colon): "
+                        << std::string(data + line.offset, line.length);
+        return;
+    }
 
-    while ((std::getline(headerStream, line) != 0) && !line.empty()) {
-        if (line[line.length() - 1] == '\r') {
-            line.erase(line.length() - 1);
-        }
+    std::size_t colonPos = static_cast<const char*>(colon) - data;
+    std::size_t lineEnd = line.offset + line.length;
+    Span        name = trimSpan(data, Span(line.offset, colonPos - line.offset));
+    Span        value = trimSpan(data, Span(colonPos + 1, lineEnd - colonPos - 1));
 
-        if (line.empty()) {
-            break;
-        }
+    if (name.length == 0) {
+        m_Logger.warn() << "Empty header key in line: "
+                        << std::string(data + line.offset, line.length);
+        return;
+    }
 
-        std::size_t colonPos = line.find(':');
-        if (colonPos == std::string::npos) {
-            m_Logger.warn() << "Invalid header line (no colon): " << line;
-            continue;
-        }
+    m_HeaderSpans.push_back(HeaderSpan(name, value));
+}
 
-        std::string key = trimWhitespace(line.substr(0, colonPos));
-        std::string value = trimWhitespace(line.substr(colonPos + 1));
+HttpRequest::ParseStatus HttpRequest::parseBody(const char* data, std::size_t length) {
+    std::size_t headerEnd = m_Head.length();
 
-        if (key.empty()) {
-            m_Logger.warn() << "Empty header key in line: " << line;
-            continue;
+    // If we have a temp file, the body is streamed there and never buffered. Bodies large enough
+    // to need one are left alone until the caller has set it up
+    if (m_ContentLength > 0 && m_TempFilePath.empty()) {
+        if (m_ContentLength >= LARGE_FILE_THRESHOLD || length - headerEnd < m_ContentLength) {
+            return PARSE_INCOMPLETE;
         }
-
-        m_Headers[toLowerCase(key)] = value;
+        m_Body.assign(data + headerEnd, m_ContentLength);
     }
+    m_BodyReceived = m_ContentLength;
 
-    return true;
+    m_Stage = STAGE_DONE;
+    m_IsComplete = true;
+    m_IsValid = true;
+    return PARSE_COMPLETE;
 }
 
-bool HttpRequest::parseBody(const std::string& rawData, std::size_t headerEnd) {
-    std::size_t contentLength = getContentLength();
+// Later duplicates win, as they did when headers were stored in a map
+const HttpRequest::HeaderSpan* HttpRequest::findHeader(const std::string& lowerKey) const {
+    const int upperToLowerOffset = 32;
 
-    if (contentLength == 0) {
-        return true;
+    for (std::size_t i = m_HeaderSpans.size(); i > 0; --i) {
+        const HeaderSpan& header = m_HeaderSpans[i - 1];
+        if (header.name.length != lowerKey.length()) {
+            continue;
+        }
+        std::size_t j = 0;
+        for (; j < lowerKey.length(); ++j) {
+            char c = m_Head[header.name.offset + j];
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c + upperToLowerOffset);
+            }
+            if (c != lowerKey[j]) {
+                break;
+            }
+        }
+        if (j == lowerKey.length()) {
+            return &header;
+        }
     }
+    return NULL;
+}
 
-    // If we have a temp file, the body was already processed separately
-    if (!m_TempFilePath.empty()) {
-        return true;
+HttpRequest::Span HttpRequest::trimSpan(const char* data, const Span& span) {
+    std::size_t start = span.offset;
+    std::size_t end = span.offset + span.length;
+
+    while (start < end && (data[start] == ' ' || data[start] == '\t')) {
+        ++start;
     }
 
-    if (headerEnd + contentLength > rawData.length()) {
-        // For small bodies, allow incomplete data - it might be a request that will be rejected
-        // anyway or the data might arrive in the next poll cycle
-        std::size_t availableBodySize =
-            rawData.length() > headerEnd ? rawData.length() - headerEnd : 0;
-        m_Logger.warn() << "Incomplete body - expected " << contentLength << " bytes, got "
-                        << availableBodySize << " bytes (continuing with partial data)";
-
-        // Store whatever body data we have
-        if (availableBodySize > 0) {
-            m_Body = rawData.substr(headerEnd, availableBodySize);
-        }
-        return true;  // Continue processing - don't fail the entire request
+    while (end > start && (data[end - 1] == ' ' || data[end - 1] == '\t')) {
+        --end;
     }
 
-    m_Body = rawData.substr(headerEnd, contentLength);
-    return true;
+    return Span(start, end - start);
 }
 
 std::string HttpRequest::toLowerCase(const std::string& str) {
@@ -286,6 +422,21 @@ bool HttpRequest::isValidVersion(const std::string& version) {
     return (version == "HTTP/1.0" || version == "HTTP/1.1");
 }
 
+bool HttpRequest::hasToken(const std::string& list, const std::string& token) {
+    std::size_t start = 0;
+    while (start <= list.length()) {
+        std::size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.length();
+        }
+        if (toLowerCase(trimWhitespace(list.substr(start, end - start))) == token) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
 /* @------------------------------------------------------------------------@ */
 /* |                        Large Upload Support Methods                    | */
 /* @------------------------------------------------------------------------@ */
@@ -12,9 +12,12 @@
 
 #include "HttpResponse.hpp"
 
+#include <fcntl.h>     // For open, fcntl
 #include <sys/stat.h>  // For stat
+#include <unistd.h>    // For close, pread
 
 #include <cstdlib>   // For std::atoi
+#include <cstring>   // For std::strlen
 #include <fstream>   // For std::ifstream
 #include <iostream>  // For std::cout
 #include <sstream>   // For std::ostringstream
@@ -26,40 +29,60 @@
 /* |                        Constructor/Destructor                          | */
 /* @------------------------------------------------------------------------@ */
 
-HttpResponse::HttpResponse() : m_Logger(std::cout, false), m_StatusCode(HTTP_OK) {
+HttpResponse::HttpResponse() :
+    m_Logger(std::cout, false),
+    m_StatusCode(HTTP_OK),
+    m_FileFd(-1),
+    m_FileOffset(0),
+    m_FileLength(0) {
     m_StatusMessage = getDefaultStatusMessage(HTTP_OK);
     setDefaultHeaders();
 }
 
-HttpResponse::HttpResponse(int statusCode) : m_Logger(std::cout, false), m_StatusCode(statusCode) {
+HttpResponse::HttpResponse(int statusCode) :
+    m_Logger(std::cout, false),
+    m_StatusCode(statusCode),
+    m_FileFd(-1),
+    m_FileOffset(0),
+    m_FileLength(0) {
     m_StatusMessage = getDefaultStatusMessage(statusCode);
     setDefaultHeaders();
 }
 
 HttpResponse::HttpResponse(int statusCode, const std::string& statusMessage) :
-    m_Logger(std::cout, false), m_StatusCode(statusCode), m_StatusMessage(statusMessage) {
+    m_Logger(std::cout, false),
+    m_StatusCode(statusCode),
+    m_StatusMessage(statusMessage),
+    m_FileFd(-1),
+    m_FileOffset(0),
+    m_FileLength(0) {
     setDefaultHeaders();
 }
 
-HttpResponse::HttpResponse(const Logger& logger) : m_Logger(logger), m_StatusCode(HTTP_OK) {
+HttpResponse::HttpResponse(const Logger& logger) :
+    m_Logger(logger), m_StatusCode(HTTP_OK), m_FileFd(-1), m_FileOffset(0), m_FileLength(0) {
     m_StatusMessage = getDefaultStatusMessage(HTTP_OK);
     setDefaultHeaders();
 }
 
 HttpResponse::HttpResponse(int statusCode, const Logger& logger) :
-    m_Logger(logger), m_StatusCode(statusCode) {
+    m_Logger(logger), m_StatusCode(statusCode), m_FileFd(-1), m_FileOffset(0), m_FileLength(0) {
     m_StatusMessage = getDefaultStatusMessage(statusCode);
     setDefaultHeaders();
 }
 
-HttpResponse::~HttpResponse() {}
+HttpResponse::~HttpResponse() { closeFileBody(); }
 
 HttpResponse::HttpResponse(const HttpResponse& that) :
     m_Logger(that.m_Logger),
     m_StatusCode(that.m_StatusCode),
     m_StatusMessage(that.m_StatusMessage),
     m_Headers(that.m_Headers),
-    m_Body(that.m_Body) {}
+    m_Body(that.m_Body),
+    m_EntityHeaders(that.m_EntityHeaders),
+    m_FileFd(that.m_FileFd < 0 ? -1 : fcntl(that.m_FileFd, F_DUPFD_CLOEXEC, 0)),
+    m_FileOffset(that.m_FileOffset),
+    m_FileLength(that.m_FileLength) {}
 
 HttpResponse& HttpResponse::operator=(const HttpResponse& that) {
     if (this != &that) {
@@ -67,6 +90,11 @@ HttpResponse& HttpResponse::operator=(const HttpResponse& that) {
         m_StatusMessage = that.m_StatusMessage;
         m_Headers = that.m_Headers;
         m_Body = that.m_Body;
+        m_EntityHeaders = that.m_EntityHeaders;
+        closeFileBody();
+        m_FileFd = that.m_FileFd < 0 ? -1 : fcntl(that.m_FileFd, F_DUPFD_CLOEXEC, 0);
+        m_FileOffset = that.m_FileOffset;
+        m_FileLength = that.m_FileLength;
     }
     return (*this);
 }
@@ -90,6 +118,8 @@ void HttpResponse::setHeader(const std::string& key, const std::string& value) {
 }
 
 void HttpResponse::setBody(const std::string& body) {
+    closeFileBody();
+    m_EntityHeaders.clear();
     m_Body = body;
 
     // Update Content-Length automatically
@@ -99,6 +129,14 @@ void HttpResponse::setBody(const std::string& body) {
 }
 
 void HttpResponse::setBodyFromFile(const std::string& filePath) {
+    // Large files are not copied into memory; the sender streams them with sendfile()
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) == 0 &&
+        static_cast<std::size_t>(fileStat.st_size) >= FILE_BODY_THRESHOLD) {
+        openFileBody(filePath);
+        return;
+    }
+
     std::ifstream file(filePath.c_str());
     if (!file.is_open()) {
         m_Logger.error() << "Could not open file: " << filePath;
@@ -122,6 +160,51 @@ void HttpResponse::setBodyFromFile(const std::string& filePath) {
                     << contentType << ")";
 }
 
+// Body from an fd the caller keeps open, such as one held by the open-file cache. A file body
+// gets its own close-on-exec dup of the fd, and small files are read with pread() so the
+// shared file offset is never moved
+void HttpResponse::setBodyFromFile(const std::string& filePath, int fdesc, std::size_t length) {
+    std::string contentType = getContentType(filePath);
+    bool        loaded = false;
+
+    if (length >= FILE_BODY_THRESHOLD) {
+        setBody("");
+        m_FileFd = fcntl(fdesc, F_DUPFD_CLOEXEC, 0);
+        m_FileOffset = 0;
+        m_FileLength = length;
+        loaded = m_FileFd >= 0;
+    } else {
+        std::string content(length, '\0');
+        std::size_t total = 0;
+        while (total < length) {
+            ssize_t bytesRead = pread(fdesc, &content[total], length - total,
+                                      static_cast<off_t>(total));
+            if (bytesRead <= 0) {
+                break;
+            }
+            total += static_cast<std::size_t>(bytesRead);
+        }
+        loaded = total == length;
+        if (loaded) {
+            setBody(content);
+        }
+    }
+
+    if (!loaded) {
+        m_Logger.error() << "Could not read file: " << filePath;
+        setStatus(HTTP_INTERNAL_ERROR, "Internal Server Error");
+        setBody("Internal Server Error");
+        return;
+    }
+
+    std::ostringstream oss;
+    oss << length;
+    setHeader("Content-Type", contentType);
+    setHeader("Content-Length", oss.str());
+    m_Logger.info() << "Loaded file: " << filePath << " (" << length << " bytes, " << contentType
+                    << ")";
+}
+
 void HttpResponse::appendBody(const std::string& content) {
     m_Body += content;
 
@@ -146,27 +229,77 @@ const std::string& HttpResponse::getHeader(const std::string& key) const {
 
 const std::string& HttpResponse::getBody() const { return m_Body; }
 
-std::size_t HttpResponse::getContentLength() const { return m_Body.length(); }
+std::size_t HttpResponse::getContentLength() const {
+    return hasFileBody() ? m_FileLength : m_Body.length();
+}
+
+bool HttpResponse::hasFileBody() const { return m_FileFd >= 0; }
+
+off_t HttpResponse::getFileOffset() const { return m_FileOffset; }
+
+std::size_t HttpResponse::getFileLength() const { return m_FileLength; }
 
+void HttpResponse::setEntityHeaders(const std::string& headers) {
+    m_Headers.erase("Content-Type");
+    m_Headers.erase("Content-Length");
+    m_EntityHeaders = headers;
+}
+
+int HttpResponse::releaseFileBody() {
+    int fdesc = m_FileFd;
+    m_FileFd = -1;
+    return fdesc;
+}
+
+// The whole response as one string, for tests and tools. The event loop queues the head from
+// serializeHead() and sends the body separately, so the serialize trace point is taken there
 std::string HttpResponse::toString() const {
-    std::ostringstream response;
+    std::string response;
+
+    // A file body is not part of the string and is streamed after it
+    serializeHead(response);
+    response += m_Body;
+    return response;
+}
+
+// Appends the status line and headers, sized up front so the head is built in one allocation
+void HttpResponse::serializeHead(std::string& head) const {
+    std::size_t length = std::strlen("HTTP/1.1 000 \r\n\r\n") + m_StatusMessage.length() +
+                         m_EntityHeaders.length();
+    for (std::map<std::string, std::string>::const_iterator it = m_Headers.begin();
+         it != m_Headers.end(); ++it) {
+        length += it->first.length() + it->second.length() + std::strlen(": \r\n");
+    }
+    head.reserve(head.length() + length);
 
     // Status line: HTTP/1.1 HTTP_OK OK
-    response << "HTTP/1.1 " << m_StatusCode << " " << m_StatusMessage << "\r\n";
+    const char statusCode[] = {static_cast<char>('0' + (m_StatusCode / 100) % 10),
+                               static_cast<char>('0' + (m_StatusCode / 10) % 10),
+                               static_cast<char>('0' + m_StatusCode % 10)};
+    head.append("HTTP/1.1 ");
+    head.append(statusCode, sizeof(statusCode));
+    head.append(" ");
+    head.append(m_StatusMessage);
+    head.append("\r\n");
 
     // Headers
     for (std::map<std::string, std::string>::const_iterator it = m_Headers.begin();
          it != m_Headers.end(); ++it) {
-        response << it->first << ": " << it->second << "\r\n";
+        head.append(it->first);
+        head.append(": ");
+        head.append(it->second);
+        head.append("\r\n");
     }
+    head.append(m_EntityHeaders);
 
     // Empty line to separate headers from body
-    response << "\r\n";
-
-    // Body
-    response << m_Body;
+    head.append("\r\n");
+}
 
-    return response.str();
+// Hands the in-memory body to the caller without copying it; the headers are left untouched
+void HttpResponse::releaseBody(std::string& body) {
+    body.clear();
+    body.swap(m_Body);
 }
 
 void HttpResponse::clear() {
@@ -174,6 +307,8 @@ void HttpResponse::clear() {
     m_StatusMessage = "OK";
     m_Headers.clear();
     m_Body.clear();
+    m_EntityHeaders.clear();
+    closeFileBody();
     setDefaultHeaders();
 }
 
@@ -283,6 +418,10 @@ std::string HttpResponse::getDefaultStatusMessage(int statusCode) {
             return "Internal Server Error";
         case HTTP_NOT_IMPLEMENTED:
             return "Not Implemented";
+        case HTTP_BAD_GATEWAY:
+            return "Bad Gateway";
+        case HTTP_SERVICE_UNAVAILABLE:
+            return "Service Unavailable";
         case HTTP_VERSION_NOT_SUPPORTED:
             return "HTTP Version Not Supported";
         default:
@@ -290,6 +429,16 @@ std::string HttpResponse::getDefaultStatusMessage(int statusCode) {
     }
 }
 
+// RFC 7231 IMF-fixdate, as used by Date and Last-Modified
+std::string HttpResponse::formatHttpDate(time_t timestamp) {
+    char      buffer[sizeof("Mon, 27 Jan 2025 12:00:00 GMT")];
+    struct tm date;
+
+    gmtime_r(&timestamp, &date);
+    strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &date);
+    return buffer;
+}
+
 std::string HttpResponse::getCurrentDateTime() {
     // For C++98 compatibility, we'll use a simple timestamp
     // In a real implementation, you might want to format this properly
@@ -366,3 +515,40 @@ std::string HttpResponse::getContentType(const std::string& filePath) {
 
     return "application/octet-stream";
 }
+
+void HttpResponse::openFileBody(const std::string& filePath) {
+    int         fdesc = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat fileStat;
+    if (fdesc < 0 || fstat(fdesc, &fileStat) != 0) {
+        if (fdesc >= 0) {
+            close(fdesc);
+        }
+        m_Logger.error() << "Could not open file: " << filePath;
+        setStatus(HTTP_INTERNAL_ERROR, "Internal Server Error");
+        setBody("Internal Server Error");
+        return;
+    }
+
+    std::string contentType = getContentType(filePath);
+    setHeader("Content-Type", contentType);
+
+    setBody("");
+    m_FileFd = fdesc;
+    m_FileOffset = 0;
+    m_FileLength = static_cast<std::size_t>(fileStat.st_size);
+
+    std::ostringstream oss;
+    oss << m_FileLength;
+    setHeader("Content-Length", oss.str());
+    m_Logger.info() << "Opened file: " << filePath << " (" << m_FileLength << " bytes, "
+                    << contentType << ")";
+}
+
+void HttpResponse::closeFileBody() {
+    if (m_FileFd >= 0) {
+        close(m_FileFd);
+        m_FileFd = -1;
+    }
+    m_FileOffset = 0;
+    m_FileLength = 0;
+}
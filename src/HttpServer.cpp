@@ -13,12 +13,13 @@
 #include "HttpServer.hpp"
 
 #include <dirent.h>      // For directory operations
+#include <fcntl.h>       // For open
 #include <netinet/in.h>  // For ntohs
 #include <sys/stat.h>    // For stat
-#include <sys/wait.h>    // For waitpid
-#include <unistd.h>      // For access, unlink, fork, exec, pipe
+#include <unistd.h>      // For access, unlink, environ
 
 #include <algorithm>  // For std::sort
+#include <cstdlib>    // For getenv
 #include <cstring>    // For strerror
 #include <fstream>    // For std::ofstream
 #include <iostream>   // For std::cout
@@ -26,6 +27,10 @@
 #include <sstream>    // For std::ostringstream
 #include <vector>     // For std::vector
 
+#include "CgiWorker.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+
 /* @------------------------------------------------------------------------@ */
 /* |                        Constructor/Destructor                          | */
 /* @------------------------------------------------------------------------@ */
@@ -34,7 +39,10 @@ HttpServer::HttpServer(const Config& config, const Logger& logger) :
     m_Config(config),
     m_Logger(logger),
     m_DocumentRoot("/var/www/html"),
-    m_DefaultIndex("index.html") {
+    m_DefaultIndex("index.html"),
+    m_FileCache(logger, config.getOpenFileCache(), config.getOpenFileCacheValid(),
+                config.getResponseCacheMaxFile(), config.getResponseCacheSize()),
+    m_UploadCounter(0) {
     m_Logger.info() << "HttpServer initialized with default document root: " << m_DocumentRoot;
 }
 
@@ -44,7 +52,11 @@ HttpServer::HttpServer(const HttpServer& that) :
     m_Config(that.m_Config),
     m_Logger(that.m_Logger),
     m_DocumentRoot(that.m_DocumentRoot),
-    m_DefaultIndex(that.m_DefaultIndex) {}
+    m_DefaultIndex(that.m_DefaultIndex),
+    m_FileCache(that.m_Logger, that.m_Config.getOpenFileCache(),
+                that.m_Config.getOpenFileCacheValid(), that.m_Config.getResponseCacheMaxFile(),
+                that.m_Config.getResponseCacheSize()),
+    m_UploadCounter(0) {}
 
 HttpServer& HttpServer::operator=(const HttpServer& that) {
     if (this != &that) {
@@ -58,7 +70,17 @@ HttpServer& HttpServer::operator=(const HttpServer& that) {
 /* |                             Public Methods                             | */
 /* @------------------------------------------------------------------------@ */
 
+// For callers that run no scripts: one started for the request is dropped again
 HttpResponse HttpServer::processRequest(const HttpRequest& request, int serverPort) {
+    PendingScript script;
+    HttpResponse  response = processRequest(request, serverPort, script);
+    delete script.cgi;
+    delete script.fastcgi;
+    return response;
+}
+
+HttpResponse HttpServer::processRequest(const HttpRequest& request, int serverPort,
+                                        PendingScript& script) {
     m_Logger.info() << "Processing " << request.getMethod() << " " << request.getPath() << " HTTP/"
                     << request.getVersion() << " on port " << serverPort;
 
@@ -76,10 +98,10 @@ HttpResponse HttpServer::processRequest(const HttpRequest& request, int serverPo
     const std::string& method = request.getMethod();
 
     if (method == "GET") {
-        return handleGET(request, *server);
+        return handleGET(request, *server, script);
     }
     if (method == "POST") {
-        return handlePOST(request, *server);
+        return handlePOST(request, *server, script);
     }
     if (method == "DELETE") {
         return handleDELETE(request, *server);
@@ -100,11 +122,21 @@ const std::string& HttpServer::getDocumentRoot() const { return m_DocumentRoot;
 
 const std::string& HttpServer::getDefaultIndex() const { return m_DefaultIndex; }
 
+// Error response for the server on serverPort, with its custom error page if one is configured
+HttpResponse HttpServer::createErrorResponse(int statusCode, int serverPort) {
+    const Config::Server* server = findMatchingServer(serverPort);
+    if (server == NULL) {
+        return HttpResponse::createInternalError();
+    }
+    return createErrorResponse(statusCode, *server);
+}
+
 /* @------------------------------------------------------------------------@ */
 /* |                             Private Methods                            | */
 /* @------------------------------------------------------------------------@ */
 
-HttpResponse HttpServer::handleGET(const HttpRequest& request, const Config::Server& server) {
+HttpResponse HttpServer::handleGET(const HttpRequest& request, const Config::Server& server,
+                                   PendingScript& script) {
     const std::string& requestPath = request.getPath();
 
     if (!isPathSafe(requestPath)) {
@@ -120,6 +152,9 @@ HttpResponse HttpServer::handleGET(const HttpRequest& request, const Config::Ser
         m_Logger.warn() << "GET method not allowed for path: " << requestPath;
         return createErrorResponse(HTTP_METHOD_NOT_ALLOWED, server);
     }
+    if ((location != 0) && location->metrics) {
+        return serveMetrics();
+    }
 
     // Determine document root and index file
     std::string documentRoot;
@@ -157,14 +192,14 @@ HttpResponse HttpServer::handleGET(const HttpRequest& request, const Config::Ser
     }
 
     struct stat fileStat;
-    if (stat(filePath.c_str(), &fileStat) != 0) {
+    if (!m_FileCache.getInfo(filePath, fileStat)) {
         return createErrorResponse(HTTP_NOT_FOUND, server);
     }
 
     if (S_ISREG(fileStat.st_mode)) {
         // Check if it's a CGI file
         if (isCGIFile(filePath)) {
-            return handleCGI(request, server, filePath);
+            return handleCGI(request, server, location, filePath, script);
         }
         return serveStaticFile(filePath, server);
     }
@@ -174,7 +209,8 @@ HttpResponse HttpServer::handleGET(const HttpRequest& request, const Config::Ser
     return createErrorResponse(HTTP_FORBIDDEN, server);
 }
 
-HttpResponse HttpServer::handlePOST(const HttpRequest& request, const Config::Server& server) {
+HttpResponse HttpServer::handlePOST(const HttpRequest& request, const Config::Server& server,
+                                    PendingScript& script) {
     const std::string& requestPath = request.getPath();
 
     m_Logger.info() << "POST request to " << requestPath << " (body: " << request.getBody().length()
@@ -204,7 +240,7 @@ HttpResponse HttpServer::handlePOST(const HttpRequest& request, const Config::Se
     if (isCGIFile(filePath)) {
         struct stat fileStat;
         if (stat(filePath.c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode)) {
-            return handleCGI(request, server, filePath);
+            return handleCGI(request, server, location, filePath, script);
         }
     }
 
@@ -348,16 +384,11 @@ HttpResponse HttpServer::handleFileUpload(const HttpRequest& request, const Conf
         return createErrorResponse(HTTP_BAD_REQUEST, server);
     }
 
-    // Generate final filename
-    std::ostringstream  oss;
-    static unsigned int uploadCounter = 0;
-    oss << "./html/uploaded_" << ++uploadCounter;
-    if (isLargeUpload) {
-        oss << "_large.bin";  // Use binary extension for large files
-    } else {
-        oss << ".txt";
+    std::string filename = claimUploadFilename(isLargeUpload);
+    if (filename.empty()) {
+        m_Logger.error() << "No upload file could be created in ./html";
+        return createErrorResponse(HTTP_INTERNAL_ERROR, server);
     }
-    std::string filename = oss.str();
 
     bool        success = false;
     std::size_t fileSize = 0;
@@ -370,6 +401,7 @@ HttpResponse HttpServer::handleFileUpload(const HttpRequest& request, const Conf
     }
 
     if (success) {
+        m_FileCache.invalidate(filename);
         std::ostringstream responseBody;
         responseBody << "<h1>Upload Successful!</h1><p>File saved as: " << filename
                      << "</p><p>Size: " << fileSize << " bytes</p><p>Type: "
@@ -383,9 +415,37 @@ HttpResponse HttpServer::handleFileUpload(const HttpRequest& request, const Conf
     }
 
     m_Logger.error() << "Failed to save uploaded file: " << filename;
+    unlink(filename.c_str());
     return createErrorResponse(HTTP_INTERNAL_ERROR, server);
 }
 
+// Reserves the next free upload name by creating the file exclusively, so worker processes
+// sharing the upload directory never hand out the same name; reactor threads draw their
+// numbers atomically. Returns "" when the directory cannot be written to
+std::string HttpServer::claimUploadFilename(bool isLargeUpload) {
+    while (true) {
+        std::ostringstream oss;
+        oss << "./html/uploaded_" << __sync_add_and_fetch(&m_UploadCounter, 1);
+        if (isLargeUpload) {
+            oss << "_large.bin";  // Use binary extension for large files
+        } else {
+            oss << ".txt";
+        }
+        std::string filename = oss.str();
+
+        int fdesc = open(filename.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fdesc >= 0) {
+            close(fdesc);
+            return filename;
+        }
+        // Taken by an earlier upload or another worker; anything else will not get better
+        struct stat fileStat;
+        if (stat(filename.c_str(), &fileStat) != 0) {
+            return "";
+        }
+    }
+}
+
 HttpResponse HttpServer::handleDELETE(const HttpRequest& request, const Config::Server& server) {
     const std::string& requestPath = request.getPath();
 
@@ -427,6 +487,7 @@ HttpResponse HttpServer::handleDELETE(const HttpRequest& request, const Config::
 
     if (S_ISREG(fileStat.st_mode)) {
         if (unlink(filePath.c_str()) == 0) {
+            m_FileCache.invalidate(filePath);
             m_Logger.info() << "File deleted successfully: " << filePath;
 
             HttpResponse response(HTTP_OK, m_Logger);
@@ -464,27 +525,28 @@ HttpResponse HttpServer::handleHEAD(const HttpRequest& request, const Config::Se
         return createErrorResponse(HTTP_URI_TOO_LONG, server);
     }
 
-    // Check if file exists and get stats
-    struct stat fileStat;
-    if (stat(filePath.c_str(), &fileStat) != 0) {
+    // The same cache entry GET serves, so HEAD carries the same entity headers (ETag and
+    // Last-Modified included). The entry is only valid while the cache is locked
+    MutexLock               lock(m_FileCache.getMutex());
+    const FileCache::Entry* cached = m_FileCache.lookup(filePath);
+    if (cached == NULL) {
         return createErrorResponse(HTTP_NOT_FOUND, server);
     }
 
-    if (S_ISREG(fileStat.st_mode)) {
-        HttpResponse response(HTTP_OK, m_Logger);
-
-        // Determine content type and set headers
-        std::string contentType = determineContentTypeFromPath(filePath);
-        response.setHeader("Content-Type", contentType);
-
-        std::ostringstream oss;
-        oss << fileStat.st_size;
-        response.setHeader("Content-Length", oss.str());
+    if (S_ISREG(cached->info.st_mode)) {
+        // Check read permissions: the cache could not open the file
+        if (cached->fd < 0) {
+            m_Logger.warn() << "No read permission for file: " << filePath;
+            return createErrorResponse(HTTP_FORBIDDEN, server);
+        }
 
+        // Entity headers only; the body GET would send is dropped
+        HttpResponse response(HTTP_OK, m_Logger);
+        response.setEntityHeaders(cached->headers);
         return response;
     }
 
-    if (S_ISDIR(fileStat.st_mode)) {
+    if (S_ISDIR(cached->info.st_mode)) {
         HttpResponse response(HTTP_OK, m_Logger);
         response.setHeader("Content-Type", "text/html");
         return response;
@@ -583,83 +645,68 @@ std::string HttpServer::constructHEADFilePath(const std::string& documentRoot,
     return filePath;
 }
 
-// Helper method to determine content type from file path
-std::string HttpServer::determineContentTypeFromPath(const std::string& filePath) {
-    std::string contentType = "application/octet-stream";
-    std::size_t dotPos = filePath.find_last_of('.');
-
-    if (dotPos != std::string::npos) {
-        std::string extension = filePath.substr(dotPos);
-        if (extension == ".html" || extension == ".htm") {
-            contentType = "text/html; charset=utf-8";
-        } else if (extension == ".css") {
-            contentType = "text/css";
-        } else if (extension == ".js") {
-            contentType = "application/javascript";
-        } else if (extension == ".txt") {
-            contentType = "text/plain; charset=utf-8";
-        } else if (extension == ".jpg" || extension == ".jpeg") {
-            contentType = "image/jpeg";
-        } else if (extension == ".png") {
-            contentType = "image/png";
-        }
-    }
-
-    return contentType;
-}
-
 HttpResponse HttpServer::serveStaticFile(const std::string&    filePath,
                                          const Config::Server& server) {
-    // Security check: Detect and reject symbolic links
-    struct stat linkStat;
-    if (stat(filePath.c_str(), &linkStat) != 0) {
+    // Metadata and the open fd come from the cache, so a hot file costs no stat, access or open.
+    // The entry is shared with other reactor threads and only valid while the cache is locked
+    MutexLock               lock(m_FileCache.getMutex());
+    const FileCache::Entry* cached = m_FileCache.lookup(filePath);
+    if (cached == NULL) {
         return createErrorResponse(HTTP_NOT_FOUND, server);
     }
 
-    if (S_ISLNK(linkStat.st_mode)) {
+    // Security check: Detect and reject symbolic links
+    if (S_ISLNK(cached->info.st_mode)) {
         m_Logger.warn() << "Symbolic link rejected for security reasons: " << filePath;
         return createErrorResponse(HTTP_FORBIDDEN, server);
     }
 
-    // Check if file exists and get stats (using stat for regular files)
-    struct stat fileStat;
-    if (stat(filePath.c_str(), &fileStat) != 0) {
-        return createErrorResponse(HTTP_NOT_FOUND, server);
-    }
-
     // Verify it's a regular file
-    if (!S_ISREG(fileStat.st_mode)) {
+    if (!S_ISREG(cached->info.st_mode)) {
         m_Logger.warn() << "Not a regular file: " << filePath;
         return createErrorResponse(HTTP_FORBIDDEN, server);
     }
 
-    // Check read permissions
-    if (access(filePath.c_str(), R_OK) != 0) {
+    // Check read permissions: the cache could not open the file
+    if (cached->fd < 0) {
         m_Logger.warn() << "No read permission for file: " << filePath;
         return createErrorResponse(HTTP_FORBIDDEN, server);
     }
 
-    // Check file size (basic limit of 100MB for safety)
-    const std::size_t maxFileSize = static_cast<std::size_t>(100) * BYTES_PER_KB * BYTES_PER_KB;
-    if (static_cast<std::size_t>(fileStat.st_size) > maxFileSize) {
-        m_Logger.warn() << "File too large: " << filePath << " (" << fileStat.st_size << " bytes)";
-        return createErrorResponse(HTTP_PAYLOAD_TOO_LARGE, server);
-    }
-
     HttpResponse response(HTTP_OK, m_Logger);
-    response.setBodyFromFile(filePath);
-
-    // Double-check that file loading succeeded
-    if (response.getStatusCode() != HTTP_OK) {
-        m_Logger.error() << "Failed to load file content: " << filePath;
-        return createErrorResponse(HTTP_INTERNAL_ERROR, server);
+    if (cached->materialized) {
+        // Small hot file: content and entity headers are ready, nothing is read or formatted
+        response.setBody(cached->body);
+    } else {
+        // No size cap: large files are streamed from their fd rather than loaded into memory
+        response.setBodyFromFile(filePath, cached->fd,
+                                 static_cast<std::size_t>(cached->info.st_size));
+
+        // Double-check that file loading succeeded
+        if (response.getStatusCode() != HTTP_OK) {
+            m_Logger.error() << "Failed to load file content: " << filePath;
+            return createErrorResponse(HTTP_INTERNAL_ERROR, server);
+        }
     }
+    response.setEntityHeaders(cached->headers);
 
     m_Logger.info() << "Served file: " << filePath << " (" << response.getContentLength()
                     << " bytes)";
     return response;
 }
 
+// Counters of every event loop, in the Prometheus text format
+HttpResponse HttpServer::serveMetrics() {
+    std::string  body;
+    HttpResponse response(HTTP_OK, m_Logger);
+
+    Metrics::render(body);
+    response.setHeader("Content-Type", "text/plain; version=0.0.4");
+    response.setHeader("Cache-Control", "no-store");
+    response.setBody(body);
+    return response;
+}
+
 HttpResponse HttpServer::generateDirectoryListing(const std::string&    dirPath,
                                                   const std::string&    requestPath,
                                                   const Config::Server& server) {
@@ -888,6 +935,7 @@ const Config::Location* HttpServer::findMatchingLocation(const Config::Server& s
         // Check if we can safely access the vector
         std::size_t locationCount = locations.size();
         if (locationCount == 0) {
+            TRACE_MARK_CURRENT(LOCATION_MATCHED);
             return NULL;
         }
 
@@ -911,6 +959,7 @@ const Config::Location* HttpServer::findMatchingLocation(const Config::Server& s
             }
         }
 
+        TRACE_MARK_CURRENT(LOCATION_MATCHED);
         return bestMatch;
     } catch (...) {
         // If anything goes wrong, return NULL safely
@@ -1017,152 +1066,126 @@ std::string HttpServer::testJoinPath(const std::string& base, const std::string&
     return joinPath(base, path);
 }
 
+const Config::Location* HttpServer::testFindMatchingLocation(const Config::Server& server,
+                                                             const std::string&    path) {
+    return findMatchingLocation(server, path);
+}
+
+std::vector<std::string> HttpServer::testBuildCgiEnvironment(const HttpRequest& request,
+                                                             const std::string& filePath) {
+    return buildCgiEnvironment(request, filePath);
+}
+
 /* @------------------------------------------------------------------------@ */
 /* |                              CGI Handler                               | */
 /* @------------------------------------------------------------------------@ */
 
+// Starts the script and leaves it running: the process is handed to the event loop through
+// script.cgi, and the loop relays its output as it arrives. A location with fastcgi_pass sends
+// the request to its FastCGI upstream instead (see script.fastcgi), and so do Python and Perl
+// scripts when cgi_workers keeps warm interpreters for them. The returned response is only a
+// placeholder unless the request could not be started
 HttpResponse HttpServer::handleCGI(const HttpRequest& request, const Config::Server& server,
-                                   const std::string& filePath) {
-    (void)server;  // Suppress unused parameter warning for now
-
+                                   const Config::Location* location, const std::string& filePath,
+                                   PendingScript& script) {
     m_Logger.info() << "CGI request to " << filePath;
 
-    // Determine CGI interpreter based on file extension
-    std::string interpreter;
+    std::vector<std::string> env = buildCgiEnvironment(request, filePath);
+    std::string upstream = location != NULL ? location->fastcgiPass : "";
+    if (upstream.empty() && m_Config.getCgiWorkers() > 0) {
+        upstream = CgiWorker::getPoolAddress(filePath);
+    }
+    if (!upstream.empty()) {
+        FastCgiRequest* fastCgi = new FastCgiRequest(m_Logger, upstream);
+        if (!fastCgi->prepare(env, request)) {
+            delete fastCgi;
+            return createErrorResponse(HTTP_INTERNAL_ERROR, server);
+        }
+        script.fastcgi = fastCgi;
+        return HttpResponse(HTTP_OK, m_Logger);
+    }
+
+    // Determine CGI interpreter based on file extension; .cgi files are executed directly
+    std::vector<std::string> argv;
     if (filePath.find(".php") != std::string::npos) {
-        interpreter = "php-cgi";
+        argv.push_back(findExecutable("php-cgi"));
     } else if (filePath.find(".py") != std::string::npos) {
-        interpreter = "python3";
+        argv.push_back(findExecutable("python3"));
     } else if (filePath.find(".pl") != std::string::npos) {
-        interpreter = "perl";
-    } else {
-        // For .cgi files, execute directly
-        interpreter = "";
-    }
-
-    // Create pipes for CGI communication
-    int stdinPipe[2];
-    int stdoutPipe[2];
-
-    if (pipe(stdinPipe) == -1 || pipe(stdoutPipe) == -1) {
-        m_Logger.error() << "Failed to create pipes for CGI";
-        return createErrorResponse(HTTP_INTERNAL_ERROR, server);
+        argv.push_back(findExecutable("perl"));
+    }
+    argv.push_back(filePath);
+
+    // A forked script also sees whatever the server inherited
+    std::size_t cgiVariables = env.size();
+    for (char** variable = environ; *variable != NULL; variable++) {
+        std::string entry(*variable);
+        std::string prefix = entry.substr(0, entry.find('=') + 1);
+        bool        overridden = false;
+        for (std::size_t i = 0; i < cgiVariables && !overridden; i++) {
+            overridden = env[i].compare(0, prefix.length(), prefix) == 0;
+        }
+        if (!overridden) {
+            env.push_back(entry);
+        }
     }
 
-    // Fork child process for CGI execution
-    pid_t pid = fork();
-    if (pid == -1) {
-        m_Logger.error() << "Failed to fork for CGI execution";
-        close(stdinPipe[0]);
-        close(stdinPipe[1]);
-        close(stdoutPipe[0]);
-        close(stdoutPipe[1]);
+    CgiProcess* process = new CgiProcess(m_Logger);
+    if (!process->start(argv, env, request)) {
+        delete process;
         return createErrorResponse(HTTP_INTERNAL_ERROR, server);
     }
+    script.cgi = process;
+    return HttpResponse(HTTP_OK, m_Logger);
+}
 
-    if (pid == 0) {
-        // Child process - execute CGI script
-
-        // Set up pipes
-        dup2(stdinPipe[0], STDIN_FILENO);
-        dup2(stdoutPipe[1], STDOUT_FILENO);
-        dup2(stdoutPipe[1], STDERR_FILENO);
-
-        // Close unused pipe ends
-        close(stdinPipe[1]);
-        close(stdoutPipe[0]);
-        close(stdinPipe[0]);
-        close(stdoutPipe[1]);
-
-        // Set environment variables according to CGI standard
-        setenv("REQUEST_METHOD", request.getMethod().c_str(), 1);
-
-        // Extract query string from path (everything after '?')
-        std::string path = request.getPath();
-        std::string queryString;
-        size_t      queryPos = path.find('?');
-        if (queryPos != std::string::npos) {
-            queryString = path.substr(queryPos + 1);
-            path = path.substr(0, queryPos);
-        }
-        setenv("QUERY_STRING", queryString.c_str(), 1);
-        setenv("PATH_INFO", path.c_str(), 1);
-
-        // Content-related variables
-        std::ostringstream contentLengthStream;
-        contentLengthStream << request.getBody().length();
-        std::string contentLength = contentLengthStream.str();
-        setenv("CONTENT_LENGTH", contentLength.c_str(), 1);
-        setenv("CONTENT_TYPE", request.getHeader("Content-Type").c_str(), 1);
-
-        // Server variables
-        setenv("SCRIPT_NAME", path.c_str(), 1);
-        setenv("SERVER_SOFTWARE", "webserv/1.0", 1);
-        setenv("SERVER_NAME", "localhost", 1);
-        setenv("SERVER_PORT", "8080", 1);
-
-        // HTTP headers as environment variables
-        setenv("HTTP_HOST", request.getHeader("Host").c_str(), 1);
-        setenv("HTTP_USER_AGENT", request.getHeader("User-Agent").c_str(), 1);
-
-        // Execute CGI script
-        if (interpreter.empty()) {
-            // Execute script directly (for .cgi files)
-            char* argv[] = {const_cast<char*>(filePath.c_str()), NULL};
-            char* envp[] = {NULL};  // Basic environment
-            execve(filePath.c_str(), argv, envp);
-        } else {
-            // Execute with interpreter (for .php, .py, .pl files)
-            char* argv[] = {const_cast<char*>(interpreter.c_str()),
-                            const_cast<char*>(filePath.c_str()), NULL};
-            char* envp[] = {NULL};  // Basic environment
-            execve(interpreter.c_str(), argv, envp);
-        }
-
-        // If execve fails
-        _exit(1);
-    } else {
-        // Parent process - read CGI output
-
-        // Close child's pipe ends
-        close(stdinPipe[0]);
-        close(stdoutPipe[1]);
-
-        // Send request body to CGI if needed (for POST)
-        if (request.getMethod() == "POST" && !request.getBody().empty()) {
-            write(stdinPipe[1], request.getBody().c_str(), request.getBody().length());
-        }
-        close(stdinPipe[1]);
-
-        // Read CGI output
-        std::string cgiOutput;
-        char        buffer[CGI_BUFFER_SIZE];
-        ssize_t     bytesRead;
-
-        while ((bytesRead = read(stdoutPipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-            buffer[bytesRead] = '\0';
-            cgiOutput += buffer;
-        }
-        close(stdoutPipe[0]);
-
-        // Wait for child to complete
-        int status;
-        waitpid(pid, &status, 0);
-
-        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
-            // CGI executed successfully
-            m_Logger.info() << "CGI executed successfully, output size: " << cgiOutput.length();
+// Environment variables according to CGI standard, as "NAME=value" entries
+std::vector<std::string> HttpServer::buildCgiEnvironment(const HttpRequest& request,
+                                                         const std::string& filePath) {
+    // Extract query string from path (everything after '?')
+    std::string path = request.getPath();
+    std::string queryString;
+    size_t      queryPos = path.find('?');
+    if (queryPos != std::string::npos) {
+        queryString = path.substr(queryPos + 1);
+        path = path.substr(0, queryPos);
+    }
+    std::ostringstream contentLength;
+    contentLength << request.getContentLength();
+
+    std::vector<std::string> env;
+    env.push_back("GATEWAY_INTERFACE=CGI/1.1");
+    env.push_back("REQUEST_METHOD=" + request.getMethod());
+    env.push_back("QUERY_STRING=" + queryString);
+    env.push_back("PATH_INFO=" + path);
+    env.push_back("CONTENT_LENGTH=" + contentLength.str());
+    env.push_back("CONTENT_TYPE=" + request.getHeader("Content-Type"));
+    env.push_back("SCRIPT_NAME=" + path);
+    env.push_back("SCRIPT_FILENAME=" + filePath);
+    env.push_back("SERVER_SOFTWARE=webserv/1.0");
+    env.push_back("SERVER_NAME=localhost");
+    env.push_back("SERVER_PORT=8080");
+    env.push_back("SERVER_PROTOCOL=" + request.getVersion());
+    env.push_back("HTTP_HOST=" + request.getHeader("Host"));
+    env.push_back("HTTP_USER_AGENT=" + request.getHeader("User-Agent"));
+    return env;
+}
 
-            HttpResponse response(HTTP_OK, m_Logger);
-            response.setHeader("Content-Type", "text/html");
-            response.setBody(cgiOutput);
-            return response;
+// execve() does not search PATH, so interpreters are resolved here
+std::string HttpServer::findExecutable(const std::string& name) {
+    const char* pathVariable = getenv("PATH");
+    if (name.find('/') != std::string::npos || pathVariable == NULL) {
+        return name;
+    }
+    std::istringstream directories(pathVariable);
+    std::string        directory;
+    while (std::getline(directories, directory, ':')) {
+        std::string candidate = joinPath(directory.empty() ? "." : directory, name);
+        if (access(candidate.c_str(), X_OK) == 0) {
+            return candidate;
         }
-
-        // CGI execution failed
-        m_Logger.error() << "CGI execution failed with status: " << WEXITSTATUS(status);
-        return createErrorResponse(HTTP_INTERNAL_ERROR, server);
     }
+    return name;
 }
 
 /* @------------------------------------------------------------------------@ */
@@ -1210,6 +1233,16 @@ HttpResponse HttpServer::createErrorResponse(int statusCode, const Config::Serve
             response.setStatus(HTTP_PAYLOAD_TOO_LARGE, "Payload Too Large");
             return response;
         }
+        case HTTP_BAD_GATEWAY: {
+            HttpResponse response = HttpResponse::createInternalError();
+            response.setStatus(HTTP_BAD_GATEWAY, "Bad Gateway");
+            return response;
+        }
+        case HTTP_SERVICE_UNAVAILABLE: {
+            HttpResponse response = HttpResponse::createInternalError();
+            response.setStatus(HTTP_SERVICE_UNAVAILABLE, "Service Unavailable");
+            return response;
+        }
         case HTTP_INTERNAL_ERROR:
         default:
             return HttpResponse::createInternalError();
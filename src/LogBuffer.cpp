@@ -0,0 +1,206 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   LogBuffer.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 19:48:03 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 19:48:03 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "LogBuffer.hpp"
+
+#include <fcntl.h>    // For fcntl
+#include <poll.h>     // For poll
+#include <pthread.h>  // For pthread_create, pthread_join
+#include <sched.h>    // For sched_yield
+#include <signal.h>   // For sigfillset, pthread_sigmask
+#include <unistd.h>   // For pipe, read, write, close
+
+#include <cstddef>  // For std::size_t
+#include <ostream>  // For std::ostream
+#include <sstream>  // For std::ostringstream
+#include <string>   // For std::string
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+// The capacity is rounded up to a power of two so a position maps to its slot with a mask
+LogBuffer::LogBuffer(std::ostream& sink, std::size_t capacity, bool blockWhenFull) :
+    m_Sink(sink),
+    m_Mask(0),
+    m_Tail(0),
+    m_Head(0),
+    m_Dropped(0),
+    m_BlockWhenFull(blockWhenFull),
+    m_WakePending(0),
+    m_Stopping(0),
+    m_Thread(),
+    m_Started(false) {
+    std::size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    m_Slots.resize(size);
+    for (std::size_t i = 0; i < size; i++) {
+        m_Slots[i].sequence = i;
+    }
+    m_Mask = size - 1;
+    m_WakeFds[0] = -1;
+    m_WakeFds[1] = -1;
+}
+
+LogBuffer::~LogBuffer() {
+    stop();
+    for (std::size_t i = 0; i < 2; i++) {
+        if (m_WakeFds[i] >= 0) {
+            close(m_WakeFds[i]);
+        }
+    }
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+bool LogBuffer::start() {
+    if (pipe(m_WakeFds) < 0) {
+        return false;
+    }
+    for (std::size_t i = 0; i < 2; i++) {
+        if (fcntl(m_WakeFds[i], F_SETFL, O_NONBLOCK) < 0 ||
+            fcntl(m_WakeFds[i], F_SETFD, FD_CLOEXEC) < 0) {
+            return false;
+        }
+    }
+    // Signals are left to the event loops: one taken here would never reach their signal fds
+    sigset_t allSignals;
+    sigset_t previous;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_BLOCK, &allSignals, &previous);
+    m_Started = pthread_create(&m_Thread, NULL, &LogBuffer::runThread, this) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    return m_Started;
+}
+
+// Takes the line over, leaving line empty
+void LogBuffer::push(std::string& line) {
+    while (!tryPush(line)) {
+        if (!m_BlockWhenFull) {
+            __atomic_add_fetch(&m_Dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        wake();
+        sched_yield();
+    }
+    // Waking costs a write, so the flush thread is only hurried along once the queue fills up
+    const std::size_t queued =
+        __atomic_load_n(&m_Tail, __ATOMIC_RELAXED) - __atomic_load_n(&m_Head, __ATOMIC_RELAXED);
+    if (queued > m_Mask / 2) {
+        wake();
+    }
+}
+
+// Writes every queued line and waits for the flush thread to finish. Lines pushed afterwards
+// are never written, so every other thread must be done logging by then
+void LogBuffer::stop() {
+    if (!m_Started) {
+        return;
+    }
+    __atomic_store_n(&m_Stopping, 1, __ATOMIC_RELEASE);
+    wake();
+    pthread_join(m_Thread, NULL);
+    m_Started = false;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Private Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// Claims the slot at the tail once the flush thread has emptied it. Returns false when full
+bool LogBuffer::tryPush(std::string& line) {
+    std::size_t position = __atomic_load_n(&m_Tail, __ATOMIC_RELAXED);
+
+    while (true) {
+        Slot&             slot = m_Slots[position & m_Mask];
+        const std::size_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+        if (sequence == position) {
+            if (__atomic_compare_exchange_n(&m_Tail, &position, position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                slot.line.swap(line);
+                __atomic_store_n(&slot.sequence, position + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (sequence < position) {
+            return false;  // Still holds the line pushed one lap earlier
+        } else {
+            position = __atomic_load_n(&m_Tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void LogBuffer::wake() {
+    const char byte = 0;
+    if (__atomic_exchange_n(&m_WakePending, 1, __ATOMIC_ACQ_REL) == 0) {
+        // A full pipe already guarantees a wakeup
+        if (write(m_WakeFds[1], &byte, 1) < 0) {
+            return;
+        }
+    }
+}
+
+void* LogBuffer::runThread(void* buffer) {
+    static_cast<LogBuffer*>(buffer)->run();
+    return NULL;
+}
+
+void LogBuffer::run() {
+    struct pollfd wakeup;
+    char          drain[64];
+
+    wakeup.fd = m_WakeFds[0];
+    wakeup.events = POLLIN;
+    while (true) {
+        const bool stopping = __atomic_load_n(&m_Stopping, __ATOMIC_ACQUIRE) != 0;
+        while (flush()) {
+        }
+        if (stopping) {
+            return;
+        }
+        poll(&wakeup, 1, LOG_FLUSH_MS);
+        __atomic_store_n(&m_WakePending, 0, __ATOMIC_SEQ_CST);
+        while (read(m_WakeFds[0], drain, sizeof(drain)) > 0) {
+        }
+    }
+}
+
+// Writes one batch of queued lines. Returns false once the queue was found empty
+bool LogBuffer::flush() {
+    std::string batch;
+
+    while (batch.length() < LOG_BATCH_BYTES) {
+        Slot& slot = m_Slots[m_Head & m_Mask];
+        if (__atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE) != m_Head + 1) {
+            break;
+        }
+        batch += slot.line;
+        slot.line.clear();
+        __atomic_store_n(&slot.sequence, m_Head + m_Mask + 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&m_Head, m_Head + 1, __ATOMIC_RELAXED);
+    }
+    const std::size_t dropped = __atomic_exchange_n(&m_Dropped, 0, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        std::ostringstream report;
+        report << "[WARN] " << dropped << " log lines dropped, log buffer full\n";
+        batch += report.str();
+    }
+    if (batch.empty()) {
+        return false;
+    }
+    m_Sink.write(batch.data(), static_cast<std::streamsize>(batch.length()));
+    m_Sink.flush();
+    return batch.length() >= LOG_BATCH_BYTES;
+}
@@ -12,11 +12,22 @@
 
 #include "Logger.hpp"
 
+#include <cstddef>   // For std::size_t
 #include <iostream>  // For std::cout
 #include <ostream>   // For std::ostream
+#include <string>    // For std::string
 
+#include "LogBuffer.hpp"
+#include "Mutex.hpp"
 #include "colour.hpp"
 
+// Lines from reactor threads must not interleave on the shared stream
+static Mutex outputMutex;
+
+// Set while lines for asyncSink are queued rather than written by the logging thread
+static LogBuffer*    asyncBuffer = NULL;
+static std::ostream* asyncSink = NULL;
+
 /* @------------------------------------------------------------------------@ */
 /* |                             Logger Section                             | */
 /* @------------------------------------------------------------------------@ */
@@ -63,6 +74,37 @@ Logger::LoggerStream Logger::error() {
     return (LoggerStream(m_Out, "[ERROR] "));
 }
 
+// Hands this logger's stream over to a flush thread holding up to capacity lines. Must be
+// called before other threads start logging; a capacity of 0 keeps writing inline
+bool Logger::startAsync(std::size_t capacity, bool blockWhenFull) {
+    if (capacity == 0 || asyncBuffer != NULL) {
+        return true;
+    }
+    LogBuffer* buffer = new LogBuffer(m_Out, capacity, blockWhenFull);
+    if (!buffer->start()) {
+        delete buffer;
+        warn() << "Failed to start the log flush thread, logging synchronously";
+        return false;
+    }
+    asyncSink = &m_Out;
+    __atomic_store_n(&asyncBuffer, buffer, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Writes out every queued line and goes back to inline writes. Only safe once no other
+// thread logs anymore
+void Logger::stopAsync() {
+    LogBuffer* buffer = __atomic_exchange_n(&asyncBuffer, static_cast<LogBuffer*>(NULL),
+                                            __ATOMIC_ACQ_REL);
+    if (buffer == NULL) {
+        return;
+    }
+    buffer->stop();
+    delete buffer;
+    asyncSink->flush();
+    asyncSink = NULL;
+}
+
 /* @------------------------------------------------------------------------@ */
 /* |                          LoggerStream Section                          | */
 /* @------------------------------------------------------------------------@ */
@@ -70,7 +112,16 @@ Logger::LoggerStream Logger::error() {
 Logger::LoggerStream::LoggerStream(std::ostream& out, const std::string& prefix) :
     m_Out(out), m_Prefix(prefix) {}
 
-Logger::LoggerStream::~LoggerStream() { m_Out << m_Prefix << m_Oss.str() << std::endl; }
+Logger::LoggerStream::~LoggerStream() {
+    std::string line = m_Prefix + m_Oss.str() + '\n';
+    LogBuffer*  buffer = __atomic_load_n(&asyncBuffer, __ATOMIC_ACQUIRE);
+    if (buffer != NULL && &m_Out == asyncSink) {
+        buffer->push(line);
+        return;
+    }
+    MutexLock lock(outputMutex);
+    m_Out << line << std::flush;
+}
 
 Logger::LoggerStream::LoggerStream(const LoggerStream& that) :
     m_Out(that.m_Out), m_Prefix(that.m_Prefix) {}
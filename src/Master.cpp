@@ -0,0 +1,190 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Master.cpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 17:02:11 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 17:02:11 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Master.hpp"
+
+#include <signal.h>  // For sigaction, kill
+#ifdef __linux__
+#include <sys/prctl.h>  // For prctl
+#endif
+#include <sys/wait.h>  // For waitpid
+#include <unistd.h>    // For fork, getpid, getppid, sleep, _exit
+
+#include <csignal>   // For sig_atomic_t
+#include <ctime>     // For time
+#include <iostream>  // For std::cout
+#include <map>       // For std::map
+
+#include "Config.hpp"
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include "Monitor.hpp"
+
+volatile sig_atomic_t Master::s_Stop = 0;
+volatile sig_atomic_t Master::s_Reopen = 0;
+volatile sig_atomic_t Master::s_Dump = 0;
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+Master::Master(const Config& config, const Logger& logger) : m_Config(config), m_Logger(logger) {}
+
+Master::~Master() {}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// Starts the workers and supervises them until a stop signal arrives or one cannot start.
+// Returns the server's exit status
+int Master::run() {
+    struct sigaction stopAction;
+    stopAction.sa_handler = Master::handleStop;
+    sigemptyset(&stopAction.sa_mask);
+    stopAction.sa_flags = 0;  // No SA_RESTART: the signal must interrupt waitpid
+    sigaction(SIGINT, &stopAction, NULL);
+    sigaction(SIGTERM, &stopAction, NULL);
+    stopAction.sa_handler = Master::handleReopen;
+    sigaction(SIGHUP, &stopAction, NULL);
+    stopAction.sa_handler = Master::handleDump;
+    sigaction(SIGUSR1, &stopAction, NULL);
+
+    m_Logger.info() << "Starting " << m_Config.getWorkerProcesses() << " worker processes";
+    for (std::size_t i = 0; i < m_Config.getWorkerProcesses(); i++) {
+        if (!startWorker()) {
+            stopWorkers();
+            return 1;
+        }
+    }
+
+    int exitStatus = 0;
+    while (s_Stop == 0 && !m_Workers.empty()) {
+        int                               status = 0;
+        pid_t                             pid = waitpid(-1, &status, 0);
+        if (s_Reopen != 0) {
+            s_Reopen = 0;
+            signalWorkers(SIGHUP);
+        }
+        if (s_Dump != 0) {
+            s_Dump = 0;
+            signalWorkers(SIGUSR1);
+        }
+        std::map<pid_t, time_t>::iterator it = m_Workers.find(pid);
+        if (pid <= 0 || it == m_Workers.end() || s_Stop != 0) {
+            continue;
+        }
+        const time_t started = it->second;
+        m_Workers.erase(it);
+        Metrics::releaseSlots(pid);  // A killed worker could not give its slots back
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == WORKER_INIT_FAILED) {
+            m_Logger.error() << "Worker process " << pid << " could not start, stopping";
+            exitStatus = 1;
+            break;
+        }
+        if (WIFSIGNALED(status)) {
+            m_Logger.error() << "Worker process " << pid << " killed by signal "
+                             << WTERMSIG(status) << ", restarting";
+        } else {
+            m_Logger.warn() << "Worker process " << pid << " exited with status "
+                            << WEXITSTATUS(status) << ", restarting";
+        }
+        // A worker that dies on startup would otherwise be restarted in a tight loop
+        if (time(NULL) - started < WORKER_RESPAWN_DELAY) {
+            sleep(WORKER_RESPAWN_DELAY);
+        }
+        if (s_Stop == 0 && !startWorker()) {
+            exitStatus = 1;
+            break;
+        }
+    }
+    stopWorkers();
+    m_Logger.info() << "All worker processes stopped";
+    return exitStatus;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Private Methods                            | */
+/* @------------------------------------------------------------------------@ */
+
+void Master::handleStop(int signum) {
+    (void)signum;
+    s_Stop = 1;
+}
+
+void Master::handleReopen(int signum) {
+    (void)signum;
+    s_Reopen = 1;
+}
+
+void Master::handleDump(int signum) {
+    (void)signum;
+    s_Dump = 1;
+}
+
+bool Master::startWorker() {
+    const pid_t masterPid = getpid();
+    pid_t       pid = fork();
+    if (pid < 0) {
+        m_Logger.error() << "Failed to fork a worker process";
+        return false;
+    }
+    if (pid == 0) {
+        runWorker(masterPid);
+    }
+    m_Workers[pid] = time(NULL);
+    m_Logger.info() << "Started worker process " << pid;
+    return true;
+}
+
+// Body of a forked worker; never returns
+void Master::runWorker(pid_t masterPid) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+#ifdef __linux__
+    // A master killed outright cannot stop its workers, so they stop on their own
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+    if (getppid() != masterPid) {
+        _exit(0);
+    }
+
+    // The flush thread is started after fork(): threads do not survive it
+    int status = 0;
+    m_Logger.startAsync(m_Config.getLogBuffer(), m_Config.isLogOverflowBlocking());
+    {
+        Monitor monitor(m_Logger);
+        if (monitor.init(m_Config) < 0) {
+            status = WORKER_INIT_FAILED;
+        } else {
+            monitor.beginLoop();
+        }
+    }
+    Logger::stopAsync();
+    std::cout.flush();
+    _exit(status);
+}
+
+void Master::signalWorkers(int signum) {
+    for (std::map<pid_t, time_t>::iterator it = m_Workers.begin(); it != m_Workers.end(); ++it) {
+        kill(it->first, signum);
+    }
+}
+
+void Master::stopWorkers() {
+    signalWorkers(SIGTERM);
+    for (std::map<pid_t, time_t>::iterator it = m_Workers.begin(); it != m_Workers.end(); ++it) {
+        waitpid(it->first, NULL, 0);
+    }
+    m_Workers.clear();
+}
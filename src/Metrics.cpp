@@ -0,0 +1,209 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Metrics.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 21:12:26 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 21:12:26 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Metrics.hpp"
+
+#include <stdint.h>    // For uint64_t
+#include <sys/mman.h>  // For mmap
+#include <unistd.h>    // For getpid
+
+#include <cstddef>  // For std::size_t
+#include <iomanip>  // For std::setprecision
+#include <sstream>  // For std::ostringstream
+#include <string>   // For std::string
+
+#include "Config.hpp"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+Metrics::Slot* Metrics::s_Slots = NULL;
+std::size_t    Metrics::s_SlotCount = 0;
+
+static const char* const s_StatusClasses[] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+static const char* const s_PhaseNames[] = {"parse", "handle", "send"};
+
+/* @------------------------------------------------------------------------@ */
+/* |                              Slot Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+void Metrics::Slot::countStatus(int status) {
+    if (status >= 100 && status < 600) {
+        add(static_cast<Counter>(REQUESTS_1XX + status / 100 - 1), 1);
+    }
+}
+
+void Metrics::Slot::record(Phase phase, uint64_t micros) {
+    Histogram& histogram = phases[phase];
+    increase(histogram.buckets[getBucket(micros)], 1);
+    increase(histogram.sum, micros);
+    increase(histogram.count, 1);
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// Maps one slot per event loop the server will run, before any worker is forked so they all
+// share it. Does nothing unless a location shows the metrics
+bool Metrics::init(const Config& config) {
+    if (!config.hasMetricsLocation()) {
+        return true;
+    }
+    const std::size_t workers = config.getWorkerProcesses();
+    const std::size_t reactors = config.getReactorThreads();
+    const std::size_t count = (workers > 0 ? workers : 1) * (reactors > 0 ? reactors : 1);
+
+    void* mapping = mmap(NULL, count * sizeof(Slot), PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    s_Slots = static_cast<Slot*>(mapping);  // Zero filled by mmap()
+    s_SlotCount = count;
+    return true;
+}
+
+// Returns a free slot for the calling loop, NULL when metrics are off
+Metrics::Slot* Metrics::claimSlot() {
+    const pid_t self = getpid();
+
+    for (std::size_t i = 0; i < s_SlotCount; i++) {
+        pid_t free = 0;
+        if (__atomic_compare_exchange_n(&s_Slots[i].owner, &free, self, false, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED)) {
+            return &s_Slots[i];
+        }
+    }
+    return NULL;
+}
+
+// Gives the slot back, keeping its counters. Its connections and uploads are gone by then
+void Metrics::releaseSlot(Slot* slot) {
+    if (slot == NULL) {
+        return;
+    }
+    for (std::size_t i = 0; i < GAUGE_COUNT; i++) {
+        __atomic_store_n(&slot->gauges[i], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&slot->owner, 0, __ATOMIC_RELEASE);
+}
+
+// Frees the slots of a worker that died without releasing them
+void Metrics::releaseSlots(pid_t owner) {
+    for (std::size_t i = 0; i < s_SlotCount; i++) {
+        if (__atomic_load_n(&s_Slots[i].owner, __ATOMIC_ACQUIRE) == owner) {
+            releaseSlot(&s_Slots[i]);
+        }
+    }
+}
+
+// Prometheus text exposition format, version 0.0.4
+void Metrics::render(std::string& output) {
+    uint64_t           counters[COUNTER_COUNT] = {0};
+    uint64_t           gauges[GAUGE_COUNT] = {0};
+    std::ostringstream text;
+
+    for (std::size_t i = 0; i < s_SlotCount; i++) {
+        for (std::size_t j = 0; j < COUNTER_COUNT; j++) {
+            counters[j] += load(s_Slots[i].counters[j]);
+        }
+        for (std::size_t j = 0; j < GAUGE_COUNT; j++) {
+            gauges[j] += load(s_Slots[i].gauges[j]);
+        }
+    }
+
+    text << "# HELP webserv_requests_total Responses completed, by status class.\n"
+         << "# TYPE webserv_requests_total counter\n";
+    for (std::size_t i = 0; i < 5; i++) {
+        text << "webserv_requests_total{class=\"" << s_StatusClasses[i] << "\"} "
+             << counters[REQUESTS_1XX + i] << '\n';
+    }
+    text << "# HELP webserv_received_bytes_total Bytes read from clients.\n"
+         << "# TYPE webserv_received_bytes_total counter\n"
+         << "webserv_received_bytes_total " << counters[BYTES_RECEIVED] << '\n'
+         << "# HELP webserv_sent_bytes_total Response bytes sent, counted once a response is done.\n"
+         << "# TYPE webserv_sent_bytes_total counter\n"
+         << "webserv_sent_bytes_total " << counters[BYTES_SENT] << '\n'
+         << "# HELP webserv_cgi_spawns_total CGI scripts and CGI workers started.\n"
+         << "# TYPE webserv_cgi_spawns_total counter\n"
+         << "webserv_cgi_spawns_total " << counters[CGI_SPAWNS] << '\n'
+         << "# HELP webserv_connections_active Open client connections.\n"
+         << "# TYPE webserv_connections_active gauge\n"
+         << "webserv_connections_active " << static_cast<int64_t>(gauges[ACTIVE_CONNECTIONS])
+         << '\n'
+         << "# HELP webserv_uploads_active Request bodies being streamed to a temp file.\n"
+         << "# TYPE webserv_uploads_active gauge\n"
+         << "webserv_uploads_active " << static_cast<int64_t>(gauges[ACTIVE_UPLOADS]) << '\n'
+         << "# HELP webserv_phase_duration_seconds Time spent in each phase of a request.\n"
+         << "# TYPE webserv_phase_duration_seconds histogram\n";
+
+    text << std::fixed << std::setprecision(6);
+    for (std::size_t phase = 0; phase < PHASE_COUNT; phase++) {
+        uint64_t cumulative = 0;
+        uint64_t sum = 0;
+        for (std::size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+            for (std::size_t i = 0; i < s_SlotCount; i++) {
+                cumulative += load(s_Slots[i].phases[phase].buckets[bucket]);
+            }
+            text << "webserv_phase_duration_seconds_bucket{phase=\"" << s_PhaseNames[phase]
+                 << "\",le=\"";
+            if (bucket + 1 < HISTOGRAM_BUCKETS) {
+                text << static_cast<double>(getBucketBound(bucket)) / 1000000;
+            } else {
+                text << "+Inf";
+            }
+            text << "\"} " << cumulative << '\n';
+        }
+        for (std::size_t i = 0; i < s_SlotCount; i++) {
+            sum += load(s_Slots[i].phases[phase].sum);
+        }
+        // The count is the +Inf bucket; reading it separately could disagree with the buckets
+        text << "webserv_phase_duration_seconds_sum{phase=\"" << s_PhaseNames[phase] << "\"} "
+             << static_cast<double>(sum) / 1000000 << '\n'
+             << "webserv_phase_duration_seconds_count{phase=\"" << s_PhaseNames[phase] << "\"} "
+             << cumulative << '\n';
+    }
+    output = text.str();
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Private Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// Values below HISTOGRAM_SUB_BUCKETS are their own bucket. Above, the highest set bit picks the
+// power of two and the two bits below it the quarter within it
+std::size_t Metrics::getBucket(uint64_t micros) {
+    if (micros < HISTOGRAM_SUB_BUCKETS) {
+        return static_cast<std::size_t>(micros);
+    }
+    std::size_t exponent = 2;
+    while (exponent < 63 && (micros >> (exponent + 1)) != 0) {
+        exponent++;
+    }
+    const std::size_t quarter = static_cast<std::size_t>(micros >> (exponent - 2)) & 3;
+    const std::size_t bucket = (exponent - 1) * HISTOGRAM_SUB_BUCKETS + quarter;
+    return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+}
+
+// Largest value that falls into the bucket
+uint64_t Metrics::getBucketBound(std::size_t bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) {
+        return bucket;
+    }
+    const std::size_t exponent = bucket / HISTOGRAM_SUB_BUCKETS + 1;
+    const uint64_t    mantissa = bucket % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS + 1;
+    return (mantissa << (exponent - 2)) - 1;
+}
+
+uint64_t Metrics::load(const uint64_t& value) { return __atomic_load_n(&value, __ATOMIC_RELAXED); }
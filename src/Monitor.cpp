@@ -14,149 +14,383 @@
 
 #include <fcntl.h>
 #include <netinet/in.h>
-#include <sys/poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
-#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <sstream>
 
+#include "Trace.hpp"
 #include "UploadManager.hpp"
 
+volatile sig_atomic_t Monitor::stopRequested = 0;
+int                   Monitor::reopenRequests = 0;
+int                   Monitor::dumpRequests = 0;
+
 Monitor::Monitor(const Logger& newLogger) : logger(newLogger), httpServer(NULL) {
-    this->fds = NULL;
+    this->eventBackend = NULL;
+    this->connectionCount = 0;
+    this->maxConnections = 0;
     this->listenFds = NULL;
     this->listenPorts = NULL;
-    this->connectionPorts = NULL;
     this->listenCount = 0;
-    this->fdCount = 0;
-    this->maxFd = 0;
+    this->childSignalFd = -1;
+    this->handoff = NULL;
+    this->clientCount = 0;
+    this->nextReactor = 0;
+    this->reopenSeen = 0;
+    this->metrics = NULL;
+    this->traceLimit = 0;
+    this->dumpSeen = 0;
 }
 
 Monitor::Monitor() : httpServer(NULL) {
-    this->fds = NULL;
+    this->eventBackend = NULL;
+    this->connectionCount = 0;
+    this->maxConnections = 0;
     this->listenFds = NULL;
     this->listenPorts = NULL;
-    this->connectionPorts = NULL;
     this->listenCount = 0;
-    this->fdCount = 0;
-    this->maxFd = 0;
+    this->childSignalFd = -1;
+    this->handoff = NULL;
+    this->clientCount = 0;
+    this->nextReactor = 0;
+    this->reopenSeen = 0;
+    this->metrics = NULL;
+    this->traceLimit = 0;
+    this->dumpSeen = 0;
 }
 
+// Reactors are stopped first; they use the HttpServer, which only the acceptor deletes
 Monitor::~Monitor() {
-    // Clean up active uploads
-    for (std::map<int, UploadState*>::iterator it = activeUploads.begin();
-         it != activeUploads.end(); ++it) {
-        if (it->second != NULL) {
-            it->second->manager->cleanup();
-            delete it->second;
-        }
-    }
-    activeUploads.clear();
-
-    delete[] this->fds;
+    this->stopReactors();
+    this->cleanPollFds();
+    delete this->eventBackend;
     delete[] this->listenFds;
     delete[] this->listenPorts;
-    delete[] this->connectionPorts;
-    delete this->httpServer;
+    if (this->handoff == NULL) {
+        delete this->httpServer;
+    }
+    Metrics::releaseSlot(this->metrics);
 }
 
 void Monitor::beginLoop() {
     int ready = 0;
 
     for (int i = 0; i < this->listenCount; i++) {
-        this->addPollFd(this->listenFds[i]);
+        this->addPollFd(this->listenFds[i], this->listenPorts[i], Connection::CONNECTION_LISTENER);
+    }
+    if (this->childSignalFd >= 0 &&
+        !this->addPollFd(this->childSignalFd, -1, Connection::CONNECTION_SIGNAL)) {
+        close(this->childSignalFd);
+        this->childSignalFd = -1;
     }
-    while (true) {
-        ready = poll(this->fds, this->fdCount, POLL_WAIT);
+    if (this->handoff != NULL &&
+        !this->addPollFd(this->handoff->getWakeFd(), -1, Connection::CONNECTION_HANDOFF)) {
+        logger.error() << "Failed to register the handoff queue, reactor stopped";
+        return;
+    }
+    // Only the thread that received a stop signal looks at it; reactors run until their
+    // acceptor closes the handoff queue
+    while (this->handoff != NULL || stopRequested == 0) {
+        // Sleep until the next client timeout is due. Without a signal fd, exited CGI children
+        // are only noticed on wakeup, so wake up often enough to reap them
+        int waitTimeout = this->timers.getWaitMs(time(NULL), POLL_WAIT);
+        if (this->childSignalFd < 0 && !this->cgiProcesses.empty() &&
+            waitTimeout > CHILD_POLL_MS) {
+            waitTimeout = CHILD_POLL_MS;
+        }
+        if (this->accessLog.hasPending() && waitTimeout > ACCESS_LOG_CHECK_MS) {
+            waitTimeout = ACCESS_LOG_CHECK_MS;
+        }
+        ready = this->eventBackend->wait(this->readyEvents, waitTimeout);
+        // A SIGHUP or SIGUSR1 interrupts the wait, which is no reason to stop. Only the acceptor
+        // takes them; its reactors notice once woken
+        const bool reopened = this->reopenLogs();
+        const bool dumped = this->dumpTraces();
+        if (reopened || dumped) {
+            this->wakeReactors();
+            if (ready < 0) {
+                continue;
+            }
+        }
         if (ready < 0) {
             break;
         }
         if (ready > 0 && this->eventInit(ready) < 0) {
             break;
         }
+        this->expireTimeouts();
+        this->freeClosedConnections();
+        this->accessLog.flushIfDue(time(NULL));
+        if (this->childSignalFd < 0 && !this->cgiProcesses.empty()) {
+            this->reapChildren();
+        }
     }
     this->cleanPollFds();
 }
 
-void Monitor::addPollFd(const int fdesc) {
-    this->fds[this->fdCount].fd = fdesc;
-    this->fds[this->fdCount].events = POLLIN;
-    this->connectionPorts[this->fdCount] = -1;  // No port assigned
-    this->fdCount++;
-    this->maxFd = std::max(fdesc, this->maxFd);
-}
+bool Monitor::addPollFd(const int fdesc, int port, Connection::Type type, int interest) {
+    if (fdesc < 0) {
+        return false;
+    }
+    if (this->connectionCount >= this->maxConnections) {
+        logger.warn() << "Connection limit reached (" << this->maxConnections
+                      << " fds), refusing fd " << fdesc;
+        return false;
+    }
+
+    // fd numbers are dense, so the table grows with the highest fd ever seen
+    if (static_cast<std::size_t>(fdesc) >= this->connections.size()) {
+        this->connections.resize(static_cast<std::size_t>(fdesc) + 1, NULL);
+    }
 
-void Monitor::addPollFd(const int fdesc, int port) {
-    this->fds[this->fdCount].fd = fdesc;
-    this->fds[this->fdCount].events = POLLIN;
-    this->connectionPorts[this->fdCount] = port;  // Store port for this connection
-    this->fdCount++;
-    this->maxFd = std::max(fdesc, this->maxFd);
+    Connection* connection = new Connection(type, fdesc, port);
+    if (!this->eventBackend->add(fdesc, interest, connection)) {
+        logger.error() << "Failed to register fd " << fdesc << " with "
+                       << this->eventBackend->getName();
+        delete connection;
+        return false;
+    }
+    this->connections[fdesc] = connection;
+    this->connectionCount++;
+    if (type == Connection::CONNECTION_CLIENT) {
+        __atomic_add_fetch(&this->clientCount, 1, __ATOMIC_RELAXED);
+        this->adjustMetric(Metrics::ACTIVE_CONNECTIONS, 1);
+        TRACE_MARK(connection->trace, ACCEPTED);
+        this->scheduleTimeout(connection);
+    }
+    return true;
 }
 
 void Monitor::closePollFd(const int fdesc) {
-    int itr = 0;
-
-    // Clean up any upload state for this file descriptor
-    removeUploadState(fdesc);
-
+    if (this->isPollFd(fdesc) != 0) {
+        Connection* connection = this->connections[fdesc];
+        if (connection->type == Connection::CONNECTION_CLIENT && connection->cgi != NULL) {
+            this->releaseCgi(connection);
+        } else if (connection->type == Connection::CONNECTION_CLIENT &&
+                   connection->fastcgi != NULL) {
+            this->releaseFastCgi(connection);
+        } else if (connection->type == Connection::CONNECTION_CGI_INPUT) {
+            connection->cgi->releaseInputFd();
+        } else if (connection->type == Connection::CONNECTION_CGI_OUTPUT) {
+            connection->cgi->releaseOutputFd();
+        } else if (connection->type == Connection::CONNECTION_FASTCGI) {
+            this->forgetFastCgiConnection(connection);
+        }
+        if (connection->type == Connection::CONNECTION_CLIENT) {
+            __atomic_sub_fetch(&this->clientCount, 1, __ATOMIC_RELAXED);
+            this->adjustMetric(Metrics::ACTIVE_CONNECTIONS, -1);
+            if (connection->upload != NULL) {
+                this->adjustMetric(Metrics::ACTIVE_UPLOADS, -1);
+            }
+            this->logSentResponses(connection, true);
+        }
+        this->eventBackend->remove(fdesc);
+        // Its events may still be queued in this batch; it is freed once the batch is done
+        connection->closed = true;
+        connection->timer.unlink();
+        this->closedConnections.push_back(connection);
+        this->connections[fdesc] = NULL;
+        this->connectionCount--;
+    }
     close(fdesc);
-    while (itr < this->fdCount && fdesc != this->fds[itr].fd) {
-        itr++;
+}
+
+// Drops a connection together with any half-received upload or unsent file it still owns
+void Monitor::destroyConnection(Connection* connection) {
+    if (connection->upload != NULL) {
+        connection->upload->cleanup();
+        delete connection->upload;
     }
-    while (itr + 1 < this->fdCount) {
-        this->fds[itr].fd = this->fds[itr + 1].fd;
-        this->connectionPorts[itr] = this->connectionPorts[itr + 1];  // Keep ports in sync
-        itr++;
+    for (std::size_t i = 0; i < connection->output.size(); i++) {
+        if (connection->output[i].fileFd >= 0) {
+            close(connection->output[i].fileFd);
+        }
     }
-    this->fdCount--;
+    delete connection;
+}
+
+void Monitor::freeClosedConnections() {
+    for (std::size_t i = 0; i < this->closedConnections.size(); i++) {
+        destroyConnection(this->closedConnections[i]);
+    }
+    this->closedConnections.clear();
 }
 
 void Monitor::cleanPollFds() {
-    for (int i = 0; i < this->fdCount; i++) {
-        close(this->fds[i].fd);
-        this->fds[i].fd = -1;
+    // Scripts go first: their pipe entries point at processes their clients own. Queued
+    // FastCGI requests are dropped before that so no released one hands its place to another
+    for (std::map<std::string, FastCgiUpstream>::iterator it = this->fastCgiUpstreams.begin();
+         it != this->fastCgiUpstreams.end(); ++it) {
+        it->second.waiting.clear();
+    }
+    for (std::size_t fdesc = 0; fdesc < this->connections.size(); fdesc++) {
+        Connection* connection = this->connections[fdesc];
+        if (connection == NULL || connection->type != Connection::CONNECTION_CLIENT) {
+            continue;
+        }
+        if (connection->cgi != NULL) {
+            this->releaseCgi(connection);
+        } else if (connection->fastcgi != NULL) {
+            this->releaseFastCgi(connection);
+        }
+        this->logSentResponses(connection, true);
+    }
+    for (std::size_t fdesc = 0; fdesc < this->connections.size(); fdesc++) {
+        if (this->connections[fdesc] != NULL) {
+            if (this->eventBackend != NULL) {
+                this->eventBackend->remove(static_cast<int>(fdesc));
+            }
+            // The handoff queue owns its wake pipe
+            if (this->connections[fdesc]->type != Connection::CONNECTION_HANDOFF) {
+                close(static_cast<int>(fdesc));
+            }
+            destroyConnection(this->connections[fdesc]);
+        }
     }
-    this->fdCount = 0;
-    this->maxFd = -1;
+    this->connections.clear();
+    this->freeClosedConnections();
+    this->connectionCount = 0;
+    __atomic_store_n(&this->clientCount, 0, __ATOMIC_RELAXED);
+    this->fastCgiUpstreams.clear();
 }
 
 int Monitor::isPollFd(const int fdesc) const {
-    for (int i = 0; i < this->fdCount; i++) {
-        if (fdesc == this->fds[i].fd) {
-            return 1;
-        }
+    if (fdesc < 0 || static_cast<std::size_t>(fdesc) >= this->connections.size()) {
+        return 0;
     }
-    return 0;
+    return this->connections[fdesc] != NULL ? 1 : 0;
 }
 
-int Monitor::isListenFd(const int fdesc) const {
-    for (int i = 0; i < this->listenCount; i++) {
-        if (fdesc == listenFds[i]) {
-            return 1;
-        }
+int Monitor::getPortForConnection(const int fdesc) const {
+    if (this->isPollFd(fdesc) == 0) {
+        return -1;
     }
-    return 0;
+    return this->connections[fdesc]->port;
 }
 
-int Monitor::getPortForFd(const int fdesc) const {
-    for (int i = 0; i < this->listenCount; i++) {
-        if (fdesc == listenFds[i]) {
-            return listenPorts[i];
-        }
+// Requests are timed from their first byte when the access log, the metrics or the trace ring
+// need it
+bool Monitor::isTrackingRequests() const {
+    return this->accessLog.isEnabled() || this->metrics != NULL || this->traceLimit > 0;
+}
+
+void Monitor::adjustMetric(Metrics::Gauge gauge, int delta) {
+    if (this->metrics != NULL) {
+        this->metrics->adjust(gauge, delta);
     }
-    return -1;  // Not found
 }
 
-int Monitor::getPortForConnection(const int fdesc) const {
-    for (int i = 0; i < this->fdCount; i++) {
-        if (fdesc == this->fds[i].fd) {
-            return connectionPorts[i];
+// Puts the client's timer on the deadline of the timeout that applies to it now. Clients with no
+// timeout running, such as one waiting for its script, are checked again after TIMEOUT_RECHECK
+void Monitor::scheduleTimeout(Connection* connection) {
+    const char* name = NULL;
+    time_t      deadline = this->getDeadline(connection, name);
+
+    if (deadline == 0) {
+        deadline = time(NULL) + TIMEOUT_RECHECK;
+    }
+    this->timers.schedule(connection->timer, deadline);
+}
+
+// Which timeout applies follows from the connection state: send_timeout while a response is
+// queued, client_body_timeout between two reads of a body, keepalive_timeout between requests
+// and client_header_timeout from the first byte of a request head. Returns 0 if none applies
+time_t Monitor::getDeadline(const Connection* connection, const char*& name) const {
+    std::size_t timeout = 0;
+    time_t      since = connection->lastActivity;
+
+    if (connection->hasPendingOutput()) {
+        name = "send_timeout";
+        timeout = this->config.getSendTimeout();
+    } else if (connection->hasScript()) {
+        return 0;
+    } else if (connection->state == Connection::STATE_READ_BODY) {
+        name = "client_body_timeout";
+        timeout = this->config.getClientBodyTimeout();
+    } else if (connection->readBuffer.empty() && connection->requestCount > 0 &&
+               this->config.getKeepaliveTimeout() > 0) {
+        name = "keepalive_timeout";
+        timeout = this->config.getKeepaliveTimeout();
+    } else {
+        name = "client_header_timeout";
+        timeout = this->config.getClientHeaderTimeout();
+        since = connection->requestStarted;
+    }
+    return timeout > 0 ? since + static_cast<time_t>(timeout) : 0;
+}
+
+// Closes the clients whose timeout ran out, together with any upload or script they own. Timers
+// only move on state changes, so one that fires early is rescheduled on the real deadline
+void Monitor::expireTimeouts() {
+    const time_t      now = time(NULL);
+    TimerWheel::Node* node = NULL;
+
+    this->timers.advance(now);
+    while ((node = this->timers.popExpired()) != NULL) {
+        Connection* connection = static_cast<Connection*>(node->data);
+        const char* name = NULL;
+        time_t      deadline = this->getDeadline(connection, name);
+
+        if (deadline == 0 || deadline > now) {
+            this->scheduleTimeout(connection);
+            continue;
+        }
+        // An idle keep-alive connection running out is routine
+        if (std::strcmp(name, "keepalive_timeout") != 0) {
+            logger.warn() << "Closing fd " << connection->fd << ": " << name << " expired";
         }
+        this->closePollFd(connection->fd);
+    }
+}
+
+// Reopens the access log if a SIGHUP arrived since this loop last looked. Returns whether one did
+bool Monitor::reopenLogs() {
+    const int requests = __atomic_load_n(&reopenRequests, __ATOMIC_RELAXED);
+
+    if (requests == this->reopenSeen) {
+        return false;
+    }
+    this->reopenSeen = requests;
+    if (!this->accessLog.reopen()) {
+        logger.error() << "Failed to reopen access log: " << this->config.getAccessLog();
+    }
+    return true;
+}
+
+// Keeps the trace of a request that is done, dropping the oldest once trace_ring are kept
+void Monitor::keepTrace(const AccessLog::Record &record) {
+    if (this->traces.size() == this->traceLimit) {
+        this->traces.pop_front();
+    }
+    this->traces.push_back(record);
+}
+
+// Logs the traces this loop kept if a SIGUSR1 arrived since it last looked. Returns whether one
+// did
+bool Monitor::dumpTraces() {
+    const int requests = __atomic_load_n(&dumpRequests, __ATOMIC_RELAXED);
+
+    if (requests == this->dumpSeen) {
+        return false;
+    }
+    this->dumpSeen = requests;
+    if (this->traceLimit == 0) {
+        return true;
+    }
+    logger.info() << "Last " << this->traces.size() << " request traces (microseconds from the"
+                  << " first byte):";
+    for (AccessLog::RecordQueue::const_iterator it = this->traces.begin();
+         it != this->traces.end(); ++it) {
+        std::ostringstream trace;
+        Trace::write(trace, it->trace, false);
+        logger.info() << "Trace \"" << it->method << ' ' << it->path << "\" " << it->status << ' '
+                      << trace.str();
     }
-    return -1;
+    return true;
 }
@@ -0,0 +1,345 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MonitorCgi.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 11:42:51 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 11:42:51 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include <signal.h>
+#ifdef __linux__
+#include <sys/signalfd.h>
+#endif
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <map>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "CgiProcess.hpp"
+#include "HttpResponse.hpp"
+#include "Monitor.hpp"
+
+// Takes over the script started for the request just served on client. Its pipes join the
+// connection table so the loop feeds stdin and relays stdout without ever blocking on them.
+// Returns false when the pipes cannot be registered; the caller then releases the process
+bool Monitor::startCgi(Connection *client, CgiProcess *process) {
+    const int outputFd = process->getOutputFd();
+    const int inputFd = process->getInputFd();
+
+    client->cgi = process;
+    process->setClientFd(client->fd);
+    this->cgiProcesses[process->getPid()] = process;
+    if (this->metrics != NULL) {
+        this->metrics->add(Metrics::CGI_SPAWNS, 1);
+    }
+
+    if (!this->addPollFd(outputFd, client->port, Connection::CONNECTION_CGI_OUTPUT)) {
+        return false;
+    }
+    this->connections[outputFd]->cgi = process;
+    if (inputFd < 0) {
+        return true;
+    }
+    if (!this->addPollFd(inputFd, client->port, Connection::CONNECTION_CGI_INPUT,
+                         EventBackend::EVENT_WRITE)) {
+        return false;
+    }
+    this->connections[inputFd]->cgi = process;
+    return true;
+}
+
+// Detaches and deletes the client's script, closing whichever pipes are still open. A script
+// that is still running is killed and stays in cgiProcesses until the loop reaps it
+void Monitor::releaseCgi(Connection *client) {
+    CgiProcess *process = client->cgi;
+
+    client->cgi = NULL;
+    if (this->isPollFd(process->getInputFd()) != 0) {
+        this->closePollFd(process->getInputFd());
+    }
+    if (this->isPollFd(process->getOutputFd()) != 0) {
+        this->closePollFd(process->getOutputFd());
+    }
+    if (!process->hasExited()) {
+        process->terminate();
+        this->cgiProcesses[process->getPid()] = NULL;
+    }
+    delete process;
+}
+
+// Feeds the request body as the pipe accepts it. A script that exits or closes its stdin early
+// shows up as a hangup and simply gets no more input
+void Monitor::eventExecCgiInput(Connection *entry, const EventBackend::Event &event) {
+    if (entry->cgi->writeInput() || event.hangup) {
+        this->closePollFd(entry->fd);
+    }
+}
+
+// Relays what the script wrote to its client. End of file completes the response once the
+// child has also been reaped, whichever of the two is noticed first
+void Monitor::eventExecCgiOutput(Connection *entry) {
+    CgiProcess *process = entry->cgi;
+    Connection *client = this->connections[process->getClientFd()];
+    const int   clientFd = client->fd;
+    const bool  wasPending = client->hasPendingOutput();
+    char        buffer[CGI_BUFFER_SIZE];
+
+    // Edge-triggered fds report new data only once, so drain the pipe before yielding
+    const bool drain = this->eventBackend->isEdgeTriggered();
+    bool       relayed = false;
+    bool       finished = false;
+    do {
+        ssize_t bytesRead = read(entry->fd, buffer, sizeof(buffer));
+        if (bytesRead <= 0) {
+            finished = bytesRead == 0;
+            break;
+        }
+        this->relayOutput(client, buffer, static_cast<std::size_t>(bytesRead));
+        relayed = true;
+    } while (drain && !isRelayBacklogged(client));
+
+    if (finished) {
+        this->closePollFd(entry->fd);
+    }
+    if (relayed) {
+        this->sendRelayedOutput(client, wasPending);
+    }
+    // Sending may have found the client gone, taking the process with it
+    if (this->isPollFd(clientFd) == 0) {
+        return;
+    }
+    if (!finished) {
+        // A client that falls behind pauses the script's pipe until it catches up
+        if (isRelayBacklogged(client) && !process->isOutputPaused()) {
+            this->eventBackend->remove(entry->fd);
+            process->setOutputPaused(true);
+        }
+        return;
+    }
+    if (process->hasExited()) {
+        this->finishCgi(process);
+    } else {
+        this->reapChildren();
+    }
+}
+
+// The client drained its output; read from the script again
+void Monitor::resumeCgiOutput(CgiProcess *process) {
+    const int outputFd = process->getOutputFd();
+
+    if (process->isOutputPaused() && outputFd >= 0) {
+        this->eventBackend->add(outputFd, EventBackend::EVENT_READ, this->connections[outputFd]);
+        process->setOutputPaused(false);
+    }
+}
+
+// Completes the client's response once the script closed its output and exited
+void Monitor::finishCgi(CgiProcess *process) {
+    Connection *client = this->connections[process->getClientFd()];
+    const bool  succeeded = process->succeeded();
+
+    if (succeeded) {
+        logger.info() << "CGI process " << process->getPid() << " exited successfully";
+    } else {
+        logger.error() << "CGI process " << process->getPid() << " failed";
+    }
+    this->releaseCgi(client);
+    this->finishRelay(client, succeeded ? 0 : HTTP_INTERNAL_ERROR);
+}
+
+// Drains the signal fd; which children exited is learned from waitpid()
+void Monitor::eventExecChildSignal(Connection *entry) {
+#ifdef __linux__
+    struct signalfd_siginfo info;
+    while (read(entry->fd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+    }
+#else
+    (void)entry;
+#endif
+    // The acceptor has no scripts of its own; each reactor reaps its children when woken
+    if (!this->reactors.empty()) {
+        this->wakeReactors();
+        return;
+    }
+    this->reapChildren();
+}
+
+// Collects every exited child without blocking. Scripts whose client is gone were already
+// deleted and only need reaping. Children are waited for by pid, never with -1: reactor threads
+// share the process and must not collect each other's scripts
+void Monitor::reapChildren() {
+    std::vector<std::pair<pid_t, int> > exited;
+    int                                 status = 0;
+
+    for (std::map<pid_t, CgiProcess *>::iterator it = this->cgiProcesses.begin();
+         it != this->cgiProcesses.end(); ++it) {
+        if (waitpid(it->first, &status, WNOHANG) == it->first) {
+            exited.push_back(std::make_pair(it->first, status));
+        }
+    }
+    // Finishing a script may release others, so the map is only changed once the scan is done
+    for (std::size_t i = 0; i < exited.size(); i++) {
+        std::map<pid_t, CgiProcess *>::iterator it = this->cgiProcesses.find(exited[i].first);
+        if (it == this->cgiProcesses.end()) {
+            continue;
+        }
+        CgiProcess *process = it->second;
+        this->cgiProcesses.erase(it);
+        if (process == NULL) {
+            continue;
+        }
+        process->setExitStatus(exited[i].second);
+        if (process->getOutputFd() < 0) {
+            this->finishCgi(process);
+        }
+    }
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                          Script Output Relay                           | */
+/* @------------------------------------------------------------------------@ */
+
+// Output of a CGI script or a FastCGI upstream is relayed to the client as it arrives. It is
+// held back only until the script's header block is complete, which becomes the response head
+void Monitor::relayOutput(Connection *client, const char *data, std::size_t length) {
+    client->lastActivity = time(NULL);
+    if (client->relayStarted) {
+        appendRelayBody(client, data, length);
+    } else if (client->relay.parse(data, length)) {
+        this->startRelay(client);
+    }
+}
+
+// Queues the head built from the script's headers, followed by the body bytes that arrived
+// with them
+void Monitor::startRelay(Connection *client) {
+    HttpResponse httpResponse(HTTP_OK, this->logger);
+    std::string  body;
+
+    client->relay.apply(httpResponse);
+    if (client->relayChunked) {
+        httpResponse.setHeader("Transfer-Encoding", "chunked");
+    }
+    this->setConnectionHeaders(client, httpResponse, !client->closeAfterWrite);
+    client->output.push_back(QueuedResponse());
+    httpResponse.serializeHead(client->output.back().head);
+    TRACE_MARK(client->access.trace, SERIALIZED);
+    client->bytesQueued += client->output.back().head.length();
+    client->access.status = httpResponse.getStatusCode();
+    client->relayStarted = true;
+
+    client->relay.takeBody(body);
+    if (!body.empty()) {
+        appendRelayBody(client, body.data(), body.length());
+    }
+}
+
+// Appends body bytes, as one chunk when the body is chunked. What the socket already took is
+// compacted away first, so a relay that keeps up with its script uses constant memory
+void Monitor::appendRelayBody(Connection *client, const char *data, std::size_t length) {
+    if (client->output.empty() || client->output.back().fileFd >= 0) {
+        client->output.push_back(QueuedResponse());
+    }
+    QueuedResponse &response = client->output.back();
+    response.compact();
+    const std::size_t queued = response.body.length();
+    if (!client->relayChunked) {
+        response.body.append(data, length);
+    } else {
+        std::ostringstream size;
+        size << std::hex << length << "\r\n";
+        response.body += size.str();
+        response.body.append(data, length);
+        response.body += "\r\n";
+    }
+    client->bytesQueued += response.body.length() - queued;
+}
+
+// Sends relayed output right away unless the client is already waiting for writability. The
+// client may turn out to be gone, in which case it is closed along with its script
+void Monitor::sendRelayedOutput(Connection *client, bool wasPending) {
+    const int fdesc = client->fd;
+
+    if (wasPending) {
+        return;
+    }
+    FlushResult flushResult = flushConnection(client);
+    this->logSentResponses(client, false);
+    if (flushResult == Monitor::FLUSH_ERROR ||
+        (flushResult == Monitor::FLUSH_PENDING &&
+         !this->eventBackend->modify(fdesc, EventBackend::EVENT_WRITE, client))) {
+        this->closePollFd(fdesc);
+        return;
+    }
+    this->scheduleTimeout(client);
+}
+
+// Whether the client has fallen CGI_OUTPUT_LIMIT behind the script it is relaying
+bool Monitor::isRelayBacklogged(const Connection *client) {
+    return !client->output.empty() && client->output.back().unsent() >= CGI_OUTPUT_LIMIT;
+}
+
+// Completes a relayed response once its script is done and detached from the client. A script
+// that failed before its header block was complete is answered from failureStatus alone, 0
+// meaning success; one that fails later leaves the client a truncated body and no connection
+void Monitor::finishRelay(Connection *client, int failureStatus) {
+    const bool wasPending = client->hasPendingOutput();
+
+    if (!client->relayStarted && failureStatus == 0) {
+        client->relay.finish();
+        this->startRelay(client);
+    }
+    if (!client->relayStarted) {
+        HttpResponse httpResponse =
+            this->httpServer->createErrorResponse(failureStatus, client->port);
+        this->setConnectionHeaders(client, httpResponse, !client->closeAfterWrite);
+        queueResponse(client, httpResponse);
+        client->access.status = httpResponse.getStatusCode();
+    } else if (failureStatus != 0 || !client->relayChunked) {
+        client->closeAfterWrite = true;
+    } else {
+        appendRelayBody(client, "", 0);  // The empty chunk that ends the body
+    }
+    queueAccessRecord(client, client->access.status);
+    client->relay.clear();
+    client->relayStarted = false;
+
+    if (wasPending) {
+        return;
+    }
+    FlushResult flushResult = flushConnection(client);
+    this->logSentResponses(client, false);
+    if (flushResult == Monitor::FLUSH_ERROR ||
+        (flushResult == Monitor::FLUSH_DONE && client->closeAfterWrite)) {
+        this->closePollFd(client->fd);
+        return;
+    }
+    // The rest goes out on writability, and the write handler serves what is pipelined behind it
+    if (flushResult == Monitor::FLUSH_PENDING) {
+        if (!this->eventBackend->modify(client->fd, EventBackend::EVENT_WRITE, client)) {
+            this->closePollFd(client->fd);
+            return;
+        }
+        this->scheduleTimeout(client);
+        return;
+    }
+    // Everything is sent: wait for the next request, serving any already pipelined right away
+    const int fdesc = client->fd;
+    int       ready = 0;
+    if (!this->eventBackend->modify(fdesc, EventBackend::EVENT_READ, client)) {
+        this->closePollFd(fdesc);
+        return;
+    }
+    this->processConnection(client, ready);
+    if (this->connections[fdesc] == client) {
+        this->scheduleTimeout(client);
+    }
+}
@@ -13,327 +13,439 @@
 #include <fcntl.h>
 #include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#include <unistd.h>
 
+#include <algorithm>  // For std::min
 #include <cstddef>
 #include <cstring>  // For strerror
+#include <ctime>
 #include <iostream>
+#include <sstream>
 #include <string>
 
+#include "CgiProcess.hpp"
 #include "HttpRequest.hpp"
 #include "HttpResponse.hpp"
 #include "Monitor.hpp"
 #include "UploadManager.hpp"
 
-static std::size_t stringToNumber(const std::string &str) {
-    const std::size_t decimal = 10;
-    std::size_t       result = 0;
-    for (std::size_t i = 0; i < str.length(); ++i) {
-        char c = str[i];
-        if (c >= '0' && c <= '9') {
-            result = result * decimal + (c - '0');
-        } else {
-            break;
-        }
-    }
-    return result;
-}
+// Only the fallback file path uses send(); SIGPIPE is ignored for writev() and sendfile()
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
 
 int Monitor::eventInit(int ready) {
-    for (int i = 0; ready > 0 && i <= this->maxFd; i++) {
-        if (this->isPollFd(i) == 0) {
+    // Only ready fds are reported; each event carries its Connection, so no lookup is needed
+    for (std::size_t i = 0; i < this->readyEvents.size(); i++) {
+        // An earlier event of the batch may have closed the entry; it is not freed yet
+        if (static_cast<Connection *>(this->readyEvents[i].data)->closed) {
             continue;
         }
-        if (this->eventExec(i, ready) < 0) {
+        if (this->eventExec(this->readyEvents[i], ready) < 0) {
             return -1;
         }
     }
     return 0;
 }
 
-int Monitor::eventExec(const int fdesc, int &ready) {
-    ExecResult result = this->eventExecType(fdesc, ready);
+int Monitor::eventExec(const EventBackend::Event &event, int &ready) {
+    ExecResult result = this->eventExecType(event, ready);
     if (result == Monitor::EXEC_FATAL_ERROR) {
         return -1;
     }
     return 0;
 }
 
-Monitor::ExecResult Monitor::eventExecType(const int fdesc, int &ready) {
-    if (this->isListenFd(fdesc) == 1) {
-        return this->eventExecConnection(fdesc, ready);
+Monitor::ExecResult Monitor::eventExecType(const EventBackend::Event &event, int &ready) {
+    Connection *connection = static_cast<Connection *>(event.data);
+
+    switch (connection->type) {
+        case Connection::CONNECTION_LISTENER:
+            return this->eventExecConnection(connection, ready);
+        case Connection::CONNECTION_CGI_INPUT:
+            this->eventExecCgiInput(connection, event);
+            return Monitor::EXEC_SUCCESS;
+        case Connection::CONNECTION_CGI_OUTPUT:
+            this->eventExecCgiOutput(connection);
+            return Monitor::EXEC_SUCCESS;
+        case Connection::CONNECTION_SIGNAL:
+            this->eventExecChildSignal(connection);
+            return Monitor::EXEC_SUCCESS;
+        case Connection::CONNECTION_FASTCGI:
+            this->eventExecFastCgi(connection, event);
+            return Monitor::EXEC_SUCCESS;
+        case Connection::CONNECTION_HANDOFF:
+            return this->eventExecHandoff(connection);
+        case Connection::CONNECTION_CLIENT:
+            break;
+    }
+    const int  fdesc = connection->fd;
+    ExecResult result = this->eventExecRequest(connection, event, ready);
+    // The event may have moved the client on to another timeout
+    if (this->connections[fdesc] == connection) {
+        this->scheduleTimeout(connection);
     }
-    return this->eventExecRequest(fdesc, ready);
+    return result;
 }
 
-Monitor::ExecResult Monitor::eventExecConnection(const int fdesc, int &ready) {
-    int newFd = 0;
-    int accepted = 0;
+// Takes at most accept_batch connections per wakeup so a burst of new clients cannot starve the
+// established ones. A level triggered listener is reported again while connections are left; an
+// edge-triggered one is re-armed, which makes the next wait report it again if any are queued
+Monitor::ExecResult Monitor::eventExecConnection(Connection *listener, int &ready) {
+    const std::size_t batch = this->config.getAcceptBatch();
+    std::size_t       accepted = 0;
 
-    while (true) {
-        newFd = accept(fdesc, NULL, NULL);
+    while (accepted < batch) {
+        int newFd = acceptClient(listener->fd);
         // Subject forbids checking errno after I/O operations
         // Simply handle negative return from accept() without errno checking
         if (newFd < 0) {
             break;
         }
-        if (fcntl(newFd, F_SETFL, O_NONBLOCK) < 0) {
-            return Monitor::EXEC_FATAL_ERROR;
-        }
         if (accepted == 0) {
             ready--;
-            accepted = 1;
         }
-        int listenPort = this->getPortForFd(fdesc);
-        this->addPollFd(newFd, listenPort);
+        accepted++;
+        if (!this->reactors.empty()) {
+            this->handOff(newFd, listener->port);
+        } else if (!this->addPollFd(newFd, listener->port, Connection::CONNECTION_CLIENT)) {
+            close(newFd);
+        }
+    }
+    if (accepted == batch && this->eventBackend->isEdgeTriggered() &&
+        !this->eventBackend->modify(listener->fd, EventBackend::EVENT_READ, listener)) {
+        return Monitor::EXEC_FATAL_ERROR;
     }
     return Monitor::EXEC_SUCCESS;
 }
 
-Monitor::ExecResult Monitor::eventExecRequest(const int fdesc, int &ready) {
-    // Check if this file descriptor has an ongoing upload
-    UploadState *uploadState = getUploadState(fdesc);
-    if (uploadState != NULL) {
-        return continueUpload(fdesc, ready);
+// Returns a non-blocking, close-on-exec client socket, or -1 once none is waiting. accept4() sets
+// both flags atomically, so a CGI child forked by another reactor meanwhile cannot inherit it
+int Monitor::acceptClient(int listenFd) {
+#ifdef __linux__
+    return accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    int newFd = accept(listenFd, NULL, NULL);
+    // Close-on-exec keeps CGI children from holding client sockets open
+    if (newFd >= 0 &&
+        (fcntl(newFd, F_SETFL, O_NONBLOCK) < 0 || fcntl(newFd, F_SETFD, FD_CLOEXEC) < 0)) {
+        close(newFd);
+        return -1;
     }
-
-    std::string rawRequest = readHttpRequest(fdesc);
-
-    return processHttpRequest(fdesc, rawRequest, ready);
+    return newFd;
+#endif
 }
 
-Monitor::ExecResult Monitor::handleLargeUpload(const int fdesc, const std::string &rawRequest,
-                                               const UploadInfo &uploadInfo, int &ready) {
-    Logger logger(std::cout, true);
+Monitor::ExecResult Monitor::eventExecRequest(Connection *connection,
+                                              const EventBackend::Event &event, int &ready) {
+    // Reading is paused while a response is queued; only writability matters then
+    if (connection->hasPendingOutput()) {
+        return this->eventExecWrite(connection, event, ready);
+    }
 
-    // Create UploadManager for streaming
-    UploadManager *uploadManager = new UploadManager(logger);
-    if (!uploadManager->startLargeUpload(uploadInfo.totalContentLength)) {
-        logger.error() << "Failed to start large upload streaming";
-        delete uploadManager;
+    const int  fdesc = connection->fd;
+    ReadResult readResult = readConnection(connection);
+    // A reset peer fails recv() instead of reporting end of file
+    if (readResult == Monitor::READ_AGAIN && event.hangup) {
+        readResult = Monitor::READ_PEER_CLOSED;
+    }
+    if (readResult == Monitor::READ_SINK_ERROR) {
         this->closePollFd(fdesc);
         return Monitor::EXEC_SUCCESS;
     }
 
-    // Extract any body data already received
-    std::size_t bodyStart = uploadInfo.headerEndPos + 4;
-    std::size_t alreadyReceived = 0;
-    if (rawRequest.length() > bodyStart) {
-        alreadyReceived = rawRequest.length() - bodyStart;
-        const char *bodyData = rawRequest.data() + bodyStart;
-
-        if (!uploadManager->writeChunk(bodyData, alreadyReceived)) {
-            logger.error() << "Failed to write initial body chunk to disk";
-            uploadManager->cleanup();
-            delete uploadManager;
+    ExecResult result = processConnection(connection, ready);
+    if (readResult == Monitor::READ_PEER_CLOSED && this->connections[fdesc] == connection) {
+        if (connection->state == Connection::STATE_READ_BODY) {
+            logger.warn() << "Connection closed while reading body ("
+                          << connection->request.getBodyRemaining() << " of "
+                          << connection->request.getContentLength() << " bytes missing)";
+        }
+        // A half-closed client still gets the responses it is owed, but a client that goes away
+        // while its CGI script or FastCGI request runs abandons it
+        if (!connection->hasPendingOutput() || connection->hasScript()) {
             this->closePollFd(fdesc);
-            return Monitor::EXEC_SUCCESS;
+        } else {
+            connection->closeAfterWrite = true;
         }
     }
+    return result;
+}
 
-    // Create upload state and add to tracking
-    UploadState *state =
-        new UploadState(uploadManager, alreadyReceived, uploadInfo.totalContentLength, rawRequest);
-    addUploadState(fdesc, state);
-
-    logger.info() << "Large upload started, received " << alreadyReceived << "/"
-                  << uploadInfo.totalContentLength << " bytes initially";
+Monitor::ExecResult Monitor::eventExecWrite(Connection *connection,
+                                            const EventBackend::Event &event, int &ready) {
+    const int fdesc = connection->fd;
 
-    ready--;
-    return Monitor::EXEC_SUCCESS;
+    FlushResult flushResult = flushConnection(connection);
+    this->logSentResponses(connection, false);
+    if (flushResult == Monitor::FLUSH_PENDING && !event.hangup) {
+        return Monitor::EXEC_SUCCESS;
+    }
+    // A hung up peer will never drain the rest
+    if (flushResult != Monitor::FLUSH_DONE) {
+        this->closePollFd(fdesc);
+        return Monitor::EXEC_SUCCESS;
+    }
+    if ((connection->closeAfterWrite && !connection->hasScript()) ||
+        !this->eventBackend->modify(fdesc, EventBackend::EVENT_READ, connection)) {
+        this->closePollFd(fdesc);
+        return Monitor::EXEC_SUCCESS;
+    }
+    if (connection->cgi != NULL) {
+        this->resumeCgiOutput(connection->cgi);
+    } else if (connection->fastcgi != NULL) {
+        this->resumeFastCgiOutput(connection->fastcgi);
+    }
+    // Requests pipelined behind the drained response are still waiting in the read buffer
+    return processConnection(connection, ready);
 }
 
-std::string Monitor::readHttpRequest(int fdesc) {
-    ssize_t     bytesRead = 1;
-    char        buffer[BUFFER_SIZE + 1];
-    std::string rawRequest;
+// Takes a single recv per readiness event so one busy client cannot hold the loop; the level
+// triggered backend reports the fd again while data is left
+Monitor::ReadResult Monitor::readConnection(Connection *connection) {
+    char buffer[BUFFER_SIZE];
 
-    while (bytesRead != 0) {
-        bytesRead = recv(fdesc, buffer, BUFFER_SIZE, 0);
+    // Edge-triggered fds report new data only once, so drain the socket before yielding
+    const bool drain = this->eventBackend->isEdgeTriggered();
+    do {
+        ssize_t bytesRead = recv(connection->fd, buffer, BUFFER_SIZE, 0);
+        if (bytesRead == 0) {
+            return Monitor::READ_PEER_CLOSED;
+        }
         if (bytesRead < 0) {
-            break;
+            return Monitor::READ_AGAIN;
         }
-        buffer[bytesRead] = '\0';
-        rawRequest += buffer;
-
-        std::size_t headerEndPos = rawRequest.find("\r\n\r\n");
-        if (headerEndPos != std::string::npos) {
-            std::size_t totalContentLength;
-            std::string fullRequest = rawRequest;
-            if (processContentLength(rawRequest, headerEndPos, totalContentLength, fullRequest,
-                                     fdesc)) {
-                return fullRequest;
+        connection->lastActivity = time(NULL);
+        if (connection->state == Connection::STATE_READ_HEADERS &&
+            connection->readBuffer.empty()) {
+            connection->requestStarted = connection->lastActivity;
+            if (this->isTrackingRequests()) {
+                connection->requestBegan = AccessLog::now();
             }
-            break;
+            TRACE_MARK(connection->trace, FIRST_BYTE);
+        }
+        if (this->metrics != NULL) {
+            this->metrics->add(Metrics::BYTES_RECEIVED, static_cast<uint64_t>(bytesRead));
         }
-    }
 
-    return rawRequest;
+        // Body bytes skip the read buffer and go straight to their sink; only what follows the
+        // body (a pipelined request) is buffered
+        std::size_t length = static_cast<std::size_t>(bytesRead);
+        std::size_t used = 0;
+        if (connection->state == Connection::STATE_READ_BODY && connection->readBuffer.empty() &&
+            !deliverBody(connection, buffer, length, used)) {
+            return Monitor::READ_SINK_ERROR;
+        }
+        connection->readBuffer.append(buffer + used, length - used);
+    } while (drain);
+    return Monitor::READ_AGAIN;
 }
 
-bool Monitor::processContentLength(const std::string &rawRequest, std::size_t headerEndPos,
-                                   std::size_t &totalContentLength, std::string &fullRequest,
-                                   int fdesc) {
-    std::string headersSection = rawRequest.substr(0, headerEndPos);
-    std::size_t contentLengthPos = headersSection.find("Content-Length:");
-
-    if (contentLengthPos == std::string::npos) {
-        return false;
-    }
-
-    std::size_t valueStart = contentLengthPos + CONTENT_LENGTH_HEADER;
-    std::size_t lineEnd = headersSection.find("\r\n", valueStart);
-
-    if (lineEnd == std::string::npos) {
-        return false;
-    }
-
-    std::string lengthStr = headersSection.substr(valueStart, lineEnd - valueStart);
-
-    while (!lengthStr.empty() && lengthStr[0] == ' ') {
-        lengthStr = lengthStr.substr(1);
-    }
-    while (!lengthStr.empty() && lengthStr[lengthStr.length() - 1] == ' ') {
-        lengthStr = lengthStr.substr(0, lengthStr.length() - 1);
-    }
+// Advances the connection state machine as far as the buffered bytes allow. Every complete
+// request is answered in order, so pipelined requests need no further readiness event; their
+// responses are sent in batches, and a batch the socket cannot take at once suspends the
+// machine until it has been sent. So does a request handed to a CGI script, until the script's
+// output has been relayed
+Monitor::ExecResult Monitor::processConnection(Connection *connection, int &ready) {
+    const int fdesc = connection->fd;
 
-    totalContentLength = stringToNumber(lengthStr);
-    std::size_t bodyStart = headerEndPos + 4;
-    std::size_t currentBodySize = rawRequest.length() - bodyStart;
-
-    if (currentBodySize < totalContentLength) {
-        char        buffer[BUFFER_SIZE + 1];
-        std::string completeRequest = rawRequest;
+    while (true) {
+        if (connection->hasScript()) {
+            return Monitor::EXEC_SUCCESS;
+        }
+        ServeResult serveResult = serveBufferedRequests(connection, ready);
+        if (serveResult == Monitor::SERVE_CLOSE) {
+            this->closePollFd(fdesc);
+            return Monitor::EXEC_SUCCESS;
+        }
+        if (!connection->hasPendingOutput()) {
+            return Monitor::EXEC_SUCCESS;
+        }
 
-        while (currentBodySize < totalContentLength) {
-            ssize_t moreBytesRead = recv(fdesc, buffer, BUFFER_SIZE, 0);
-            if (moreBytesRead <= 0) {
-                if (moreBytesRead == 0) {
-                    logger.warn() << "Connection closed while reading body";
-                } else {
-                    logger.warn() << "Error reading body data (subject forbids errno checking)";
-                }
-                break;
+        FlushResult flushResult = flushConnection(connection);
+        this->logSentResponses(connection, false);
+        if (flushResult == Monitor::FLUSH_PENDING) {
+            // The rest goes out on writability, which also holds back further requests
+            if (!this->eventBackend->modify(fdesc, EventBackend::EVENT_WRITE, connection)) {
+                this->closePollFd(fdesc);
             }
-            buffer[moreBytesRead] = '\0';
-            completeRequest += buffer;
-            currentBodySize = completeRequest.length() - bodyStart;
+            return Monitor::EXEC_SUCCESS;
+        }
+        // A closing request served by a script is still running; the relay closes it when done
+        if (flushResult == Monitor::FLUSH_ERROR ||
+            (connection->closeAfterWrite && !connection->hasScript())) {
+            this->closePollFd(fdesc);
+            return Monitor::EXEC_SUCCESS;
+        }
+        if (serveResult == Monitor::SERVE_NEED_INPUT) {
+            return Monitor::EXEC_SUCCESS;
         }
-        fullRequest = completeRequest;
     }
-
-    return true;
 }
 
-Monitor::ExecResult Monitor::processHttpRequest(int fdesc, const std::string &rawRequest,
-                                                int &ready) {
-    // Check for large upload first
-    std::size_t headerEndPos = rawRequest.find("\r\n\r\n");
-    if (headerEndPos != std::string::npos) {
-        std::size_t contentLengthPos = rawRequest.find("Content-Length:");
-        if (contentLengthPos != std::string::npos && contentLengthPos < headerEndPos) {
-            std::size_t contentLength = extractContentLength(rawRequest, contentLengthPos);
-            if (UploadManager::isLargeFile(contentLength)) {
-                logger.info() << "Large upload detected (" << contentLength
-                              << " bytes), using streaming to disk";
-                Monitor::HeaderPosition headerPos(headerEndPos);
-                Monitor::ContentLength  contentLen(contentLength);
-                UploadInfo              uploadInfo(headerPos, contentLen);
-                return handleLargeUpload(fdesc, rawRequest, uploadInfo, ready);
+// Answers the complete requests in the read buffer until more input is needed or a batch of
+// responses is ready to be sent
+Monitor::ServeResult Monitor::serveBufferedRequests(Connection *connection, int &ready) {
+    std::string &readBuffer = connection->readBuffer;
+
+    while (true) {
+        if (connection->state == Connection::STATE_READ_HEADERS) {
+            HttpRequest::ParseStatus status =
+                connection->request.feed(readBuffer.data(), readBuffer.length());
+            if (status == HttpRequest::PARSE_ERROR) {
+                // Answered with 400 and a close; the stream cannot be resynchronized afterwards
+                readBuffer.clear();
+            } else if (status == HttpRequest::PARSE_COMPLETE) {
+                TRACE_MARK(connection->trace, HEADERS_PARSED);
+                readBuffer.erase(0, connection->request.getRequestLength());
+            } else if (!connection->request.isHeaderComplete()) {
+                return Monitor::SERVE_NEED_INPUT;
+            } else {
+                // The parser keeps its own copy of the head; the body is routed from here on
+                TRACE_MARK(connection->trace, HEADERS_PARSED);
+                readBuffer.erase(0, connection->request.getHeaderLength());
+                if (!beginRequestBody(connection)) {
+                    return Monitor::SERVE_CLOSE;
+                }
             }
         }
-    }
-
-    // Process regular request
-    HttpRequest httpRequest;
-    httpRequest.parse(rawRequest);
 
-    HttpResponse httpResponse = generateHttpResponse(httpRequest, fdesc);
-    sendHttpResponse(fdesc, httpResponse);
-
-    ready--;
-    this->closePollFd(fdesc);
-    return Monitor::EXEC_SUCCESS;
-}
-
-Monitor::ExecResult Monitor::streamRemainingData(int fdesc, UploadManager &uploadManager,
-                                                 std::size_t &totalReceived,
-                                                 std::size_t  totalContentLength) {
-    char      buffer[UPLOAD_BUFFER_SIZE];
-    Logger    logger(std::cout, true);
-    int       consecutiveFailures = 0;
-    const int maxConsecutiveFailures = 50000;  // Allow more retries for large uploads
-
-    while (totalReceived < totalContentLength && consecutiveFailures < maxConsecutiveFailures) {
-        ssize_t bytesRead = recv(fdesc, buffer, UPLOAD_BUFFER_SIZE, 0);
-        if (bytesRead <= 0) {
-            if (bytesRead == 0) {
-                logger.warn() << "Connection closed during large upload (received " << totalReceived
-                              << "/" << totalContentLength << " bytes)";
-                uploadManager.cleanup();
-                this->closePollFd(fdesc);
-                return Monitor::EXEC_SUCCESS;
+        if (connection->state == Connection::STATE_READ_BODY) {
+            std::size_t used = 0;
+            if (!deliverBody(connection, readBuffer.data(), readBuffer.length(), used)) {
+                return Monitor::SERVE_CLOSE;
+            }
+            readBuffer.erase(0, used);
+            if (!connection->request.isComplete()) {
+                return Monitor::SERVE_NEED_INPUT;
             }
-            // recv() returned -1, which could be EAGAIN/EWOULDBLOCK or real error
-            // Subject forbids checking errno after I/O operations
-            // For non-blocking sockets, this typically means no more data available now
-            // Increment consecutive failure count to prevent infinite loops
-            consecutiveFailures++;
-            continue;
         }
 
-        // Reset consecutive failure count on successful read
-        consecutiveFailures = 0;
-
-        std::size_t bytesToWrite = static_cast<std::size_t>(bytesRead);
-        if (totalReceived + bytesToWrite > totalContentLength) {
-            bytesToWrite = totalContentLength - totalReceived;
+        if (!serveRequest(connection, ready)) {
+            return Monitor::SERVE_CLOSE;
         }
-
-        if (!uploadManager.writeChunk(buffer, bytesToWrite)) {
-            logger.error() << "Failed to write chunk to disk during large upload";
-            uploadManager.cleanup();
-            this->closePollFd(fdesc);
-            return Monitor::EXEC_SUCCESS;
+        // Nothing may follow a closing response or a running script, and a file body is worth
+        // sending on its own
+        if (connection->closeAfterWrite || connection->hasScript() ||
+            connection->output.size() >= OUTPUT_BATCH || connection->output.back().fileFd >= 0) {
+            return Monitor::SERVE_FLUSH;
         }
-
-        totalReceived += bytesToWrite;
     }
+}
 
-    // Check if upload completed successfully
-    if (totalReceived >= totalContentLength) {
-        return Monitor::EXEC_SUCCESS;
+bool Monitor::beginRequestBody(Connection *connection) {
+    std::size_t contentLength = connection->request.getContentLength();
+
+    connection->state = Connection::STATE_READ_BODY;
+    if (!UploadManager::isLargeFile(contentLength)) {
+        return true;
     }
 
-    // Upload incomplete due to timeout or connection issues
-    logger.warn() << "Large upload incomplete: received " << totalReceived << "/"
-                  << totalContentLength << " bytes (consecutive failure limit reached)";
-    uploadManager.cleanup();
-    this->closePollFd(fdesc);
-    return Monitor::EXEC_SUCCESS;
+    logger.info() << "Large upload detected (" << contentLength
+                  << " bytes), using streaming to disk";
+    connection->upload = new UploadManager(this->logger);
+    this->adjustMetric(Metrics::ACTIVE_UPLOADS, 1);
+    if (!connection->upload->startLargeUpload(contentLength)) {
+        logger.error() << "Failed to start large upload streaming";
+        return false;
+    }
+    connection->request.setTempFilePath(connection->upload->getTempFilePath());
+    return true;
 }
 
-std::size_t Monitor::extractContentLength(const std::string &rawRequest,
-                                          std::size_t        contentLengthPos) {
-    std::size_t valueStart = contentLengthPos + CONTENT_LENGTH_HEADER;
-    std::size_t lineEnd = rawRequest.find("\r\n", valueStart);
+// Hands body bytes to their sink: the request's in-memory body, or the upload temp file for
+// bodies over LARGE_FILE_THRESHOLD. Never takes more than the body still needs
+bool Monitor::deliverBody(Connection *connection, const char *data, std::size_t length,
+                          std::size_t &used) {
+    std::size_t remaining = connection->request.getBodyRemaining();
 
-    if (lineEnd == std::string::npos) {
-        return 0;
+    used = length < remaining ? length : remaining;
+    if (used == 0) {
+        return true;
     }
+    if (connection->upload != NULL && !connection->upload->writeChunk(data, used)) {
+        logger.error() << "Failed to write chunk to disk during large upload";
+        return false;
+    }
+    connection->request.appendBody(data, used);
+    return true;
+}
 
-    std::string lengthStr = rawRequest.substr(valueStart, lineEnd - valueStart);
+// Queues the response to the parsed request, or hands the connection to the CGI script that
+// will produce it, and rewinds the state machine. Returns false when the connection must be
+// closed right away
+bool Monitor::serveRequest(Connection *connection, int &ready) {
+    const int    fdesc = connection->fd;
+    HttpRequest &httpRequest = connection->request;
 
-    while (!lengthStr.empty() && lengthStr[0] == ' ') {
-        lengthStr = lengthStr.substr(1);
+    if (connection->upload != NULL) {
+        if (!connection->upload->finishUpload()) {
+            logger.error() << "Failed to finish large upload";
+            return false;
+        }
+        connection->upload->disableAutoCleanup();
+        logger.info() << "Large upload completed successfully, temp file: "
+                      << connection->upload->getTempFilePath();
+    }
+
+    PendingScript script;
+    TRACE_ENTER(connection->trace);
+    HttpResponse httpResponse = generateHttpResponse(httpRequest, fdesc, script);
+    TRACE_LEAVE();
+    TRACE_MARK(connection->trace, HANDLED);
+    CgiProcess *process = script.cgi;
+    if (process != NULL && !this->startCgi(connection, process)) {
+        logger.error() << "Failed to register CGI pipes";
+        this->releaseCgi(connection);
+        httpResponse =
+            this->httpServer->createErrorResponse(HTTP_INTERNAL_ERROR, connection->port);
+    }
+    FastCgiRequest *fastcgi = script.fastcgi;
+    const int       fastcgiStatus = fastcgi != NULL ? this->startFastCgi(connection, fastcgi) : 0;
+    if (fastcgiStatus != 0) {
+        this->releaseFastCgi(connection);
+        httpResponse = this->httpServer->createErrorResponse(fastcgiStatus, connection->port);
     }
-    while (!lengthStr.empty() && lengthStr[lengthStr.length() - 1] == ' ') {
-        lengthStr = lengthStr.substr(0, lengthStr.length() - 1);
+    bool keepAlive = this->keepConnectionAlive(connection, httpRequest, httpResponse);
+    connection->closeAfterWrite = !keepAlive;
+    if (this->isTrackingRequests()) {
+        this->beginAccessRecord(connection);
     }
+    if (!connection->hasScript()) {
+        queueResponse(connection, httpResponse);
+        queueAccessRecord(connection, httpResponse.getStatusCode());
+    } else {
+        // Script output has no length known in advance: HTTP/1.1 clients get it chunked and
+        // may keep the connection, older ones read it until the connection closes
+        connection->relayChunked = httpRequest.getVersion() == "HTTP/1.1";
+        connection->closeAfterWrite = !keepAlive || !connection->relayChunked;
+    }
+    ready--;
 
-    return stringToNumber(lengthStr);
+    if (connection->upload != NULL) {
+        connection->upload->cleanup();
+        delete connection->upload;
+        connection->upload = NULL;
+        this->adjustMetric(Metrics::ACTIVE_UPLOADS, -1);
+    }
+    httpRequest.clear();
+    httpRequest.setTempFilePath("");
+    connection->state = Connection::STATE_READ_HEADERS;
+    connection->requestStarted = time(NULL);  // A pipelined request may already be buffered
+    if (this->isTrackingRequests()) {
+        connection->requestBegan = AccessLog::now();
+    }
+    TRACE_RESTART(connection->trace);
+    TRACE_MARK(connection->trace, FIRST_BYTE);
+    return true;
 }
 
-HttpResponse Monitor::generateHttpResponse(const HttpRequest &httpRequest, int fdesc) {
+HttpResponse Monitor::generateHttpResponse(const HttpRequest &httpRequest, int fdesc,
+                                           PendingScript &script) {
     if (httpRequest.isValid()) {
         int serverPort = this->getPortForConnection(fdesc);
         if (serverPort < 0) {
@@ -344,118 +456,220 @@ HttpResponse Monitor::generateHttpResponse(const HttpRequest &httpRequest, int f
             }
         }
 
-        return this->httpServer->processRequest(httpRequest, serverPort);
+        return this->httpServer->processRequest(httpRequest, serverPort, script);
     }
 
     logger.warn() << "Invalid HTTP request received";
     return HttpResponse::createBadRequest();
 }
 
-void Monitor::sendHttpResponse(int fdesc, const HttpResponse &httpResponse) {
-    std::string responseString = httpResponse.toString();
-    send(fdesc, responseString.c_str(), responseString.size(), 0);
+// Moves the response into the output queue: the head is serialized, the body swapped in and an
+// open file body taken over
+void Monitor::queueResponse(Connection *connection, HttpResponse &httpResponse) {
+    connection->output.push_back(QueuedResponse());
+    QueuedResponse &queued = connection->output.back();
+    httpResponse.serializeHead(queued.head);
+    TRACE_MARK(connection->access.trace, SERIALIZED);
+    httpResponse.releaseBody(queued.body);
+    if (httpResponse.hasFileBody()) {
+        queued.fileOffset = httpResponse.getFileOffset();
+        queued.fileRemaining = httpResponse.getFileLength();
+        queued.fileFd = httpResponse.releaseFileBody();
+    }
+    connection->bytesQueued += queued.head.length() + queued.body.length() + queued.fileRemaining;
 }
 
-UploadState *Monitor::getUploadState(int fdesc) {
-    std::map<int, UploadState *>::iterator it = activeUploads.find(fdesc);
-    if (it != activeUploads.end()) {
-        return it->second;
+// Starts the record of the request about to be answered, for the access log and the metrics;
+// a response produced by a script also gets the time the script took
+void Monitor::beginAccessRecord(Connection *connection) {
+    AccessLog::Record &record = connection->access;
+
+    record.method = connection->request.getMethod();
+    record.path = connection->request.getPath();
+    record.status = 0;
+    record.started = connection->requestBegan;
+    record.parsed = AccessLog::now();
+    record.requests = connection->requestCount;
+    record.begin = connection->bytesQueued;
+    record.hasUpstream = connection->hasScript();
+    record.upstreamTime = 0;
+    record.trace = connection->trace;
+    if (record.hasUpstream) {
+        connection->scriptStarted = record.parsed;
     }
-    return NULL;
 }
 
-void Monitor::addUploadState(int fdesc, UploadState *state) { activeUploads[fdesc] = state; }
+// Marks the end of the response in the output stream; it is logged once sent up to there. Does
+// nothing unless a record was started
+void Monitor::queueAccessRecord(Connection *connection, int status) {
+    AccessLog::Record &record = connection->access;
 
-void Monitor::removeUploadState(int fdesc) {
-    std::map<int, UploadState *>::iterator it = activeUploads.find(fdesc);
-    if (it != activeUploads.end()) {
-        delete it->second;
-        activeUploads.erase(it);
+    if (record.started == 0) {
+        return;
     }
-}
-
-Monitor::ExecResult Monitor::continueUpload(int fdesc, int &ready) {
-    UploadState *uploadState = getUploadState(fdesc);
-    if (uploadState == NULL) {
-        return Monitor::EXEC_SUCCESS;
+    record.status = status;
+    record.end = connection->bytesQueued;
+    record.queued = AccessLog::now();
+    if (record.hasUpstream) {
+        record.upstreamTime = record.queued - connection->scriptStarted;
     }
+    connection->accessPending.push_back(record);
+    record.started = 0;
+}
 
-    Logger logger(std::cout, true);
-    char   buffer[UPLOAD_BUFFER_SIZE];
-
-    ssize_t bytesRead = recv(fdesc, buffer, UPLOAD_BUFFER_SIZE, 0);
-    if (bytesRead <= 0) {
-        if (bytesRead == 0) {
-            logger.warn() << "Connection closed during large upload (received "
-                          << uploadState->totalReceived << "/" << uploadState->totalContentLength
-                          << " bytes)";
-            uploadState->manager->cleanup();
-            removeUploadState(fdesc);
-            this->closePollFd(fdesc);
-            return Monitor::EXEC_SUCCESS;
+// Logs and counts the responses the socket has taken completely. A connection that is closing
+// logs the rest too, with the bytes that made it out
+void Monitor::logSentResponses(Connection *connection, bool closing) {
+    AccessLog::RecordQueue &pending = connection->accessPending;
+
+    while (!pending.empty() && (closing || pending.front().end <= connection->bytesSent)) {
+        AccessLog::Record &record = pending.front();
+        const std::size_t  sent = std::min(connection->bytesSent, record.end);
+        const std::size_t  bytes = sent > record.begin ? sent - record.begin : 0;
+        if (sent == record.end) {
+            TRACE_MARK(record.trace, LAST_BYTE);
         }
-        return Monitor::EXEC_SUCCESS;
-    }
-
-    std::size_t bytesToWrite = static_cast<std::size_t>(bytesRead);
-    if (uploadState->totalReceived + bytesToWrite > uploadState->totalContentLength) {
-        bytesToWrite = uploadState->totalContentLength - uploadState->totalReceived;
+        if (this->accessLog.isEnabled()) {
+            this->accessLog.write(record, bytes);
+        }
+        if (this->metrics != NULL) {
+            this->metrics->countStatus(record.status);
+            this->metrics->add(Metrics::BYTES_SENT, bytes);
+            this->metrics->record(Metrics::PHASE_PARSE, record.parsed - record.started);
+            this->metrics->record(Metrics::PHASE_HANDLE, record.queued - record.parsed);
+            this->metrics->record(Metrics::PHASE_SEND, AccessLog::now() - record.queued);
+        }
+        if (this->traceLimit > 0) {
+            this->keepTrace(record);
+        }
+        pending.pop_front();
     }
+}
 
-    if (!uploadState->manager->writeChunk(buffer, bytesToWrite)) {
-        logger.error() << "Failed to write chunk to disk during large upload";
-        uploadState->manager->cleanup();
-        removeUploadState(fdesc);
-        this->closePollFd(fdesc);
-        return Monitor::EXEC_SUCCESS;
+// Adds the unsent part of a head or body to the gather list
+static std::size_t gatherSegment(struct iovec *iov, int &count, const std::string &data,
+                                 std::size_t sent) {
+    if (sent >= data.length()) {
+        return 0;
     }
+    iov[count].iov_base = const_cast<char *>(data.data()) + sent;
+    iov[count].iov_len = data.length() - sent;
+    return iov[count++].iov_len;
+}
 
-    uploadState->totalReceived += bytesToWrite;
-
-    if (uploadState->totalReceived >= uploadState->totalContentLength) {
-        if (!uploadState->manager->finishUpload()) {
-            logger.error() << "Failed to finish large upload";
-            uploadState->manager->cleanup();
-            removeUploadState(fdesc);
-            this->closePollFd(fdesc);
-            return Monitor::EXEC_SUCCESS;
+// Sends as much queued output as the socket accepts. The heads and in-memory bodies of the
+// queued responses go out together in one writev() without being copied; a file body is
+// streamed once everything before it has been sent. A short or failed write leaves the rest
+// for the next writability event
+Monitor::FlushResult Monitor::flushConnection(Connection *connection) {
+    std::deque<QueuedResponse> &output = connection->output;
+
+    while (!output.empty()) {
+        struct iovec iov[OUTPUT_BATCH * 2];
+        int          count = 0;
+        std::size_t  requested = 0;
+
+        // A file body has to follow its own head, so gathering stops at the first one
+        for (std::deque<QueuedResponse>::iterator it = output.begin();
+             it != output.end() && count < OUTPUT_BATCH * 2; ++it) {
+            std::size_t headSent = std::min(it->sent, it->head.length());
+            requested += gatherSegment(iov, count, it->head, headSent);
+            requested += gatherSegment(iov, count, it->body, it->sent - headSent);
+            if (it->fileFd >= 0) {
+                break;
+            }
         }
 
-        uploadState->manager->disableAutoCleanup();
+        if (count > 0) {
+            ssize_t written = writev(connection->fd, iov, count);
+            if (written < 0) {
+                return Monitor::FLUSH_PENDING;
+            }
+            connection->lastActivity = time(NULL);
+            connection->bytesSent += static_cast<std::size_t>(written);
+
+            std::size_t left = static_cast<std::size_t>(written);
+            for (std::deque<QueuedResponse>::iterator it = output.begin(); left > 0; ++it) {
+                std::size_t taken = std::min(it->unsent(), left);
+                it->sent += taken;
+                left -= taken;
+            }
+            if (static_cast<std::size_t>(written) < requested) {
+                return Monitor::FLUSH_PENDING;
+            }
+        }
 
-        std::string headersOnly =
-            uploadState->rawRequest.substr(0, uploadState->rawRequest.find("\r\n\r\n") + 4);
-        logger.info() << "Large upload completed successfully, temp file: "
-                      << uploadState->manager->getTempFilePath();
-
-        HttpRequest httpRequest(logger);
-        httpRequest.setTempFilePath(uploadState->manager->getTempFilePath());
-        httpRequest.parse(headersOnly);
-
-        HttpResponse httpResponse;
-        if (httpRequest.isValid()) {
-            int serverPort = this->getPortForConnection(fdesc);
-            if (serverPort < 0) {
-                if (!this->servers.empty() && !this->servers[0].listens.empty()) {
-                    serverPort = this->servers[0].listens[0].second;
-                } else {
-                    serverPort = DEFAULT_SERVER_PORT;
-                }
+        // Everything gathered went out: drop the finished responses, then stream a file body
+        while (!output.empty() && output.front().unsent() == 0 && output.front().fileFd < 0) {
+            output.pop_front();
+        }
+        if (!output.empty() && output.front().unsent() == 0) {
+            FlushResult result = flushFileBody(connection, output.front());
+            if (result != Monitor::FLUSH_DONE) {
+                return result;
             }
-            httpResponse = this->httpServer->processRequest(httpRequest, serverPort);
-        } else {
-            logger.warn() << "Invalid HTTP request received";
-            httpResponse = HttpResponse::createBadRequest();
+            output.pop_front();
         }
+    }
+    return Monitor::FLUSH_DONE;
+}
 
-        std::string responseString = httpResponse.toString();
-        send(fdesc, responseString.c_str(), responseString.size(), 0);
+// Streams a file body without copying it through user space where sendfile() exists
+Monitor::FlushResult Monitor::flushFileBody(Connection *connection, QueuedResponse &response) {
+    while (response.fileRemaining > 0) {
+#ifdef __linux__
+        ssize_t sent = sendfile(connection->fd, response.fileFd, &response.fileOffset,
+                                response.fileRemaining);
+#else
+        char    buffer[BUFFER_SIZE];
+        ssize_t sent = pread(response.fileFd, buffer,
+                             std::min(response.fileRemaining, sizeof(buffer)),
+                             response.fileOffset);
+        if (sent > 0) {
+            sent = send(connection->fd, buffer, static_cast<std::size_t>(sent), MSG_NOSIGNAL);
+        }
+        if (sent > 0) {
+            response.fileOffset += sent;
+        }
+#endif
+        if (sent < 0) {
+            return Monitor::FLUSH_PENDING;
+        }
+        // The file shrank since its length was announced; the response cannot be completed
+        if (sent == 0) {
+            return Monitor::FLUSH_ERROR;
+        }
+        response.fileRemaining -= static_cast<std::size_t>(sent);
+        connection->bytesSent += static_cast<std::size_t>(sent);
+        connection->lastActivity = time(NULL);
+    }
+    close(response.fileFd);
+    response.fileFd = -1;
+    return Monitor::FLUSH_DONE;
+}
 
-        ready--;
-        uploadState->manager->cleanup();
-        removeUploadState(fdesc);
-        this->closePollFd(fdesc);
+// Decides whether the connection survives this response and advertises the decision to the client
+bool Monitor::keepConnectionAlive(Connection *connection, const HttpRequest &httpRequest,
+                                  HttpResponse &httpResponse) const {
+    connection->requestCount++;
+    bool keepAlive = httpRequest.isValid() && httpRequest.isKeepAlive() &&
+                     this->config.getKeepaliveTimeout() > 0 &&
+                     connection->requestCount < this->config.getKeepaliveRequests();
+
+    this->setConnectionHeaders(connection, httpResponse, keepAlive);
+    return keepAlive;
+}
+
+void Monitor::setConnectionHeaders(const Connection *connection, HttpResponse &httpResponse,
+                                   bool keepAlive) const {
+    if (!keepAlive) {
+        httpResponse.setHeader("Connection", "close");
+        return;
     }
 
-    return Monitor::EXEC_SUCCESS;
+    std::ostringstream keepAliveValue;
+    keepAliveValue << "timeout=" << this->config.getKeepaliveTimeout()
+                   << ", max=" << this->config.getKeepaliveRequests() - connection->requestCount;
+    httpResponse.setHeader("Connection", "keep-alive");
+    httpResponse.setHeader("Keep-Alive", keepAliveValue.str());
 }
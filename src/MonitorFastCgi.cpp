@@ -0,0 +1,479 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MonitorFastCgi.cpp                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 13:36:12 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 13:36:12 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "CgiWorker.hpp"
+#include "FastCgi.hpp"
+#include "FastCgiRequest.hpp"
+#include "HttpServer.hpp"
+#include "Monitor.hpp"
+
+// Takes over the FastCGI request prepared for the request just served on client. It is handed
+// to a pooled upstream connection right away, or queued until one comes free. Returns 0, or
+// the status to answer with when the request cannot be started: 503 Service Unavailable for a
+// full queue, 502 Bad Gateway when no connection could be opened. The caller then releases it
+int Monitor::startFastCgi(Connection *client, FastCgiRequest *request) {
+    FastCgiUpstream *upstream = this->getFastCgiUpstream(request->getUpstream());
+
+    client->fastcgi = request;
+    request->setClientFd(client->fd);
+    if (upstream->idle.empty() && upstream->open >= upstream->limit &&
+        upstream->waiting.size() >= FASTCGI_QUEUE_LIMIT) {
+        logger.warn() << "FastCGI queue for " << upstream->address << " is full";
+        return HTTP_SERVICE_UNAVAILABLE;
+    }
+    return this->attachFastCgi(upstream, request) ? 0 : HTTP_BAD_GATEWAY;
+}
+
+// Detaches and deletes the client's request. A connection caught mid-request cannot carry
+// another one, so it is closed and its place in the pool goes to the next waiting request. Its
+// entry may still have events queued in the current batch; closePollFd leaves it to be freed
+// once the batch is done
+void Monitor::releaseFastCgi(Connection *client) {
+    FastCgiRequest  *request = client->fastcgi;
+    FastCgiUpstream *upstream = this->getFastCgiUpstream(request->getUpstream());
+    const int        upstreamFd = request->getUpstreamFd();
+
+    client->fastcgi = NULL;
+    if (upstreamFd >= 0) {
+        this->connections[upstreamFd]->fastcgi = NULL;
+        this->closePollFd(upstreamFd);
+    } else {
+        std::deque<FastCgiRequest *>::iterator it =
+            std::find(upstream->waiting.begin(), upstream->waiting.end(), request);
+        if (it != upstream->waiting.end()) {
+            upstream->waiting.erase(it);
+        }
+    }
+    delete request;
+    if (upstreamFd >= 0) {
+        this->dispatchFastCgi(upstream);
+    }
+    // A killed worker is replaced right away so the pool stays warm
+    if (upstreamFd >= 0 && CgiWorker::isPoolAddress(upstream->address)) {
+        this->prestartFastCgi(upstream);
+    }
+}
+
+// The pool for address, created on first use with the size its kind of upstream allows
+FastCgiUpstream *Monitor::getFastCgiUpstream(const std::string &address) {
+    std::map<std::string, FastCgiUpstream>::iterator it = this->fastCgiUpstreams.find(address);
+    if (it != this->fastCgiUpstreams.end()) {
+        return &it->second;
+    }
+    FastCgiUpstream &upstream = this->fastCgiUpstreams[address];
+    upstream.address = address;
+    if (CgiWorker::isPoolAddress(address)) {
+        upstream.limit = this->config.getCgiWorkers();
+        upstream.maxRequests = this->config.getCgiWorkerRequests();
+    } else {
+        upstream.limit = this->config.getFastcgiKeepalive();
+    }
+    return &upstream;
+}
+
+// Fills the pool with idle connections up to its limit, so the first requests do not pay for
+// starting a worker
+void Monitor::prestartFastCgi(FastCgiUpstream *upstream) {
+    while (upstream->open < upstream->limit) {
+        Connection *entry = this->openFastCgiConnection(upstream);
+        if (entry == NULL) {
+            return;
+        }
+        if (!this->eventBackend->modify(entry->fd, EventBackend::EVENT_READ, entry)) {
+            this->closePollFd(entry->fd);
+            return;
+        }
+        upstream->idle.push_back(entry->fd);
+    }
+}
+
+// Assigns the request to an idle connection, or to a new one while the pool is below its
+// limit, or else queues it. Returns false when a new connection cannot be opened
+bool Monitor::attachFastCgi(FastCgiUpstream *upstream, FastCgiRequest *request) {
+    Connection *entry = NULL;
+
+    if (!upstream->idle.empty()) {
+        entry = this->connections[upstream->idle.back()];
+        upstream->idle.pop_back();
+        if (!this->eventBackend->modify(entry->fd,
+                                        EventBackend::EVENT_READ | EventBackend::EVENT_WRITE,
+                                        entry)) {
+            this->closePollFd(entry->fd);
+            return false;
+        }
+    } else if (upstream->open < upstream->limit) {
+        entry = this->openFastCgiConnection(upstream);
+        if (entry == NULL) {
+            return false;
+        }
+    } else {
+        upstream->waiting.push_back(request);
+        return true;
+    }
+    // The records go out once the connection reports writable
+    entry->fastcgi = request;
+    request->setUpstreamFd(entry->fd);
+    return true;
+}
+
+// Hands waiting requests to connections as they come free. A request whose connection cannot
+// be opened is answered with 502 Bad Gateway
+void Monitor::dispatchFastCgi(FastCgiUpstream *upstream) {
+    while (!upstream->waiting.empty() &&
+           (!upstream->idle.empty() || upstream->open < upstream->limit)) {
+        FastCgiRequest *request = upstream->waiting.front();
+        upstream->waiting.pop_front();
+        if (this->attachFastCgi(upstream, request)) {
+            continue;
+        }
+        Connection *client = this->connections[request->getClientFd()];
+        client->fastcgi = NULL;
+        delete request;
+        this->finishRelay(client, HTTP_BAD_GATEWAY);
+    }
+}
+
+// Connects to the upstream, or starts a worker for a worker pool
+Connection *Monitor::openFastCgiConnection(FastCgiUpstream *upstream) {
+    bool  connecting = false;
+    pid_t worker = -1;
+    int   fdesc = -1;
+
+    if (CgiWorker::isPoolAddress(upstream->address)) {
+        fdesc = CgiWorker::spawn(upstream->address, worker);
+    } else {
+        fdesc = connectUpstream(upstream->address, connecting);
+    }
+    if (fdesc < 0) {
+        logger.error() << "Cannot connect to FastCGI upstream " << upstream->address;
+        return NULL;
+    }
+    if (worker > 0 && this->metrics != NULL) {
+        this->metrics->add(Metrics::CGI_SPAWNS, 1);
+    }
+    if (!this->addPollFd(fdesc, -1, Connection::CONNECTION_FASTCGI,
+                         EventBackend::EVENT_READ | EventBackend::EVENT_WRITE)) {
+        close(fdesc);
+        return NULL;
+    }
+    Connection *entry = this->connections[fdesc];
+    entry->upstream = upstream;
+    if (connecting) {
+        entry->state = Connection::STATE_CONNECTING;
+    }
+    upstream->open++;
+    if (worker > 0) {
+        upstream->workers[fdesc] = worker;
+        logger.info() << "Started CGI worker " << worker << " for " << upstream->address;
+    } else {
+        logger.info() << "Opened FastCGI connection " << fdesc << " to " << upstream->address;
+    }
+    return entry;
+}
+
+// Opens a non-blocking socket to "unix:/path" or "host:port". A TCP connect usually completes
+// later, which connecting reports; its outcome is read from SO_ERROR once the socket is writable
+int Monitor::connectUpstream(const std::string &address, bool &connecting) {
+    connecting = false;
+
+    if (address.compare(0, 5, "unix:") == 0) {
+        const std::string  path = address.substr(5);
+        struct sockaddr_un unixAddress;
+
+        if (path.empty() || path.length() >= sizeof(unixAddress.sun_path)) {
+            return -1;
+        }
+        std::memset(&unixAddress, 0, sizeof(unixAddress));
+        unixAddress.sun_family = AF_UNIX;
+        std::memcpy(unixAddress.sun_path, path.c_str(), path.length());
+
+        int fdesc = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fdesc < 0) {
+            return -1;
+        }
+        // Local sockets connect at once or not at all
+        if (fcntl(fdesc, F_SETFL, O_NONBLOCK) < 0 || fcntl(fdesc, F_SETFD, FD_CLOEXEC) < 0 ||
+            connect(fdesc, reinterpret_cast<struct sockaddr *>(&unixAddress),
+                    sizeof(unixAddress)) < 0) {
+            close(fdesc);
+            return -1;
+        }
+        return fdesc;
+    }
+
+    const std::string::size_type colon = address.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == address.length()) {
+        return -1;
+    }
+    const std::string host = address.substr(0, colon);
+    const std::string port = address.substr(colon + 1);
+    struct addrinfo   hints;
+    struct addrinfo  *result = NULL;
+
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+        return -1;
+    }
+    int fdesc = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fdesc >= 0 && (fcntl(fdesc, F_SETFL, O_NONBLOCK) < 0 ||
+                       fcntl(fdesc, F_SETFD, FD_CLOEXEC) < 0)) {
+        close(fdesc);
+        fdesc = -1;
+    }
+    // Subject forbids checking errno, so a failed connect is treated as still in progress
+    if (fdesc >= 0 && connect(fdesc, result->ai_addr, result->ai_addrlen) < 0) {
+        connecting = true;
+    }
+    freeaddrinfo(result);
+    return fdesc;
+}
+
+// Drops a closed connection from its pool. A worker behind it may be stuck in a script that
+// nobody waits for anymore, so it is killed rather than left to notice; the loop reaps it
+void Monitor::forgetFastCgiConnection(Connection *entry) {
+    FastCgiUpstream *upstream = entry->upstream;
+
+    if (upstream == NULL) {
+        return;
+    }
+    std::vector<int>::iterator it = std::find(upstream->idle.begin(), upstream->idle.end(),
+                                              entry->fd);
+    if (it != upstream->idle.end()) {
+        upstream->idle.erase(it);
+    }
+    std::map<int, pid_t>::iterator worker = upstream->workers.find(entry->fd);
+    if (worker != upstream->workers.end()) {
+        kill(worker->second, SIGKILL);
+        this->cgiProcesses[worker->second] = NULL;
+        upstream->workers.erase(worker);
+    }
+    upstream->open--;
+}
+
+void Monitor::eventExecFastCgi(Connection *entry, const EventBackend::Event &event) {
+    if (entry->state == Connection::STATE_CONNECTING) {
+        if (!event.writable && !event.hangup) {
+            return;
+        }
+        int       error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(entry->fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+            logger.error() << "Cannot connect to FastCGI upstream " << entry->upstream->address
+                           << ": " << std::strerror(error);
+            this->failFastCgi(entry);
+            return;
+        }
+        entry->state = Connection::STATE_READ_HEADERS;
+    }
+    if (event.writable && entry->fastcgi != NULL && !this->writeFastCgi(entry)) {
+        return;
+    }
+    if (event.readable || event.hangup) {
+        this->readFastCgi(entry, event.hangup);
+    }
+}
+
+// Sends the request's records as the socket accepts them, encoding a temp file body one chunk
+// at a time. Returns false when the connection failed and is gone
+bool Monitor::writeFastCgi(Connection *entry) {
+    FastCgiRequest *request = entry->fastcgi;
+
+    while (true) {
+        if (!entry->hasPendingOutput()) {
+            std::string records;
+            if (!request->takeInput(records)) {
+                break;
+            }
+            entry->output.push_back(QueuedResponse());
+            entry->output.back().body.swap(records);
+        }
+        FlushResult flushResult = flushConnection(entry);
+        if (flushResult == Monitor::FLUSH_ERROR) {
+            this->failFastCgi(entry);
+            return false;
+        }
+        if (flushResult == Monitor::FLUSH_PENDING) {
+            return true;
+        }
+    }
+    // Everything is sent; only the response is left to read
+    if (!this->eventBackend->modify(entry->fd, EventBackend::EVENT_READ, entry)) {
+        this->failFastCgi(entry);
+        return false;
+    }
+    return true;
+}
+
+void Monitor::readFastCgi(Connection *entry, bool hangup) {
+    char buffer[CGI_BUFFER_SIZE];
+
+    // Edge-triggered fds report new data only once, so drain the socket before yielding
+    const bool drain = this->eventBackend->isEdgeTriggered();
+    do {
+        ssize_t bytesRead = recv(entry->fd, buffer, sizeof(buffer), 0);
+        if (bytesRead > 0) {
+            entry->readBuffer.append(buffer, static_cast<std::size_t>(bytesRead));
+            if (!this->processFastCgiRecords(entry)) {
+                return;
+            }
+            continue;
+        }
+        if (bytesRead < 0 && !hangup) {
+            return;
+        }
+        // The upstream closed the connection; only an idle one may go away quietly
+        if (entry->fastcgi != NULL) {
+            logger.error() << "FastCGI upstream " << entry->upstream->address
+                           << " closed the connection mid-request";
+            this->failFastCgi(entry);
+        } else {
+            this->closePollFd(entry->fd);
+        }
+        return;
+    } while (drain);
+}
+
+// Relays the STDOUT records buffered so far and completes the request on END_REQUEST. Returns
+// false once the connection stopped reading: it is closed, idle again, or paused behind a
+// client that fell behind
+bool Monitor::processFastCgiRecords(Connection *entry) {
+    FastCgiRequest *request = entry->fastcgi;
+
+    if (request == NULL) {
+        logger.warn() << "Unexpected data on idle FastCGI connection " << entry->fd;
+        this->closePollFd(entry->fd);
+        return false;
+    }
+    Connection *client = this->connections[request->getClientFd()];
+    const int   clientFd = client->fd;
+    const bool  wasPending = client->hasPendingOutput();
+    bool        relayed = false;
+    bool        ended = false;
+    int         appStatus = 0;
+
+    FastCgi::Record record;
+    std::size_t     offset = 0;
+    while (!ended && FastCgi::parseRecord(entry->readBuffer, offset, record)) {
+        // Management records (request id 0) carry nothing a responder needs to act on
+        if (record.requestId != FASTCGI_REQUEST_ID) {
+            continue;
+        }
+        if (record.type == FastCgi::STDOUT && !record.content.empty()) {
+            this->relayOutput(client, record.content.data(), record.content.length());
+            relayed = true;
+        } else if (record.type == FastCgi::STDERR && !record.content.empty()) {
+            logger.warn() << "FastCGI stderr: " << record.content;
+        } else if (record.type == FastCgi::END_REQUEST) {
+            appStatus = FastCgi::getAppStatus(record);
+            ended = true;
+        }
+    }
+    entry->readBuffer.erase(0, offset);
+
+    if (relayed) {
+        this->sendRelayedOutput(client, wasPending);
+    }
+    // Sending may have found the client gone, taking the request and this connection with it
+    if (this->isPollFd(clientFd) == 0) {
+        return false;
+    }
+    if (ended) {
+        this->completeFastCgi(entry, appStatus);
+        return false;
+    }
+    // A client that falls behind pauses the upstream once the request is fully sent
+    if (isRelayBacklogged(client) && !request->hasPendingInput() && !entry->hasPendingOutput()) {
+        this->eventBackend->remove(entry->fd);
+        request->setOutputPaused(true);
+        return false;
+    }
+    return true;
+}
+
+// Completes the client's response and puts the connection back in the pool, unless the upstream
+// left it in a state no other request can follow. A worker that served its share of requests
+// is replaced by a fresh one
+void Monitor::completeFastCgi(Connection *entry, int appStatus) {
+    FastCgiRequest  *request = entry->fastcgi;
+    FastCgiUpstream *upstream = entry->upstream;
+    Connection      *client = this->connections[request->getClientFd()];
+
+    if (appStatus == 0) {
+        logger.info() << "FastCGI request on connection " << entry->fd << " completed";
+    } else {
+        logger.error() << "FastCGI application exited with status " << appStatus;
+    }
+    client->fastcgi = NULL;
+    entry->fastcgi = NULL;
+    delete request;
+
+    entry->requestCount++;
+    const bool retired = upstream->maxRequests != 0 && entry->requestCount >= upstream->maxRequests;
+    if (retired || !entry->readBuffer.empty() || entry->hasPendingOutput() ||
+        !this->eventBackend->modify(entry->fd, EventBackend::EVENT_READ, entry)) {
+        this->closePollFd(entry->fd);
+    } else {
+        upstream->idle.push_back(entry->fd);
+    }
+    if (retired) {
+        this->prestartFastCgi(upstream);
+    }
+    // A failed script run by a worker is answered like a forked one
+    const int failureStatus =
+        CgiWorker::isPoolAddress(upstream->address) ? HTTP_INTERNAL_ERROR : HTTP_BAD_GATEWAY;
+    this->finishRelay(client, appStatus == 0 ? 0 : failureStatus);
+    this->dispatchFastCgi(upstream);
+}
+
+// Closes a connection that failed, answering its client with 502 Bad Gateway unless output
+// was already relayed
+void Monitor::failFastCgi(Connection *entry) {
+    FastCgiRequest  *request = entry->fastcgi;
+    FastCgiUpstream *upstream = entry->upstream;
+
+    entry->fastcgi = NULL;
+    this->closePollFd(entry->fd);
+    if (request != NULL) {
+        Connection *client = this->connections[request->getClientFd()];
+        client->fastcgi = NULL;
+        delete request;
+        this->finishRelay(client, HTTP_BAD_GATEWAY);
+    }
+    this->dispatchFastCgi(upstream);
+}
+
+// The client drained its output; read from the upstream again
+void Monitor::resumeFastCgiOutput(FastCgiRequest *request) {
+    const int upstreamFd = request->getUpstreamFd();
+
+    if (request->isOutputPaused() && upstreamFd >= 0) {
+        this->eventBackend->add(upstreamFd, EventBackend::EVENT_READ,
+                                this->connections[upstreamFd]);
+        request->setOutputPaused(false);
+    }
+}
@@ -12,16 +12,24 @@
 
 #include <fcntl.h>
 #include <netinet/in.h>
-#include <sys/poll.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/signalfd.h>
+#endif
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <csignal>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <string>
 
+#include "CgiWorker.hpp"
 #include "Config.hpp"
 #include "Monitor.hpp"
+#include "Trace.hpp"
 
 int Monitor::init(const Config &config) {
     // Store configuration for HttpServer
@@ -30,6 +38,11 @@ int Monitor::init(const Config &config) {
 
     logger.info() << "Monitor::init starting with " << servers.size() << " servers";
 
+    // sendfile() has no MSG_NOSIGNAL; a peer that resets mid-response must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+    initSignalHandlers();
+    this->initChildSignal();
+
     // Initialize HttpServer with config and logger
     this->httpServer = new HttpServer(this->config, this->logger);
     if (this->httpServer == NULL) {
@@ -42,6 +55,20 @@ int Monitor::init(const Config &config) {
 
     switch (result) {
         case INIT_SUCCESS:
+            // With reactor threads the acceptor serves no clients; each reactor has its own pools,
+            // access log, metrics slot and traces
+            if (this->config.getReactorThreads() > 0) {
+                if (!this->initReactors()) {
+                    return -1;
+                }
+            } else {
+                if (!this->initAccessLog()) {
+                    return -1;
+                }
+                this->metrics = Metrics::claimSlot();
+                this->initTraceRing();
+                this->initCgiWorkers();
+            }
             logger.info() << "Monitor initialization completed successfully";
             return 0;
         case INIT_MEMORY_ERROR:
@@ -59,23 +86,12 @@ int Monitor::init(const Config &config) {
 Monitor::InitResult Monitor::initData(std::vector<Config::Server> servers) {
     struct sockaddr_in address;
 
-    this->fds = new struct pollfd[POLLFD_SIZE];
-    if (this->fds == NULL) {
-        logger.error() << "Failed to allocate memory for poll fds";
-        return INIT_MEMORY_ERROR;
-    }
-
-    this->connectionPorts = new int[POLLFD_SIZE];
-    if (this->connectionPorts == NULL) {
-        logger.error() << "Failed to allocate memory for connection ports";
+    this->initConnectionLimit();
+    this->connections.reserve(CONNECTION_TABLE_SIZE);
+    if (!this->initEventBackend()) {
         return INIT_MEMORY_ERROR;
     }
 
-    // Initialize connection ports to -1 (unassigned)
-    for (int i = 0; i < POLLFD_SIZE; ++i) {
-        this->connectionPorts[i] = -1;
-    }
-
     // Count total listen sockets needed
     int n = 0;
     for (std::size_t i = 0; i < servers.size(); ++i) {
@@ -110,7 +126,8 @@ Monitor::InitResult Monitor::initData(std::vector<Config::Server> servers) {
             logger.info() << "Attempting to create listen socket for "
                           << ntohl(address.sin_addr.s_addr) << ":" << ntohs(address.sin_port);
 
-            listenFds[n] = Monitor::initListenFd(address);
+            listenFds[n] = Monitor::initListenFd(address, servers[i].listens[j],
+                                                 this->config.getWorkerProcesses() > 1);
 
             if (listenFds[n] < 0) {
                 logger.error() << "Failed to create listen socket " << n << " for "
@@ -131,7 +148,148 @@ Monitor::InitResult Monitor::initData(std::vector<Config::Server> servers) {
     return INIT_SUCCESS;
 }
 
-int Monitor::initListenFd(struct sockaddr_in &address) {
+// CGI children are reaped from the loop: SIGCHLD is blocked and read from a signal fd, so an
+// exiting script wakes the loop like any other fd. Without one, children are reaped on wakeup
+void Monitor::initChildSignal() {
+#ifdef __linux__
+    sigset_t childSignal;
+    sigemptyset(&childSignal);
+    sigaddset(&childSignal, SIGCHLD);
+    if (sigprocmask(SIG_BLOCK, &childSignal, NULL) == 0) {
+        this->childSignalFd = signalfd(-1, &childSignal, SFD_NONBLOCK | SFD_CLOEXEC);
+    }
+    if (this->childSignalFd < 0) {
+        logger.warn() << "No signal fd for SIGCHLD, CGI children are reaped on wakeup";
+    }
+#endif
+}
+
+// A stop signal ends the loop instead of the process, so the Monitor is torn down and lines
+// still queued in the log buffer are written before exiting. SIGHUP reopens the access log
+// after it was rotated and SIGUSR1 logs the kept request traces
+void Monitor::initSignalHandlers() {
+    struct sigaction action;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = 0;  // No SA_RESTART: the signal must interrupt the event wait
+    action.sa_handler = Monitor::handleStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    action.sa_handler = Monitor::handleReopen;
+    sigaction(SIGHUP, &action, NULL);
+    action.sa_handler = Monitor::handleDump;
+    sigaction(SIGUSR1, &action, NULL);
+}
+
+void Monitor::handleStop(int signum) {
+    (void)signum;
+    stopRequested = 1;
+}
+
+// Any thread may take the signal, so every loop compares the count with the one it last saw
+void Monitor::handleReopen(int signum) {
+    (void)signum;
+    __atomic_add_fetch(&reopenRequests, 1, __ATOMIC_RELAXED);
+}
+
+void Monitor::handleDump(int signum) {
+    (void)signum;
+    __atomic_add_fetch(&dumpRequests, 1, __ATOMIC_RELAXED);
+}
+
+// Every loop writes the access log through its own buffer and file descriptor
+bool Monitor::initAccessLog() {
+    const std::string &path = this->config.getAccessLog();
+
+    this->reopenSeen = __atomic_load_n(&reopenRequests, __ATOMIC_RELAXED);
+    if (path.empty()) {
+        return true;
+    }
+    if (!this->accessLog.open(path, this->config.getAccessLogFormat(),
+                              this->config.getAccessLogBuffer(),
+                              this->config.getAccessLogFlush())) {
+        logger.error() << "Failed to open access log: " << path;
+        return false;
+    }
+    return true;
+}
+
+// Traces are only recorded by a TRACE=1 build, so the ring stays off without one
+void Monitor::initTraceRing() {
+    this->dumpSeen = __atomic_load_n(&dumpRequests, __ATOMIC_RELAXED);
+    if (this->config.getTraceRing() == 0) {
+        return;
+    }
+    if (!TRACE_ENABLED) {
+        logger.warn() << "trace_ring ignored: webserv was built without TRACE=1";
+        return;
+    }
+    this->traceLimit = this->config.getTraceRing();
+}
+
+// Starts cgi_workers warm interpreters for each worker pool whose interpreter is installed.
+// Workers replaced after cgi_worker_requests are started again as soon as they retire
+void Monitor::initCgiWorkers() {
+    if (this->config.getCgiWorkers() == 0) {
+        return;
+    }
+    std::vector<std::string> addresses = CgiWorker::getPoolAddresses();
+    for (std::size_t i = 0; i < addresses.size(); i++) {
+        if (!CgiWorker::isAvailable(addresses[i])) {
+            logger.warn() << "No interpreter found for " << addresses[i] << ", pool not started";
+            continue;
+        }
+        this->prestartFastCgi(this->getFastCgiUpstream(addresses[i]));
+    }
+}
+
+void Monitor::initConnectionLimit() {
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        logger.warn() << "getrlimit(RLIMIT_NOFILE) failed, using " << CONNECTION_TABLE_SIZE
+                      << " connections";
+        this->maxConnections = CONNECTION_TABLE_SIZE;
+        return;
+    }
+
+    // Raise the soft limit as far as the hard limit allows so idle keep-alive sockets fit
+    if (limit.rlim_cur < limit.rlim_max) {
+        rlim_t previous = limit.rlim_cur;
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+            limit.rlim_cur = previous;
+        }
+    }
+
+    this->maxConnections = static_cast<std::size_t>(limit.rlim_cur);
+    logger.info() << "Connection table limited to " << this->maxConnections << " fds";
+}
+
+bool Monitor::initEventBackend() {
+    std::string name = this->config.getEventBackend();
+    if (name.empty()) {
+        name = EventBackend::getDefaultName();
+    }
+
+    this->eventBackend = EventBackend::create(name, this->config.isEdgeTriggered(), this->logger);
+    if (this->eventBackend == NULL && name != "poll") {
+        logger.warn() << "Falling back to the poll event backend";
+        this->eventBackend = EventBackend::create("poll", false, this->logger);
+    }
+    if (this->eventBackend == NULL) {
+        logger.error() << "Failed to initialize an event backend";
+        return false;
+    }
+
+    logger.info() << "Using " << this->eventBackend->getName() << " event backend"
+                  << (this->eventBackend->isEdgeTriggered() ? " (edge-triggered)" : "");
+    return true;
+}
+
+// Worker processes each bind their own socket to the same port with SO_REUSEPORT, and the kernel
+// spreads incoming connections across them
+int Monitor::initListenFd(struct sockaddr_in &address, const Config::Listen &options,
+                          bool reusePort) {
     int listenFd = 0;
     int optVal = 1;
 
@@ -150,6 +308,21 @@ int Monitor::initListenFd(struct sockaddr_in &address) {
         return -1;
     }
 
+#ifdef SO_REUSEPORT
+    if (reusePort &&
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &optVal, sizeof(optVal)) < 0) {
+        tempLogger.error() << "setsockopt(SO_REUSEPORT) failed";
+        close(listenFd);
+        return -1;
+    }
+#else
+    if (reusePort) {
+        tempLogger.error() << "SO_REUSEPORT is not supported, worker processes cannot share ports";
+        close(listenFd);
+        return -1;
+    }
+#endif
+
     if (bind(listenFd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0) {
         tempLogger.error() << "bind() failed for " << ntohl(address.sin_addr.s_addr) << ":"
                            << ntohs(address.sin_port) << " - bind failed";
@@ -163,7 +336,29 @@ int Monitor::initListenFd(struct sockaddr_in &address) {
         return -1;  // Changed from return 1 to return -1 for consistency
     }
 
-    if (listen(listenFd, LISTEN_BACKLOG) < 0) {
+    // A CGI script, or anything it leaves behind, must not keep the port bound
+    if (fcntl(listenFd, F_SETFD, FD_CLOEXEC) < 0) {
+        tempLogger.error() << "fcntl(FD_CLOEXEC) failed";
+        close(listenFd);
+        return -1;
+    }
+
+    // A deferred socket only reports connections whose request is already in, so bursts of
+    // clients that connect and then stall cost the loop nothing
+    if (options.deferred) {
+#ifdef TCP_DEFER_ACCEPT
+        int deferSeconds = DEFER_ACCEPT_SECONDS;
+        if (setsockopt(listenFd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &deferSeconds,
+                       sizeof(deferSeconds)) < 0) {
+            tempLogger.warn() << "setsockopt(TCP_DEFER_ACCEPT) failed, accepting immediately";
+        }
+#else
+        tempLogger.warn() << "TCP_DEFER_ACCEPT is not supported, accepting immediately";
+#endif
+    }
+
+    // The kernel caps the backlog at net.core.somaxconn
+    if (listen(listenFd, options.backlog) < 0) {
         tempLogger.error() << "listen() failed";
         close(listenFd);
         return -1;
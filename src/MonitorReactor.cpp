@@ -0,0 +1,161 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MonitorReactor.cpp                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 18:20:37 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 18:20:37 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "Monitor.hpp"
+
+// Starts reactor_threads reactors, each with its own handoff queue and event backend. They are
+// all built before the first thread starts, so only the acceptor's thread touches its state
+bool Monitor::initReactors() {
+    const std::size_t count = this->config.getReactorThreads();
+
+    this->reactors.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        Reactor &reactor = this->reactors[i];
+        reactor.queue = new HandoffQueue();
+        if (!reactor.queue->init()) {
+            logger.error() << "Failed to create the handoff queue of reactor " << i;
+            return false;
+        }
+        reactor.monitor = this->createReactor(reactor.queue);
+        if (reactor.monitor == NULL) {
+            logger.error() << "Failed to initialize reactor " << i;
+            return false;
+        }
+    }
+    // Signals are left to this thread: the acceptor owns the reactors, stops them and wakes them
+    // to reopen their logs or dump their traces
+    sigset_t stopSignals;
+    sigset_t previous;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    sigaddset(&stopSignals, SIGHUP);
+    sigaddset(&stopSignals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+    for (std::size_t i = 0; i < count; i++) {
+        Reactor &reactor = this->reactors[i];
+        if (pthread_create(&reactor.thread, NULL, &Monitor::runReactor, reactor.monitor) != 0) {
+            logger.error() << "Failed to start reactor thread " << i;
+            pthread_sigmask(SIG_SETMASK, &previous, NULL);
+            return false;
+        }
+        reactor.started = true;
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    logger.info() << "Started " << count << " reactor threads ("
+                  << this->config.getReactorBalance() << ")";
+    return true;
+}
+
+// A reactor shares the acceptor's HttpServer and has no listen socket or signal fd of its own
+Monitor *Monitor::createReactor(HandoffQueue *queue) const {
+    Monitor *reactor = new Monitor(this->logger);
+
+    reactor->config = this->config;
+    reactor->servers = this->servers;
+    reactor->httpServer = this->httpServer;
+    reactor->maxConnections = this->maxConnections;
+    reactor->handoff = queue;
+    if (!reactor->initEventBackend() || !reactor->initAccessLog()) {
+        delete reactor;
+        return NULL;
+    }
+    reactor->metrics = Metrics::claimSlot();
+    reactor->initTraceRing();
+    reactor->initCgiWorkers();
+    return reactor;
+}
+
+void *Monitor::runReactor(void *monitor) {
+    static_cast<Monitor *>(monitor)->beginLoop();
+    return NULL;
+}
+
+// Gives an accepted socket to the next reactor in turn, or to the one with the fewest clients.
+// A reactor whose queue is full is far behind already, so the client is turned away
+void Monitor::handOff(int fdesc, int port) {
+    std::size_t index = this->nextReactor;
+
+    if (this->config.getReactorBalance() == "least_loaded") {
+        std::size_t lowest = 0;
+        for (std::size_t i = 0; i < this->reactors.size(); i++) {
+            const Reactor &reactor = this->reactors[i];
+            std::size_t    load = reactor.monitor->getClientCount() + reactor.queue->size();
+            if (i == 0 || load < lowest) {
+                lowest = load;
+                index = i;
+            }
+        }
+    } else {
+        this->nextReactor = (this->nextReactor + 1) % this->reactors.size();
+    }
+    if (!this->reactors[index].queue->push(fdesc, port)) {
+        logger.warn() << "Handoff queue of reactor " << index << " is full, refusing fd "
+                      << fdesc;
+        close(fdesc);
+    }
+}
+
+// Registers every socket the acceptor queued. A closed queue ends the reactor's loop
+Monitor::ExecResult Monitor::eventExecHandoff(Connection *entry) {
+    HandoffQueue::Item item;
+
+    (void)entry;
+    this->handoff->drainWakeups();
+    if (this->handoff->isClosed()) {
+        return Monitor::EXEC_FATAL_ERROR;
+    }
+    while (this->handoff->pop(item)) {
+        if (!this->addPollFd(item.fd, item.port, Connection::CONNECTION_CLIENT)) {
+            close(item.fd);
+        }
+    }
+    return Monitor::EXEC_SUCCESS;
+}
+
+// Reactors reap their own children, so the acceptor only tells them a child exited
+void Monitor::wakeReactors() {
+    for (std::size_t i = 0; i < this->reactors.size(); i++) {
+        this->reactors[i].queue->wake();
+    }
+}
+
+// Closes every queue and waits for the threads to leave their loops before their Monitors and
+// queues go away; the HttpServer they share outlives them
+void Monitor::stopReactors() {
+    for (std::size_t i = 0; i < this->reactors.size(); i++) {
+        if (this->reactors[i].started) {
+            this->reactors[i].queue->close();
+        }
+    }
+    for (std::size_t i = 0; i < this->reactors.size(); i++) {
+        Reactor &reactor = this->reactors[i];
+        if (reactor.started) {
+            pthread_join(reactor.thread, NULL);
+        }
+        delete reactor.monitor;
+        delete reactor.queue;
+    }
+    this->reactors.clear();
+}
+
+// Written by the reactor's thread only; other threads read it to pick the least loaded reactor
+std::size_t Monitor::getClientCount() const {
+    return __atomic_load_n(&this->clientCount, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,121 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   PollBackend.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:24:51 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 10:24:51 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "PollBackend.hpp"
+
+#include <poll.h>  // For poll
+
+#include <cstddef>  // For std::size_t, NULL
+#include <vector>   // For std::vector
+
+#define POLL_INITIAL_SIZE 64
+
+PollBackend::PollBackend() {
+    m_PollSet.reserve(POLL_INITIAL_SIZE);
+    m_Data.reserve(POLL_INITIAL_SIZE);
+    m_Slots.reserve(POLL_INITIAL_SIZE);
+}
+
+PollBackend::~PollBackend() {}
+
+bool PollBackend::add(int fdesc, int interest, void* data) {
+    if (fdesc < 0) {
+        return false;
+    }
+
+    // fd numbers are dense, so the slot index grows with the highest fd ever seen
+    if (static_cast<std::size_t>(fdesc) >= m_Slots.size()) {
+        m_Slots.resize(static_cast<std::size_t>(fdesc) + 1, -1);
+    }
+    if (m_Slots[fdesc] >= 0) {
+        return modify(fdesc, interest, data);
+    }
+
+    struct pollfd entry;
+    entry.fd = fdesc;
+    entry.events = toPollEvents(interest);
+    entry.revents = 0;
+
+    m_Slots[fdesc] = static_cast<int>(m_PollSet.size());
+    m_PollSet.push_back(entry);
+    m_Data.push_back(data);
+    return true;
+}
+
+bool PollBackend::modify(int fdesc, int interest, void* data) {
+    if (fdesc < 0 || static_cast<std::size_t>(fdesc) >= m_Slots.size() || m_Slots[fdesc] < 0) {
+        return false;
+    }
+    m_PollSet[m_Slots[fdesc]].events = toPollEvents(interest);
+    m_Data[m_Slots[fdesc]] = data;
+    return true;
+}
+
+void PollBackend::remove(int fdesc) {
+    if (fdesc < 0 || static_cast<std::size_t>(fdesc) >= m_Slots.size() || m_Slots[fdesc] < 0) {
+        return;
+    }
+
+    // Swap-and-pop: move the last entry into the freed slot instead of shifting the tail
+    int         slot = m_Slots[fdesc];
+    std::size_t last = m_PollSet.size() - 1;
+    if (static_cast<std::size_t>(slot) != last) {
+        m_PollSet[slot] = m_PollSet[last];
+        m_Data[slot] = m_Data[last];
+        m_Slots[m_PollSet[slot].fd] = slot;
+    }
+    m_PollSet.pop_back();
+    m_Data.pop_back();
+    m_Slots[fdesc] = -1;
+}
+
+int PollBackend::wait(EventList& ready, int timeoutMs) {
+    ready.clear();
+
+    struct pollfd* pollSet = m_PollSet.empty() ? NULL : &m_PollSet[0];
+    int            count = poll(pollSet, m_PollSet.size(), timeoutMs);
+    if (count <= 0) {
+        return count;
+    }
+
+    for (std::size_t i = 0; i < m_PollSet.size() && static_cast<int>(ready.size()) < count;
+         ++i) {
+        short revents = m_PollSet[i].revents;
+        if (revents == 0) {
+            continue;
+        }
+        m_PollSet[i].revents = 0;
+
+        Event event;
+        event.data = m_Data[i];
+        event.readable = (revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+        event.writable = (revents & POLLOUT) != 0;
+        event.hangup = (revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+        ready.push_back(event);
+    }
+    return static_cast<int>(ready.size());
+}
+
+const char* PollBackend::getName() const { return "poll"; }
+
+bool PollBackend::isEdgeTriggered() const { return false; }
+
+short PollBackend::toPollEvents(int interest) {
+    short events = 0;
+    if ((interest & EVENT_READ) != 0) {
+        events |= POLLIN;
+    }
+    if ((interest & EVENT_WRITE) != 0) {
+        events |= POLLOUT;
+    }
+    return events;
+}
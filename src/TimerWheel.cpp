@@ -0,0 +1,132 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TimerWheel.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 19:05:12 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 19:05:12 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "TimerWheel.hpp"
+
+#include <cstddef>  // For std::size_t, NULL
+#include <ctime>    // For time
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+TimerWheel::TimerWheel() : m_Current(time(NULL)) {
+    for (std::size_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        initHead(m_Slots[i]);
+    }
+    initHead(m_Expired);
+}
+
+// Timers still linked belong to owners that outlive the wheel; they are detached so their own
+// destructors do not touch freed heads
+TimerWheel::~TimerWheel() {
+    for (std::size_t i = 0; i <= TIMER_WHEEL_SLOTS; i++) {
+        Node& head = i < TIMER_WHEEL_SLOTS ? m_Slots[i] : m_Expired;
+        while (!isEmpty(head)) {
+            head.next->unlink();
+        }
+        head.prev = NULL;
+        head.next = NULL;
+    }
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+void TimerWheel::Node::unlink() {
+    if (next == NULL) {
+        return;
+    }
+    prev->next = next;
+    next->prev = prev;
+    prev = NULL;
+    next = NULL;
+}
+
+// A deadline already past lands in the next slot to be processed
+void TimerWheel::schedule(Node& node, time_t expires) {
+    node.unlink();
+    node.expires = expires;
+    if (expires <= m_Current) {
+        expires = m_Current + 1;
+    }
+    append(m_Slots[expires % TIMER_WHEEL_SLOTS], node);
+}
+
+// Visits the slots of every second since the last call, all of them at most once
+void TimerWheel::advance(time_t now) {
+    time_t second = m_Current;
+
+    for (std::size_t visited = 0; second < now && visited < TIMER_WHEEL_SLOTS; visited++) {
+        second++;
+        Node& head = m_Slots[second % TIMER_WHEEL_SLOTS];
+        Node* node = head.next;
+        while (node != &head) {
+            Node* next = node->next;
+            if (node->expires <= now) {
+                node->unlink();
+                append(m_Expired, *node);
+            }
+            node = next;
+        }
+    }
+    if (now > m_Current) {
+        m_Current = now;
+    }
+}
+
+TimerWheel::Node* TimerWheel::popExpired() {
+    if (isEmpty(m_Expired)) {
+        return NULL;
+    }
+    Node* node = m_Expired.next;
+    node->unlink();
+    return node;
+}
+
+// Time until the next slot holding a timer, capped at maxMs. Such a slot may only hold later
+// deadlines that wrapped around, which costs one early wakeup
+int TimerWheel::getWaitMs(time_t now, int maxMs) const {
+    const int millisPerSecond = 1000;
+
+    if (!isEmpty(m_Expired)) {
+        return 0;
+    }
+    for (time_t second = m_Current + 1; second <= m_Current + TIMER_WHEEL_SLOTS; second++) {
+        if (second - now > maxMs / millisPerSecond) {
+            break;
+        }
+        if (!isEmpty(m_Slots[second % TIMER_WHEEL_SLOTS])) {
+            return second <= now ? 0 : static_cast<int>(second - now) * millisPerSecond;
+        }
+    }
+    return maxMs;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Private Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+void TimerWheel::initHead(Node& head) {
+    head.prev = &head;
+    head.next = &head;
+}
+
+void TimerWheel::append(Node& head, Node& node) {
+    node.prev = head.prev;
+    node.next = &head;
+    head.prev->next = &node;
+    head.prev = &node;
+}
+
+bool TimerWheel::isEmpty(const Node& head) { return head.next == &head; }
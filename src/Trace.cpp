@@ -0,0 +1,86 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Trace.cpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 21:05:12 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 21:05:12 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Trace.hpp"
+
+#include <stdint.h>  // For uint64_t, int64_t
+
+#include <cstddef>  // For std::size_t
+#include <ostream>  // For std::ostream
+
+#include "AccessLog.hpp"
+
+static const char* const s_PointNames[] = {"accept",  "first_byte", "headers",  "location",
+                                           "handler", "serialized", "last_byte"};
+
+// Each reactor thread serves one request at a time
+static __thread RequestTrace* s_Current = NULL;
+
+/* @------------------------------------------------------------------------@ */
+/* |                        Constructor/Destructor                          | */
+/* @------------------------------------------------------------------------@ */
+
+RequestTrace::RequestTrace() {
+    for (std::size_t i = 0; i < POINT_COUNT; i++) {
+        at[i] = 0;
+    }
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Public Methods                             | */
+/* @------------------------------------------------------------------------@ */
+
+// Starts over for the next request on the connection
+void RequestTrace::restart() {
+    for (std::size_t i = FIRST_BYTE; i < POINT_COUNT; i++) {
+        at[i] = 0;
+    }
+}
+
+void Trace::mark(RequestTrace& trace, RequestTrace::Point point) {
+    trace.at[point] = AccessLog::now();
+}
+
+void Trace::enter(RequestTrace* trace) { s_Current = trace; }
+
+void Trace::markCurrent(RequestTrace::Point point) {
+    if (s_Current != NULL) {
+        s_Current->at[point] = AccessLog::now();
+    }
+}
+
+// Every step in microseconds from the first byte, so accept is negative; "-" or null where the
+// request never got there. Text is a single field: accept:-512,headers:40,...
+void Trace::write(std::ostream& out, const RequestTrace& trace, bool json) {
+    const uint64_t origin = trace.at[RequestTrace::FIRST_BYTE];
+    bool           first = true;
+
+    out << (json ? "{" : "");
+    for (std::size_t i = 0; i < RequestTrace::POINT_COUNT; i++) {
+        if (i == RequestTrace::FIRST_BYTE) {
+            continue;
+        }
+        out << (first ? "" : ",");
+        first = false;
+        if (json) {
+            out << '"' << s_PointNames[i] << "\":";
+        } else {
+            out << s_PointNames[i] << ':';
+        }
+        if (origin == 0 || trace.at[i] == 0) {
+            out << (json ? "null" : "-");
+        } else {
+            out << static_cast<int64_t>(trace.at[i] - origin);
+        }
+    }
+    out << (json ? "}" : "");
+}
@@ -17,16 +17,24 @@
 
 #include "Config.hpp"
 #include "Logger.hpp"
+#include "Master.hpp"
+#include "Metrics.hpp"
 #include "Monitor.hpp"
 
 static int execMonitor(const Config& config, Logger& logger) {
-    Monitor monitor(logger);
+    int status = 0;
 
-    if (monitor.init(config) < 0) {
-        return (-1);
+    logger.startAsync(config.getLogBuffer(), config.isLogOverflowBlocking());
+    {
+        Monitor monitor(logger);
+        if (monitor.init(config) < 0) {
+            status = -1;
+        } else {
+            monitor.beginLoop();
+        }
     }
-    monitor.beginLoop();
-    return (0);
+    Logger::stopAsync();
+    return (status);
 }
 
 int main(int argc, char* argv[]) {
@@ -36,15 +44,9 @@ int main(int argc, char* argv[]) {
         return (1);
     }
 
-    std::ofstream file("webserv.log", std::ios::app);
-    if (!file.is_open()) {
-        return (1);
-    }
     const bool enableColour = true;
-    Logger     logger(
-            std::cout,
-            enableColour);  // NOTE(srvariable): Using std::cout instead of file to have colours
-    Config config(logger);
+    Logger     logger(std::cout, enableColour);
+    Config     config(logger);
 
     if (argc == 1) {
         const char* programName = argv[0];
@@ -58,9 +60,32 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    execMonitor(config, logger);
+    // Colours are only meant for a terminal
+    std::ofstream file;
+    if (!config.getLogFile().empty()) {
+        file.open(config.getLogFile().c_str(), std::ios::app);
+        if (!file.is_open()) {
+            logger.error() << "Failed to open log file: " << config.getLogFile();
+            return (1);
+        }
+    }
+    Logger serverLogger = file.is_open() ? Logger(file) : logger;
+
+    // Shared by all workers, so it must exist before the first fork
+    if (!Metrics::init(config)) {
+        logger.error() << "Failed to map the metrics counters";
+        return (1);
+    }
+
+    int status = 0;
+    if (config.getWorkerProcesses() > 1) {
+        Master master(config, serverLogger);
+        status = master.run();
+    } else {
+        status = execMonitor(config, serverLogger) < 0 ? 1 : 0;
+    }
 
     file.close();
 
-    return (0);
+    return (status);
 }
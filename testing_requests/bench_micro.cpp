@@ -0,0 +1,406 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bench_micro.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 22:31:05 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 22:31:05 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+// Microbenchmarks for the request parser, the response serializer, location routing, MIME type
+// lookup and config loading. Each benchmark runs for at least --time seconds and reports the
+// time and the heap allocations per operation; allocations are counted by replacing the global
+// operator new. Results go to the terminal and, as JSON lines, to the output file.
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/Config.hpp"
+#include "../include/HttpRequest.hpp"
+#include "../include/HttpResponse.hpp"
+#include "../include/HttpServer.hpp"
+#include "../include/Logger.hpp"
+
+#define DEFAULT_TIME     0.5
+#define DEFAULT_CORPUS   "sample_requests.txt"
+#define DEFAULT_OUTPUT   "micro_results.jsonl"
+#define ROUTING_SMALL    10
+#define ROUTING_LARGE    500
+#define CONFIG_SERVERS   100
+#define CONFIG_LOCATIONS 10  // Per server
+
+/* @------------------------------------------------------------------------@ */
+/* |                          Allocation Section                            | */
+/* @------------------------------------------------------------------------@ */
+
+static uint64_t allocations = 0;
+static uint64_t allocatedBytes = 0;
+
+void* operator new(std::size_t size) throw(std::bad_alloc) {
+    allocations++;
+    allocatedBytes += size;
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == NULL) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](std::size_t size) throw(std::bad_alloc) { return operator new(size); }
+
+// Kept out of line so the compiler does not pair the inlined free with a new expression
+__attribute__((noinline)) void operator delete(void* memory) throw() { std::free(memory); }
+
+void operator delete[](void* memory) throw() { operator delete(memory); }
+
+/* @------------------------------------------------------------------------@ */
+/* |                           Harness Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+struct Fixtures {
+    Logger*                   logger;
+    std::vector<std::string>  corpus;
+    HttpResponse*             response;
+    Config*                   smallRouting;
+    Config*                   largeRouting;
+    std::vector<std::string>  routingPaths;
+    std::vector<std::string>  fileNames;
+    std::string               configPath;
+};
+
+// Runs iterations operations; the returned value only keeps the compiler from dropping them
+typedef std::size_t (*BenchFunction)(Fixtures& fixtures, std::size_t iterations);
+
+struct Benchmark {
+    const char*   name;
+    BenchFunction function;
+};
+
+static volatile std::size_t sink = 0;
+
+static uint64_t now() {
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+    return static_cast<uint64_t>(spec.tv_sec) * 1000000000 + spec.tv_nsec;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                          Benchmark Section                             | */
+/* @------------------------------------------------------------------------@ */
+
+static std::size_t benchParseCorpus(Fixtures& fixtures, std::size_t iterations) {
+    HttpRequest request(*fixtures.logger);
+    std::size_t complete = 0;
+
+    for (std::size_t i = 0; i < iterations; i++) {
+        complete += request.parse(fixtures.corpus[i % fixtures.corpus.size()]) ? 1 : 0;
+    }
+    return complete;
+}
+
+static std::size_t benchParseBrowserGet(Fixtures& fixtures, std::size_t iterations) {
+    HttpRequest request(*fixtures.logger);
+    std::size_t complete = 0;
+
+    for (std::size_t i = 0; i < iterations; i++) {
+        complete += request.parse(fixtures.corpus[0]) ? 1 : 0;
+    }
+    return complete;
+}
+
+static std::size_t benchResponseToString(Fixtures& fixtures, std::size_t iterations) {
+    std::size_t length = 0;
+
+    for (std::size_t i = 0; i < iterations; i++) {
+        length += fixtures.response->toString().length();
+    }
+    return length;
+}
+
+static std::size_t benchResponseSerializeHead(Fixtures& fixtures, std::size_t iterations) {
+    std::string head;
+    std::size_t length = 0;
+
+    for (std::size_t i = 0; i < iterations; i++) {
+        fixtures.response->serializeHead(head);
+        length += head.length();
+    }
+    return length;
+}
+
+static std::size_t route(const Config& config, const std::vector<std::string>& paths,
+                         std::size_t iterations) {
+    const Config::Server& server = config.getServers()[0];
+    std::size_t           matched = 0;
+
+    for (std::size_t i = 0; i < iterations; i++) {
+        matched += HttpServer::testFindMatchingLocation(server, paths[i % paths.size()]) != NULL;
+    }
+    return matched;
+}
+
+static std::size_t benchRoutingSmall(Fixtures& fixtures, std::size_t iterations) {
+    return route(*fixtures.smallRouting, fixtures.routingPaths, iterations);
+}
+
+static std::size_t benchRoutingLarge(Fixtures& fixtures, std::size_t iterations) {
+    return route(*fixtures.largeRouting, fixtures.routingPaths, iterations);
+}
+
+static std::size_t benchContentType(Fixtures& fixtures, std::size_t iterations) {
+    std::size_t length = 0;
+
+    for (std::size_t i = 0; i < iterations; i++) {
+        length += HttpResponse::getContentType(fixtures.fileNames[i % fixtures.fileNames.size()])
+                      .length();
+    }
+    return length;
+}
+
+static std::size_t benchConfigLoad(Fixtures& fixtures, std::size_t iterations) {
+    std::size_t servers = 0;
+
+    for (std::size_t i = 0; i < iterations; i++) {
+        Config config(*fixtures.logger);
+        if (config.load(fixtures.configPath)) {
+            servers += config.getServers().size();
+        }
+    }
+    return servers;
+}
+
+static const Benchmark benchmarks[] = {
+    {"parse_corpus", benchParseCorpus},
+    {"parse_browser_get", benchParseBrowserGet},
+    {"response_to_string", benchResponseToString},
+    {"response_serialize_head", benchResponseSerializeHead},
+    {"routing_10_locations", benchRoutingSmall},
+    {"routing_500_locations", benchRoutingLarge},
+    {"content_type", benchContentType},
+    {"config_load_1000_locations", benchConfigLoad},
+};
+
+/* @------------------------------------------------------------------------@ */
+/* |                           Fixture Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+// The request examples are the ``` blocks of the corpus file, with CRLF line endings
+static void loadCorpus(const std::string& path, std::vector<std::string>& corpus) {
+    std::ifstream file(path.c_str());
+    std::string   line;
+    std::string   request;
+    bool          inBlock = false;
+
+    while (std::getline(file, line)) {
+        if (line.compare(0, 3, "```") == 0) {
+            if (inBlock && !request.empty()) {
+                corpus.push_back(request);
+            }
+            inBlock = !inBlock;
+            request.clear();
+        } else if (inBlock) {
+            request += line + "\r\n";
+        }
+    }
+}
+
+static void addBuiltinRequests(std::vector<std::string>& corpus) {
+    corpus.insert(corpus.begin(),
+                  "GET /static/app.js?v=3 HTTP/1.1\r\n"
+                  "Host: localhost:8080\r\n"
+                  "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101\r\n"
+                  "Accept: */*\r\n"
+                  "Accept-Language: en-US,en;q=0.5\r\n"
+                  "Accept-Encoding: gzip, deflate, br\r\n"
+                  "Referer: http://localhost:8080/\r\n"
+                  "Connection: keep-alive\r\n"
+                  "Cookie: session=4f2a9c; theme=dark\r\n\r\n");
+    corpus.push_back("POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 64\r\n\r\n" +
+                     std::string(64, 'b'));
+    corpus.push_back("POST /form HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n"
+                     "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n");
+    corpus.push_back("DELETE /files/old.txt HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+static bool writeRoutingConfig(const std::string& path, std::size_t locations) {
+    std::ofstream file(path.c_str());
+
+    file << "server {\n    listen 8080;\n    root ./html;\n\n    location / {\n        root ./html;\n"
+         << "    }\n";
+    for (std::size_t i = 0; i < locations; i++) {
+        file << "    location /app" << i << "/v" << i % 7 << " {\n        root ./html;\n"
+             << "        allow_methods GET POST;\n    }\n";
+    }
+    file << "}\n";
+    return file.good();
+}
+
+static bool writeLargeConfig(const std::string& path) {
+    std::ofstream file(path.c_str());
+
+    file << "keepalive_timeout 30;\nopen_file_cache 1000;\n";
+    for (std::size_t i = 0; i < CONFIG_SERVERS; i++) {
+        file << "server {\n    listen " << 10000 + i << ";\n    root ./html;\n"
+             << "    index index.html index.htm;\n    error_page 404 /404.html;\n";
+        for (std::size_t j = 0; j < CONFIG_LOCATIONS; j++) {
+            file << "    location /site" << j << " {\n        root ./html/site" << j << ";\n"
+                 << "        allow_methods GET POST DELETE;\n        autoindex on;\n"
+                 << "        client_max_body_size 10M;\n    }\n";
+        }
+        file << "}\n";
+    }
+    return file.good();
+}
+
+static Config* loadConfig(const Logger& logger, const std::string& path) {
+    Config* config = new Config(logger);
+
+    if (!config->load(path) || config->getServers().empty()) {
+        delete config;
+        return NULL;
+    }
+    return config;
+}
+
+static bool createFixtures(Fixtures& fixtures, const std::string& corpusPath,
+                           const std::string& scratch) {
+    loadCorpus(corpusPath, fixtures.corpus);
+    addBuiltinRequests(fixtures.corpus);
+
+    fixtures.response = new HttpResponse(200, *fixtures.logger);
+    fixtures.response->setHeader("Content-Type", "text/html; charset=utf-8");
+    fixtures.response->setHeader("Cache-Control", "max-age=60");
+    fixtures.response->setHeader("Connection", "keep-alive");
+    fixtures.response->setBody(std::string(1024, 'r'));
+
+    if (!writeRoutingConfig(scratch + "/small.conf", ROUTING_SMALL) ||
+        !writeRoutingConfig(scratch + "/large.conf", ROUTING_LARGE) ||
+        !writeLargeConfig(scratch + "/config.conf")) {
+        return false;
+    }
+    fixtures.smallRouting = loadConfig(*fixtures.logger, scratch + "/small.conf");
+    fixtures.largeRouting = loadConfig(*fixtures.logger, scratch + "/large.conf");
+    fixtures.configPath = scratch + "/config.conf";
+    for (std::size_t i = 0; i < 16; i++) {
+        std::ostringstream path;
+        path << "/app" << i * 31 % ROUTING_LARGE << "/v" << i * 31 % ROUTING_LARGE % 7
+             << "/index.html";
+        fixtures.routingPaths.push_back(path.str());
+    }
+    fixtures.routingPaths.push_back("/");
+    fixtures.routingPaths.push_back("/missing/path/file.css");
+
+    const char* names[] = {"index.html", "style.css", "app.js",  "data.json", "logo.png",
+                           "photo.jpg",  "doc.pdf",   "archive", "video.mp4", "UPPER.HTML"};
+    fixtures.fileNames.assign(names, names + sizeof(names) / sizeof(names[0]));
+    return fixtures.smallRouting != NULL && fixtures.largeRouting != NULL;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                             Main Section                               | */
+/* @------------------------------------------------------------------------@ */
+
+// Doubles the iterations until a run lasts minSeconds, then reports that run
+static void runBenchmark(const Benchmark& benchmark, Fixtures& fixtures, double minSeconds,
+                         const std::string& label, std::ofstream& output) {
+    std::size_t iterations = 1;
+    uint64_t    elapsed = 0;
+    uint64_t    allocs = 0;
+    uint64_t    bytes = 0;
+
+    while (true) {
+        const uint64_t allocsBefore = allocations;
+        const uint64_t bytesBefore = allocatedBytes;
+        const uint64_t start = now();
+        sink = sink + benchmark.function(fixtures, iterations);
+        elapsed = now() - start;
+        allocs = allocations - allocsBefore;
+        bytes = allocatedBytes - bytesBefore;
+        if (elapsed >= static_cast<uint64_t>(minSeconds * 1e9) || iterations >= (1UL << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+    const double nsPerOp = static_cast<double>(elapsed) / iterations;
+    const double allocsPerOp = static_cast<double>(allocs) / iterations;
+    const double bytesPerOp = static_cast<double>(bytes) / iterations;
+
+    std::cout << std::left << std::setw(28) << benchmark.name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(12) << nsPerOp << std::setprecision(2)
+              << std::setw(12) << allocsPerOp << std::setprecision(0) << std::setw(12)
+              << bytesPerOp << std::setw(12) << iterations << std::endl;
+    output << std::fixed << std::setprecision(2) << "{\"label\":\"" << label
+           << "\",\"benchmark\":\"" << benchmark.name << "\",\"time\":" << time(NULL)
+           << ",\"iterations\":" << iterations << ",\"ns_per_op\":" << nsPerOp
+           << ",\"allocs_per_op\":" << allocsPerOp << ",\"bytes_per_op\":" << bytesPerOp
+           << "}\n";
+}
+
+int main(int argc, char** argv) {
+    double        minSeconds = DEFAULT_TIME;
+    std::string   corpusPath = DEFAULT_CORPUS;
+    std::string   outputPath = DEFAULT_OUTPUT;
+    std::string   label;
+    std::string   filter;
+    char          scratch[] = "/tmp/webserv_micro_XXXXXX";
+    std::ofstream devNull("/dev/null");
+    Logger        logger(devNull, false);
+    Fixtures      fixtures;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        if (option == "--time") {
+            minSeconds = std::atof(argv[i + 1]);
+        } else if (option == "--corpus") {
+            corpusPath = argv[i + 1];
+        } else if (option == "--output") {
+            outputPath = argv[i + 1];
+        } else if (option == "--label") {
+            label = argv[i + 1];
+        } else if (option == "--filter") {
+            filter = argv[i + 1];
+        }
+    }
+    std::ofstream output(outputPath.c_str(), std::ios::app);
+    fixtures.logger = &logger;
+    if (!output.is_open() || mkdtemp(scratch) == NULL ||
+        !createFixtures(fixtures, corpusPath, scratch)) {
+        std::cerr << "Cannot set up the benchmarks" << std::endl;
+        return 1;
+    }
+
+    std::cout << "webserv microbenchmarks: " << fixtures.corpus.size() << " corpus requests, "
+              << minSeconds << "s minimum per benchmark" << std::endl;
+    std::cout << std::left << std::setw(28) << "benchmark" << std::right << std::setw(12)
+              << "ns/op" << std::setw(12) << "allocs/op" << std::setw(12) << "bytes/op"
+              << std::setw(12) << "iterations" << std::endl;
+    for (std::size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        if (filter.empty() || std::string(benchmarks[i].name).find(filter) != std::string::npos) {
+            runBenchmark(benchmarks[i], fixtures, minSeconds, label, output);
+        }
+    }
+    std::cout << "Results appended to " << outputPath << std::endl;
+
+    unlink((std::string(scratch) + "/small.conf").c_str());
+    unlink((std::string(scratch) + "/large.conf").c_str());
+    unlink(fixtures.configPath.c_str());
+    rmdir(scratch);
+    delete fixtures.response;
+    delete fixtures.smallRouting;
+    delete fixtures.largeRouting;
+    return 0;
+}
@@ -0,0 +1,634 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   bench_webserv.cpp                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 21:48:30 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 21:48:30 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+// Load generator for webserv. Starts the server on a scratch directory with its own fixtures and
+// drives it with closed-loop clients: each connection sends a request, waits for the whole
+// response and sends the next one, over the same connection or a new one. Every scenario reports
+// requests per second, latency percentiles and the server's resident memory, on the terminal and
+// as one JSON object per line appended to the output file, so runs can be compared across
+// commits.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define DEFAULT_PORT        18480
+#define DEFAULT_CONNECTIONS 32
+#define DEFAULT_DURATION    3.0
+#define DEFAULT_OUTPUT      "bench_results.jsonl"
+#define DRAIN_TIMEOUT_US    2000000  // Responses still awaited once a scenario's time is up
+#define STARTUP_ATTEMPTS    50       // Connection attempts, 100ms apart, while the server starts
+#define READ_SIZE           65536
+#define SMALL_FILE_SIZE     1024
+#define LARGE_FILE_SIZE     1048576
+#define LISTING_ENTRIES     100
+#define UPLOAD_SIZE         4096
+
+struct Options {
+    std::string              server;
+    std::string              output;
+    std::string              label;
+    std::string              only;        // Single scenario to run, empty runs all
+    std::vector<std::string> directives;  // Extra top level lines for the generated config
+    std::size_t              connections;
+    double                   duration;
+    int                      port;
+};
+
+struct Scenario {
+    const char* name;
+    const char* method;
+    const char* path;
+    bool        keepAlive;
+    std::size_t bodySize;
+};
+
+static const Scenario scenarios[] = {
+    {"small_keepalive", "GET", "/small.html", true, 0},
+    {"small_close", "GET", "/small.html", false, 0},
+    {"large_keepalive", "GET", "/large.bin", true, 0},
+    {"large_close", "GET", "/large.bin", false, 0},
+    {"autoindex", "GET", "/listing/", true, 0},
+    {"upload", "POST", "/upload", true, UPLOAD_SIZE},
+    {"cgi", "GET", "/bench.cgi", true, 0},
+};
+
+struct Client {
+    int         fd;
+    std::string request;
+    std::size_t sent;
+    std::string response;
+    uint64_t    started;  // 0 while no request is in flight
+};
+
+struct Result {
+    std::size_t           requests;
+    std::size_t           errors;
+    uint64_t              bytes;  // Response bytes, heads included
+    double                seconds;
+    std::vector<uint64_t> latencies;  // Microseconds
+    long                  rssKb;
+    long                  peakRssKb;
+
+    Result() : requests(0), errors(0), bytes(0), seconds(0), rssKb(0), peakRssKb(0) {}
+};
+
+static uint64_t now() {
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+    return static_cast<uint64_t>(spec.tv_sec) * 1000000 + spec.tv_nsec / 1000;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Server Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+static bool writeFile(const std::string& path, const std::string& content, mode_t mode) {
+    std::ofstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << content;
+    file.close();
+    return chmod(path.c_str(), mode) == 0;
+}
+
+// The server writes uploads to ./html, so it runs in a directory of its own
+static bool createFixtures(const std::string& root, const Options& options) {
+    const std::string html = root + "/html";
+    std::ostringstream config;
+
+    if (mkdir(html.c_str(), 0755) != 0 || mkdir((html + "/listing").c_str(), 0755) != 0) {
+        return false;
+    }
+    for (std::size_t i = 0; i < LISTING_ENTRIES; i++) {
+        std::ostringstream name;
+        name << html << "/listing/entry_" << i << ".txt";
+        if (!writeFile(name.str(), "listed\n", 0644)) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < options.directives.size(); i++) {
+        config << options.directives[i] << "\n";
+    }
+    config << "server {\n"
+           << "    listen " << options.port << ";\n"
+           << "    root ./html;\n"
+           << "    index index.html;\n\n"
+           << "    location / {\n"
+           << "        root ./html;\n"
+           << "        allow_methods GET;\n"
+           << "        autoindex on;\n"
+           << "    }\n\n"
+           << "    location /upload {\n"
+           << "        root ./html;\n"
+           << "        allow_methods POST;\n"
+           << "        client_max_body_size 10M;\n"
+           << "    }\n"
+           << "}\n";
+    return writeFile(html + "/index.html", "<h1>webserv bench</h1>\n", 0644) &&
+           writeFile(html + "/small.html", std::string(SMALL_FILE_SIZE, 's'), 0644) &&
+           writeFile(html + "/large.bin", std::string(LARGE_FILE_SIZE, 'l'), 0644) &&
+           writeFile(html + "/bench.cgi",
+                     "#!/bin/sh\nprintf 'Content-Type: text/plain\\r\\n\\r\\nhello from cgi\\n'\n",
+                     0755) &&
+           writeFile(root + "/bench.conf", config.str(), 0644);
+}
+
+static void removeTree(const std::string& path) {
+    DIR* dir = opendir(path.c_str());
+
+    if (dir == NULL) {
+        unlink(path.c_str());
+        return;
+    }
+    for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            removeTree(path + "/" + name);
+        }
+    }
+    closedir(dir);
+    rmdir(path.c_str());
+}
+
+static int connectTo(int port) {
+    struct sockaddr_in address;
+    const int          fdesc = socket(AF_INET, SOCK_STREAM, 0);
+    const int          enable = 1;
+
+    if (fdesc < 0) {
+        return -1;
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fdesc, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fdesc);
+        return -1;
+    }
+    setsockopt(fdesc, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    fcntl(fdesc, F_SETFL, fcntl(fdesc, F_GETFL) | O_NONBLOCK);
+    return fdesc;
+}
+
+static pid_t startServer(const std::string& root, const Options& options) {
+    const pid_t pid = fork();
+
+    if (pid == 0) {
+        const int log = open((root + "/webserv.log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (chdir(root.c_str()) != 0 || log < 0) {
+            _exit(1);
+        }
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        close(log);
+        execl(options.server.c_str(), options.server.c_str(), "bench.conf", (char*)NULL);
+        _exit(1);
+    }
+    if (pid < 0) {
+        return -1;
+    }
+    for (int i = 0; i < STARTUP_ATTEMPTS; i++) {
+        usleep(100000);
+        const int fdesc = connectTo(options.port);
+        if (fdesc >= 0) {
+            close(fdesc);
+            return pid;
+        }
+        if (waitpid(pid, NULL, WNOHANG) == pid) {
+            return -1;
+        }
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    return -1;
+}
+
+static void stopServer(pid_t pid) {
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+}
+
+// A line of /proc/<pid>/status in kilobytes, 0 if the process is gone
+static long readStatus(pid_t pid, const std::string& field) {
+    std::ostringstream path;
+    path << "/proc/" << pid << "/status";
+    std::ifstream status(path.str().c_str());
+    std::string   line;
+
+    while (std::getline(status, line)) {
+        if (line.compare(0, field.length(), field) == 0) {
+            return std::atol(line.c_str() + field.length());
+        }
+    }
+    return 0;
+}
+
+// Memory of the server and its children, so worker_processes counts every worker
+static void readMemory(pid_t server, long& rssKb, long& peakRssKb) {
+    DIR* proc = opendir("/proc");
+
+    rssKb = readStatus(server, "VmRSS:");
+    peakRssKb = readStatus(server, "VmHWM:");
+    if (proc == NULL) {
+        return;
+    }
+    for (struct dirent* entry = readdir(proc); entry != NULL; entry = readdir(proc)) {
+        const pid_t pid = std::atoi(entry->d_name);
+        if (pid > 0 && pid != server && readStatus(pid, "PPid:") == server) {
+            rssKb += readStatus(pid, "VmRSS:");
+            peakRssKb += readStatus(pid, "VmHWM:");
+        }
+    }
+    closedir(proc);
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Client Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+static std::string buildRequest(const Scenario& scenario) {
+    std::ostringstream request;
+
+    request << scenario.method << ' ' << scenario.path << " HTTP/1.1\r\n"
+            << "Host: localhost\r\n"
+            << "User-Agent: webserv-bench\r\n";
+    if (!scenario.keepAlive) {
+        request << "Connection: close\r\n";
+    }
+    if (scenario.bodySize > 0) {
+        request << "Content-Type: text/plain\r\n"
+                << "Content-Length: " << scenario.bodySize << "\r\n\r\n"
+                << std::string(scenario.bodySize, 'u');
+    } else {
+        request << "\r\n";
+    }
+    return request.str();
+}
+
+static std::string toLower(std::string text) {
+    for (std::size_t i = 0; i < text.length(); i++) {
+        text[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])));
+    }
+    return text;
+}
+
+// Whether the buffer holds a whole response, and if so its status, its length and whether the
+// server closes the connection after it. A response with neither Content-Length nor chunked
+// encoding ends with the connection, which the caller sees
+static bool parseResponse(const std::string& buffer, int& status, std::size_t& length,
+                          bool& closing) {
+    const std::size_t headEnd = buffer.find("\r\n\r\n");
+
+    if (headEnd == std::string::npos) {
+        return false;
+    }
+    const std::string head = toLower(buffer.substr(0, headEnd + 2));
+    status = std::atoi(head.c_str() + head.find(' ') + 1);
+    closing = head.find("\r\nconnection: close") != std::string::npos;
+    std::size_t body = headEnd + 4;
+
+    const std::size_t contentLength = head.find("\r\ncontent-length:");
+    if (contentLength != std::string::npos) {
+        length = body + std::strtoul(head.c_str() + contentLength + 17, NULL, 10);
+        return buffer.length() >= length;
+    }
+    if (head.find("\r\ntransfer-encoding: chunked") == std::string::npos) {
+        return false;
+    }
+    while (true) {
+        const std::size_t lineEnd = buffer.find("\r\n", body);
+        if (lineEnd == std::string::npos) {
+            return false;
+        }
+        const std::size_t size = std::strtoul(buffer.c_str() + body, NULL, 16);
+        if (size == 0) {
+            length = lineEnd + 4;  // No trailers
+            return buffer.length() >= length;
+        }
+        body = lineEnd + 2 + size + 2;
+        if (buffer.length() < body) {
+            return false;
+        }
+    }
+}
+
+// Sends the next request, or stops the client once the scenario's time is up
+static void nextRequest(Client& client, uint64_t deadline) {
+    client.sent = 0;
+    client.started = now() < deadline ? now() : 0;
+}
+
+// Connects for the next request, which is timed from before the connect
+static void reconnect(Client& client, Result& result, const Options& options, uint64_t deadline) {
+    const uint64_t started = now();
+
+    client.sent = 0;
+    client.response.clear();
+    client.started = 0;
+    if (started >= deadline) {
+        return;
+    }
+    client.fd = connectTo(options.port);
+    if (client.fd < 0) {
+        result.errors++;
+        return;
+    }
+    client.started = started;
+}
+
+static void finishResponse(Client& client, Result& result, int status, std::size_t length) {
+    result.requests++;
+    result.bytes += length;
+    result.latencies.push_back(now() - client.started);
+    if (status >= 400 || status < 100) {
+        result.errors++;
+    }
+    client.response.erase(0, length);
+}
+
+static void closeClient(Client& client) {
+    if (client.fd >= 0) {
+        close(client.fd);
+    }
+    client.fd = -1;
+    client.started = 0;
+}
+
+// Reads what the socket holds; returns false once the connection is over
+static bool readClient(Client& client, Result& result, const Scenario& scenario,
+                       const Options& options, uint64_t deadline) {
+    char          buffer[READ_SIZE];
+    const ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+    int           status = 0;
+    std::size_t   length = 0;
+    bool          closing = false;
+
+    if (received > 0) {
+        client.response.append(buffer, static_cast<std::size_t>(received));
+    }
+    if (received < 0) {
+        return true;
+    }
+    if (received == 0) {
+        // Without a length the response ends with the connection; with one it was cut short
+        if (client.response.find("\r\n\r\n") != std::string::npos &&
+            !parseResponse(client.response, status, length, closing)) {
+            finishResponse(client, result, status, client.response.length());
+        } else {
+            result.errors++;
+        }
+        closeClient(client);
+        reconnect(client, result, options, deadline);
+        return false;
+    }
+    if (!parseResponse(client.response, status, length, closing)) {
+        return true;
+    }
+    finishResponse(client, result, status, length);
+    // keepalive_requests ends even a keep-alive connection now and then
+    if (!scenario.keepAlive || closing) {
+        closeClient(client);
+        reconnect(client, result, options, deadline);
+        return false;
+    }
+    nextRequest(client, deadline);
+    return true;
+}
+
+static bool runScenario(const Scenario& scenario, const Options& options, pid_t server,
+                        Result& result) {
+    std::vector<Client>        clients(options.connections);
+    std::vector<struct pollfd> fds(options.connections);
+    const std::string          request = buildRequest(scenario);
+    const uint64_t             begin = now();
+    const uint64_t             deadline = begin + static_cast<uint64_t>(options.duration * 1e6);
+
+    for (std::size_t i = 0; i < clients.size(); i++) {
+        clients[i].request = request;
+        reconnect(clients[i], result, options, deadline);
+        if (clients[i].fd < 0) {
+            std::cerr << "Cannot connect to 127.0.0.1:" << options.port << std::endl;
+            for (std::size_t j = 0; j < i; j++) {
+                closeClient(clients[j]);
+            }
+            return false;
+        }
+    }
+    while (true) {
+        std::size_t active = 0;
+        for (std::size_t i = 0; i < clients.size(); i++) {
+            Client& client = clients[i];
+            fds[i].fd = client.started != 0 ? client.fd : -1;
+            fds[i].events = client.sent < client.request.length() ? POLLOUT : POLLIN;
+            fds[i].revents = 0;
+            active += client.started != 0 ? 1 : 0;
+        }
+        if (active == 0 || now() > deadline + DRAIN_TIMEOUT_US) {
+            break;
+        }
+        if (poll(&fds[0], fds.size(), 100) < 0) {
+            break;
+        }
+        for (std::size_t i = 0; i < clients.size(); i++) {
+            Client& client = clients[i];
+            if (fds[i].revents == 0 || client.fd != fds[i].fd) {
+                continue;
+            }
+            if ((fds[i].revents & POLLOUT) != 0) {
+                const ssize_t written = send(client.fd, client.request.data() + client.sent,
+                                             client.request.length() - client.sent, MSG_NOSIGNAL);
+                if (written > 0) {
+                    client.sent += static_cast<std::size_t>(written);
+                }
+            } else {
+                readClient(client, result, scenario, options, deadline);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < clients.size(); i++) {
+        result.errors += clients[i].started != 0 ? 1 : 0;  // Never answered
+        closeClient(clients[i]);
+    }
+    result.seconds = static_cast<double>(now() - begin) / 1e6;
+    readMemory(server, result.rssKb, result.peakRssKb);
+    return true;
+}
+
+/* @------------------------------------------------------------------------@ */
+/* |                            Report Section                              | */
+/* @------------------------------------------------------------------------@ */
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const std::size_t index = static_cast<std::size_t>(fraction * sorted.size());
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void report(const Scenario& scenario, const Options& options, Result& result,
+                   std::ofstream& output) {
+    std::sort(result.latencies.begin(), result.latencies.end());
+    const double rps = result.seconds > 0 ? result.requests / result.seconds : 0;
+    const double mbps = result.seconds > 0 ? result.bytes / result.seconds / 1048576 : 0;
+
+    std::cout << std::left << std::setw(18) << scenario.name << std::right << std::fixed
+              << std::setprecision(0) << std::setw(10) << rps << std::setprecision(1)
+              << std::setw(9) << mbps << std::setw(9) << percentile(result.latencies, 0.50)
+              << std::setw(9) << percentile(result.latencies, 0.99) << std::setw(9)
+              << percentile(result.latencies, 0.999) << std::setw(8) << result.errors
+              << std::setw(10) << result.rssKb << std::setw(10) << result.peakRssKb << std::endl;
+
+    output << std::fixed << std::setprecision(2) << "{\"label\":\"" << options.label
+           << "\",\"scenario\":\"" << scenario.name << "\",\"time\":" << time(NULL)
+           << ",\"connections\":" << options.connections << ",\"seconds\":" << result.seconds
+           << ",\"requests\":" << result.requests << ",\"errors\":" << result.errors
+           << ",\"rps\":" << rps << ",\"mib_per_s\":" << mbps
+           << ",\"p50_us\":" << percentile(result.latencies, 0.50)
+           << ",\"p99_us\":" << percentile(result.latencies, 0.99)
+           << ",\"p999_us\":" << percentile(result.latencies, 0.999) << ",\"max_us\":"
+           << (result.latencies.empty() ? 0 : result.latencies.back())
+           << ",\"rss_kb\":" << result.rssKb << ",\"peak_rss_kb\":" << result.peakRssKb << "}\n";
+}
+
+static void printUsage(const char* name) {
+    std::cout << "Usage: " << name << " [options]\n"
+              << "  --server PATH      webserv binary (default ../webserv)\n"
+              << "  --connections N    concurrent clients (default " << DEFAULT_CONNECTIONS
+              << ")\n"
+              << "  --duration S       seconds per scenario (default " << DEFAULT_DURATION
+              << ")\n"
+              << "  --port N           port the server listens on (default " << DEFAULT_PORT
+              << ")\n"
+              << "  --scenario NAME    run a single scenario\n"
+              << "  --set LINE         add a top level directive, e.g. \"reactor_threads 2;\"\n"
+              << "  --label TEXT       stored with every result, e.g. a commit hash\n"
+              << "  --output FILE      JSON lines appended here (default " << DEFAULT_OUTPUT
+              << ")\n"
+              << "Scenarios:";
+    for (std::size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        std::cout << ' ' << scenarios[i].name;
+    }
+    std::cout << std::endl;
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    options.server = "../webserv";
+    options.output = DEFAULT_OUTPUT;
+    options.connections = DEFAULT_CONNECTIONS;
+    options.duration = DEFAULT_DURATION;
+    options.port = DEFAULT_PORT;
+    for (int i = 1; i < argc; i++) {
+        const std::string option = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (option == "--server") {
+            options.server = value;
+        } else if (option == "--connections") {
+            options.connections = std::strtoul(value.c_str(), NULL, 10);
+        } else if (option == "--duration") {
+            options.duration = std::atof(value.c_str());
+        } else if (option == "--port") {
+            options.port = std::atoi(value.c_str());
+        } else if (option == "--scenario") {
+            options.only = value;
+        } else if (option == "--set") {
+            options.directives.push_back(value);
+        } else if (option == "--label") {
+            options.label = value;
+        } else if (option == "--output") {
+            options.output = value;
+        } else {
+            return false;
+        }
+    }
+    return options.connections > 0 && options.duration > 0 && options.port > 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    char    resolved[PATH_MAX];
+    char    scratch[] = "/tmp/webserv_bench_XXXXXX";
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (realpath(options.server.c_str(), resolved) == NULL) {
+        std::cerr << "webserv binary not found: " << options.server << std::endl;
+        return 1;
+    }
+    options.server = resolved;
+    std::ofstream output(options.output.c_str(), std::ios::app);
+    if (!output.is_open() || mkdtemp(scratch) == NULL) {
+        std::cerr << "Cannot open " << options.output << " or create a scratch directory"
+                  << std::endl;
+        return 1;
+    }
+    const std::string root = scratch;
+    const pid_t       server = createFixtures(root, options) ? startServer(root, options) : -1;
+    if (server < 0) {
+        std::cerr << "webserv did not start, see " << root << "/webserv.log" << std::endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "webserv bench: " << options.connections << " connections, " << options.duration
+              << "s per scenario" << std::endl;
+    std::cout << std::left << std::setw(18) << "scenario" << std::right << std::setw(10) << "rps"
+              << std::setw(9) << "MiB/s" << std::setw(9) << "p50 us" << std::setw(9) << "p99 us"
+              << std::setw(9) << "p999 us" << std::setw(8) << "errors" << std::setw(10)
+              << "rss kB" << std::setw(10) << "peak kB" << std::endl;
+    int status = 0;
+    for (std::size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        Result result;
+        if (!options.only.empty() && options.only != scenarios[i].name) {
+            continue;
+        }
+        if (!runScenario(scenarios[i], options, server, result)) {
+            status = 1;
+            break;
+        }
+        report(scenarios[i], options, result, output);
+    }
+    stopServer(server);
+    removeTree(root);
+    std::cout << "Results appended to " << options.output << std::endl;
+    return status;
+}
@@ -0,0 +1,265 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_handoffqueue.cpp                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 00:35:47 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/18 00:35:47 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../include/HandoffQueue.hpp"
+
+// Far above any open fd, so items a test leaves queued are harmless when the queue closes them
+#define FAKE_FD 100000
+
+#define STRESS_ITEMS 200000
+
+std::string toString(size_t value) {
+    std::ostringstream oss;
+    oss << value;
+    return oss.str();
+}
+
+void printTestHeader(const std::string& testName) {
+    std::cout << "\n===========================================" << std::endl;
+    std::cout << "  " << testName << std::endl;
+    std::cout << "===========================================" << std::endl;
+}
+
+void printResult(bool success, const std::string& testName) {
+    std::cout << "[" << (success ? "PASS" : "FAIL") << "] " << testName << std::endl;
+}
+
+bool isWakeFdReadable(const HandoffQueue& queue) {
+    struct pollfd entry;
+    entry.fd = queue.getWakeFd();
+    entry.events = POLLIN;
+    entry.revents = 0;
+    return poll(&entry, 1, 0) == 1 && (entry.revents & POLLIN) != 0;
+}
+
+bool testPushPopWraparound() {
+    printTestHeader("Push/Pop Wraparound");
+
+    HandoffQueue queue;
+    bool         inOrder = queue.init();
+    size_t       pushed = 0;
+    size_t       popped = 0;
+
+    // Batches that do not divide the ring size, so the indices wrap at every offset
+    for (int round = 0; round < 10 && inOrder; round++) {
+        for (int i = 0; i < 700; i++, pushed++) {
+            inOrder = inOrder && queue.push(FAKE_FD + static_cast<int>(pushed), 8000 + i);
+        }
+        HandoffQueue::Item item;
+        while (queue.pop(item)) {
+            inOrder = inOrder && item.fd == FAKE_FD + static_cast<int>(popped) &&
+                      item.port == 8000 + static_cast<int>(popped % 700);
+            popped++;
+        }
+        queue.drainWakeups();
+    }
+    std::cout << "Pushed " << pushed << ", popped " << popped << " in "
+              << (inOrder ? "order" : "the wrong order") << std::endl;
+    bool success = inOrder && pushed == popped && pushed > 3 * HANDOFF_QUEUE_SIZE &&
+                   queue.size() == 0;
+    printResult(success, "Push/pop wraparound");
+    return success;
+}
+
+bool testFullQueue() {
+    printTestHeader("Full Queue");
+
+    HandoffQueue queue;
+    bool         filled = queue.init();
+    for (int i = 0; i < HANDOFF_QUEUE_SIZE; i++) {
+        filled = filled && queue.push(FAKE_FD + i, 80);
+    }
+    const bool   rejected = !queue.push(FAKE_FD + HANDOFF_QUEUE_SIZE, 80);
+    const size_t fullSize = queue.size();
+
+    // Popping one frees exactly one slot
+    HandoffQueue::Item item;
+    const bool         popped = queue.pop(item) && item.fd == FAKE_FD;
+    const bool         accepted = queue.push(FAKE_FD + HANDOFF_QUEUE_SIZE, 80);
+    const bool         fullAgain = !queue.push(FAKE_FD + HANDOFF_QUEUE_SIZE + 1, 80);
+
+    std::cout << "Filled: " << (filled ? "YES" : "NO") << ", size " << fullSize
+              << ", extra push rejected: " << (rejected ? "YES" : "NO")
+              << ", room after pop: " << (accepted ? "YES" : "NO") << std::endl;
+    bool success = filled && rejected && fullSize == HANDOFF_QUEUE_SIZE && popped && accepted &&
+                   fullAgain;
+    printResult(success, "Full queue");
+    return success;
+}
+
+bool testWakeups() {
+    printTestHeader("Wakeups");
+
+    HandoffQueue queue;
+    bool         initialized = queue.init();
+    const bool   idle = !isWakeFdReadable(queue);
+
+    // Many pushes leave a single byte to read
+    for (int i = 0; i < 50; i++) {
+        queue.push(FAKE_FD + i, 80);
+    }
+    const bool woken = isWakeFdReadable(queue);
+    char       buffer[64];
+    const bool oneByte = read(queue.getWakeFd(), buffer, sizeof(buffer)) == 1;
+
+    // Once drained, the next push wakes the reactor again
+    queue.drainWakeups();
+    const bool quiet = !isWakeFdReadable(queue);
+    queue.push(FAKE_FD + 50, 80);
+    const bool wokenAgain = isWakeFdReadable(queue);
+
+    HandoffQueue::Item item;
+    while (queue.pop(item)) {
+    }
+    std::cout << "Woken: " << (woken ? "YES" : "NO") << ", one byte: " << (oneByte ? "YES" : "NO")
+              << ", woken after drain: " << (wokenAgain ? "YES" : "NO") << std::endl;
+    bool success = initialized && idle && woken && oneByte && quiet && wokenAgain;
+    printResult(success, "Wakeups");
+    return success;
+}
+
+bool testCloseAndDrain() {
+    printTestHeader("Close And Drain");
+
+    int  pipeFds[2] = {-1, -1};
+    bool closedQueued = false;
+    bool drained = true;
+    bool flagged = false;
+    bool woken = false;
+    {
+        HandoffQueue queue;
+        drained = queue.init() && pipe(pipeFds) == 0;
+        queue.push(FAKE_FD, 80);
+        queue.push(FAKE_FD + 1, 81);
+        queue.drainWakeups();
+        queue.close();
+        flagged = queue.isClosed();
+        woken = isWakeFdReadable(queue);
+
+        // Closing stops nothing already queued from being handed over
+        HandoffQueue::Item item;
+        drained = drained && queue.pop(item) && item.fd == FAKE_FD && queue.pop(item) &&
+                  item.fd == FAKE_FD + 1 && !queue.pop(item);
+
+        // Sockets no reactor popped are closed with the queue
+        queue.push(pipeFds[0], 80);
+    }
+    closedQueued = fcntl(pipeFds[0], F_GETFD) < 0;
+    close(pipeFds[1]);
+
+    std::cout << "Closed: " << (flagged ? "YES" : "NO") << ", woken: " << (woken ? "YES" : "NO")
+              << ", drained in order: " << (drained ? "YES" : "NO")
+              << ", leftover fd closed: " << (closedQueued ? "YES" : "NO") << std::endl;
+    bool success = flagged && woken && drained && closedQueued;
+    printResult(success, "Close and drain");
+    return success;
+}
+
+struct StressState {
+    HandoffQueue queue;
+    size_t       rejected;
+};
+
+void* produce(void* argument) {
+    StressState* state = static_cast<StressState*>(argument);
+    for (int i = 0; i < STRESS_ITEMS; i++) {
+        while (!state->queue.push(FAKE_FD + i, i % 65536)) {
+            state->rejected++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// One producer thread against this consumer thread, the way the acceptor feeds a reactor
+bool testConcurrentHandoff() {
+    printTestHeader("Concurrent Handoff");
+
+    StressState state;
+    state.rejected = 0;
+    if (!state.queue.init()) {
+        printResult(false, "Concurrent handoff (init failed)");
+        return false;
+    }
+    pthread_t producer;
+    pthread_create(&producer, NULL, produce, &state);
+
+    int  expected = 0;
+    bool inOrder = true;
+    while (expected < STRESS_ITEMS && inOrder) {
+        HandoffQueue::Item item;
+        if (!state.queue.pop(item)) {
+            state.queue.drainWakeups();
+            continue;
+        }
+        inOrder = item.fd == FAKE_FD + expected && item.port == expected % 65536;
+        expected++;
+    }
+    pthread_join(producer, NULL);
+
+    std::cout << "Received " << expected << "/" << STRESS_ITEMS << " in "
+              << (inOrder ? "order" : "the wrong order") << ", full-queue retries "
+              << state.rejected << std::endl;
+    bool success = inOrder && expected == STRESS_ITEMS;
+    printResult(success, "Concurrent handoff (" + toString(static_cast<size_t>(expected)) +
+                             " sockets)");
+    return success;
+}
+
+int main() {
+    std::cout << "=====================================================" << std::endl;
+    std::cout << "            HandoffQueue Test Suite                 " << std::endl;
+    std::cout << "=====================================================" << std::endl;
+
+    int totalTests = 0;
+    int passedTests = 0;
+
+    if (testPushPopWraparound()) passedTests++;
+    totalTests++;
+
+    if (testFullQueue()) passedTests++;
+    totalTests++;
+
+    if (testWakeups()) passedTests++;
+    totalTests++;
+
+    if (testCloseAndDrain()) passedTests++;
+    totalTests++;
+
+    if (testConcurrentHandoff()) passedTests++;
+    totalTests++;
+
+    std::cout << "\n=====================================================" << std::endl;
+    std::cout << "                    TEST SUMMARY                     " << std::endl;
+    std::cout << "=====================================================" << std::endl;
+    std::cout << "Tests Passed: " << passedTests << "/" << totalTests << std::endl;
+
+    if (passedTests == totalTests) {
+        std::cout << "🎉 ALL HANDOFF QUEUE TESTS PASSED!" << std::endl;
+    } else {
+        std::cout << "❌ Some tests failed. Review the HandoffQueue implementation." << std::endl;
+    }
+
+    std::cout << "=====================================================" << std::endl;
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
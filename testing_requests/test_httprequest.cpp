@@ -255,6 +255,148 @@ bool testEdgeCases() {
     return allPassed;
 }
 
+bool testKeepAlive() {
+    printTestHeader("Keep-Alive and Pipelining");
+    
+    HttpRequest request;
+    int passedTests = 0;
+    
+    // Test 1: HTTP/1.1 persists by default, HTTP/1.0 does not
+    std::string http11 = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string http10 = "GET / HTTP/1.0\r\n\r\n";
+    bool defaults = request.parse(http11) && request.isKeepAlive();
+    defaults = defaults && request.parse(http10) && !request.isKeepAlive();
+    if (defaults) {
+        std::cout << "Version defaults: HANDLED ✓" << std::endl;
+        passedTests++;
+    } else {
+        std::cout << "Version defaults: FAILED ✗" << std::endl;
+    }
+    
+    // Test 2: Connection header tokens override the defaults
+    std::string close11 = "GET / HTTP/1.1\r\nConnection: TE, Close\r\n\r\n";
+    std::string keep10 = "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n";
+    bool overrides = request.parse(close11) && !request.isKeepAlive();
+    overrides = overrides && request.parse(keep10) && request.isKeepAlive();
+    if (overrides) {
+        std::cout << "Connection header: HANDLED ✓" << std::endl;
+        passedTests++;
+    } else {
+        std::cout << "Connection header: FAILED ✗" << std::endl;
+    }
+    
+    // Test 3: Only the first of two pipelined requests is consumed
+    std::string first = "POST /submit HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello";
+    std::string pipelined = first + "GET /next HTTP/1.1\r\n\r\n";
+    if (request.parse(pipelined) && request.getBody() == "hello" &&
+        request.getRequestLength() == first.length()) {
+        std::cout << "Pipelined requests: HANDLED ✓" << std::endl;
+        passedTests++;
+    } else {
+        std::cout << "Pipelined requests: FAILED ✗" << std::endl;
+    }
+    
+    bool allPassed = (passedTests == 3);
+    printResult(allPassed, "Keep-alive (" + toString(passedTests) + "/3)");
+    return allPassed;
+}
+
+bool testIncrementalParsing() {
+    printTestHeader("Incremental Parsing");
+    
+    HttpRequest request;
+    int passedTests = 0;
+    
+    std::string rawRequest = "POST /form HTTP/1.1\r\n"
+                           "Host: localhost\r\n"
+                           "Content-Length: 4\r\n"
+                           "\r\n"
+                           "a=bc";
+    
+    // Test 1: Feeding one more byte at a time only completes on the last one
+    bool waited = true;
+    HttpRequest::ParseStatus status = HttpRequest::PARSE_INCOMPLETE;
+    for (std::size_t length = 1; length <= rawRequest.length(); ++length) {
+        status = request.feed(rawRequest.data(), length);
+        if (length < rawRequest.length() && status != HttpRequest::PARSE_INCOMPLETE) {
+            waited = false;
+        }
+    }
+    if (waited && status == HttpRequest::PARSE_COMPLETE && request.getBody() == "a=bc" &&
+        request.getHeader("host") == "localhost") {
+        std::cout << "Byte-by-byte feed: HANDLED ✓" << std::endl;
+        passedTests++;
+    } else {
+        std::cout << "Byte-by-byte feed: FAILED ✗" << std::endl;
+    }
+    
+    // Test 2: The head is reported before the body has arrived
+    request.clear();
+    std::string head = rawRequest.substr(0, rawRequest.length() - 4);
+    if (request.feed(head.data(), head.length()) == HttpRequest::PARSE_INCOMPLETE &&
+        request.isHeaderComplete() && request.getHeaderLength() == head.length() &&
+        request.getContentLength() == 4) {
+        std::cout << "Head before body: HANDLED ✓" << std::endl;
+        passedTests++;
+    } else {
+        std::cout << "Head before body: FAILED ✗" << std::endl;
+    }
+    
+    // Test 3: Headers stay readable after the parsed buffer is gone
+    request.clear();
+    {
+        std::string transient = "GET / HTTP/1.1\r\nX-Token:  abc \r\n\r\n";
+        request.parse(transient);
+    }
+    if (request.getHeader("x-token") == "abc") {
+        std::cout << "Owned header values: HANDLED ✓" << std::endl;
+        passedTests++;
+    } else {
+        std::cout << "Owned header values: FAILED ✗" << std::endl;
+    }
+    
+    bool allPassed = (passedTests == 3);
+    printResult(allPassed, "Incremental parsing (" + toString(passedTests) + "/3)");
+    return allPassed;
+}
+
+bool testBinaryBody() {
+    printTestHeader("Binary Body");
+    
+    HttpRequest request;
+    int passedTests = 0;
+    
+    const char binary[] = {'a', '\0', 'b', '\0', '\xff'};
+    std::string body(binary, sizeof(binary));
+    std::string head = "POST /bin HTTP/1.1\r\nContent-Length: 5\r\n\r\n";
+    
+    // Test 1: NUL bytes survive a one-shot parse
+    if (request.parse(head + body) && request.getBody() == body) {
+        std::cout << "Buffered binary body: HANDLED ✓" << std::endl;
+        passedTests++;
+    } else {
+        std::cout << "Buffered binary body: FAILED ✗" << std::endl;
+    }
+    
+    // Test 2: NUL bytes survive a body streamed in with appendBody
+    request.clear();
+    request.feed(head.data(), head.length());
+    bool streamed = request.appendBody(body.data(), 2) == HttpRequest::PARSE_INCOMPLETE &&
+                    request.getBodyRemaining() == 3 &&
+                    request.appendBody(body.data() + 2, 3) == HttpRequest::PARSE_COMPLETE &&
+                    request.getBody() == body;
+    if (streamed) {
+        std::cout << "Streamed binary body: HANDLED ✓" << std::endl;
+        passedTests++;
+    } else {
+        std::cout << "Streamed binary body: FAILED ✗" << std::endl;
+    }
+    
+    bool allPassed = (passedTests == 2);
+    printResult(allPassed, "Binary body (" + toString(passedTests) + "/2)");
+    return allPassed;
+}
+
 int main() {
     std::cout << "=====================================================" << std::endl;
     std::cout << "           HttpRequest Comprehensive Test Suite     " << std::endl;
@@ -282,6 +424,15 @@ int main() {
     if (testEdgeCases()) passedTests++;
     totalTests++;
     
+    if (testKeepAlive()) passedTests++;
+    totalTests++;
+    
+    if (testIncrementalParsing()) passedTests++;
+    totalTests++;
+    
+    if (testBinaryBody()) passedTests++;
+    totalTests++;
+    
     // Final summary
     std::cout << "\n=====================================================" << std::endl;
     std::cout << "                    TEST SUMMARY                     " << std::endl;
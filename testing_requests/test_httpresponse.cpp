@@ -10,10 +10,16 @@
 /*                                                                            */
 /* ************************************************************************** */
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 
+#include "../include/CgiResponse.hpp"
 #include "../include/HttpResponse.hpp"
 #include "../include/Logger.hpp"
 
@@ -296,6 +302,136 @@ bool testStatusCodes() {
     return allPassed;
 }
 
+bool testHeadSerialization() {
+    printTestHeader("Head Serialization");
+
+    HttpResponse response(404);
+    response.setHeader("Content-Type", "text/plain");
+    response.setBody("missing");
+    std::string full = response.toString();
+
+    // The head ends at the blank line and the body is handed over without a copy
+    std::string head;
+    response.serializeHead(head);
+    std::string body;
+    response.releaseBody(body);
+    bool success = full == head + body && body == "missing" && response.getBody().empty() &&
+                   head.compare(0, 23, "HTTP/1.1 404 Not Found\r") == 0 &&
+                   head.find("Content-Length: 7\r\n") != std::string::npos &&
+                   head.substr(head.length() - 4) == "\r\n\r\n";
+    std::cout << "Head: " << head.length() << " bytes, body: '" << body << "'" << std::endl;
+
+    printResult(success, "Head serialization");
+    return success;
+}
+
+bool testFileBody() {
+    printTestHeader("File Body Streaming");
+
+    const std::string smallPath = "/tmp/webserv_test_small.txt";
+    const std::string largePath = "/tmp/webserv_test_large.bin";
+    std::ofstream small(smallPath.c_str());
+    small << "small file";
+    small.close();
+    std::ofstream large(largePath.c_str(), std::ios::binary);
+    large << std::string(FILE_BODY_THRESHOLD + 10, 'x');
+    large.close();
+
+    // Small files are still loaded into the body
+    HttpResponse inMemory;
+    inMemory.setBodyFromFile(smallPath);
+    bool test1 = !inMemory.hasFileBody() && inMemory.getBody() == "small file";
+
+    // Large files keep an fd; only the head is serialized and Content-Length covers the file
+    HttpResponse response;
+    response.setBodyFromFile(largePath);
+    std::string head = response.toString();
+    bool test2 = response.hasFileBody() && response.getBody().empty() &&
+                 response.getContentLength() == FILE_BODY_THRESHOLD + 10 &&
+                 head.find("Content-Length: " + toString(FILE_BODY_THRESHOLD + 10)) !=
+                     std::string::npos &&
+                 head.substr(head.length() - 4) == "\r\n\r\n";
+
+    // Copies own their own fd, and releasing hands it over exactly once. No fd may leak
+    // into CGI children
+    HttpResponse copy(response);
+    HttpResponse assigned;
+    assigned = response;
+    int fdesc = copy.releaseFileBody();
+    int other = assigned.releaseFileBody();
+    int original = response.releaseFileBody();
+    bool test3 = fdesc >= 0 && other >= 0 && original >= 0 && fdesc != original &&
+                 other != original && !copy.hasFileBody() && !response.hasFileBody() &&
+                 (fcntl(fdesc, F_GETFD) & FD_CLOEXEC) && (fcntl(other, F_GETFD) & FD_CLOEXEC) &&
+                 (fcntl(original, F_GETFD) & FD_CLOEXEC);
+    close(fdesc);
+    close(other);
+    close(original);
+    std::cout << "Small in memory: " << (test1 ? "YES" : "NO")
+              << ", large streamed: " << (test2 ? "YES" : "NO")
+              << ", fds owned and close-on-exec: " << (test3 ? "YES" : "NO") << std::endl;
+
+    std::remove(smallPath.c_str());
+    std::remove(largePath.c_str());
+    bool success = test1 && test2 && test3;
+    printResult(success, "File body streaming");
+    return success;
+}
+
+bool feedCgi(CgiResponse& cgi, const std::string& output) {
+    return cgi.parse(output.data(), output.length());
+}
+
+bool testCgiResponse() {
+    printTestHeader("CGI Response Parsing");
+
+    // Headers split across reads; Status becomes the status line, framing headers are dropped
+    CgiResponse cgi;
+    bool test1 = !feedCgi(cgi, "Status: 404 Gone Away\r\nContent-Type: text/plain\r") &&
+                 feedCgi(cgi, "\nContent-Length: 3\r\nX-Test: 1\r\n\r\nabc");
+    HttpResponse response;
+    cgi.apply(response);
+    std::string head;
+    response.serializeHead(head);
+    std::string body;
+    cgi.takeBody(body);
+    test1 = test1 && head.compare(0, 23, "HTTP/1.1 404 Gone Away\r") == 0 &&
+            head.find("Content-Type: text/plain\r\n") != std::string::npos &&
+            head.find("X-Test: 1\r\n") != std::string::npos &&
+            head.find("Content-Length") == std::string::npos && body == "abc";
+
+    // A Location alone redirects
+    cgi.clear();
+    feedCgi(cgi, "Location: /elsewhere\n\n");
+    HttpResponse redirect;
+    cgi.apply(redirect);
+    bool test2 = redirect.getStatusCode() == 302;
+
+    // Output without a header line is all body, served as text/html
+    cgi.clear();
+    bool test3 = feedCgi(cgi, "<h1>hi</h1>\n");
+    HttpResponse plain;
+    cgi.apply(plain);
+    head.clear();
+    plain.serializeHead(head);
+    cgi.takeBody(body);
+    test3 = test3 && body == "<h1>hi</h1>\n" && plain.getStatusCode() == 200 &&
+            head.find("Content-Type: text/html\r\n") != std::string::npos;
+
+    // Output that ends inside the header block still counts as headers
+    cgi.clear();
+    bool test4 = !feedCgi(cgi, "Status: 204");
+    cgi.finish();
+    cgi.takeBody(body);
+    test4 = test4 && cgi.isComplete() && cgi.getStatus() == 204 && body.empty();
+    std::cout << "Split: " << (test1 ? "YES" : "NO") << ", redirect: " << (test2 ? "YES" : "NO")
+              << ", bare body: " << (test3 ? "YES" : "NO") << std::endl;
+
+    bool success = test1 && test2 && test3 && test4;
+    printResult(success, "CGI response parsing");
+    return success;
+}
+
 int main() {
     std::cout << "=====================================================" << std::endl;
     std::cout << "           HttpResponse Comprehensive Test Suite    " << std::endl;
@@ -326,6 +462,15 @@ int main() {
     if (testStatusCodes()) passedTests++;
     totalTests++;
     
+    if (testHeadSerialization()) passedTests++;
+    totalTests++;
+    
+    if (testFileBody()) passedTests++;
+    totalTests++;
+
+    if (testCgiResponse()) passedTests++;
+    totalTests++;
+    
     // Final summary
     std::cout << "\n=====================================================" << std::endl;
     std::cout << "                    TEST SUMMARY                     " << std::endl;
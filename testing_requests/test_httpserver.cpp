@@ -14,11 +14,14 @@
 #include <sstream>
 #include <string>
 #include <fstream>
+#include <vector>
 
 #include "../include/HttpServer.hpp"
 #include "../include/HttpRequest.hpp"
 #include "../include/HttpResponse.hpp"
+#include "../include/CgiWorker.hpp"
 #include "../include/Config.hpp"
+#include "../include/FastCgi.hpp"
 #include "../include/Logger.hpp"
 
 std::string toString(size_t value) {
@@ -218,6 +221,97 @@ bool testServerConfiguration() {
     return success;
 }
 
+bool testFastCgiRecords() {
+    printTestHeader("FastCGI Record Framing");
+    
+    std::vector<std::string> params;
+    params.push_back("REQUEST_METHOD=POST");
+    params.push_back("HTTP_X_LONG=" + std::string(300, 'v'));
+    std::string body(70000, 'b');
+    
+    std::string wire;
+    FastCgi::appendBeginRequest(wire, 1, true);
+    FastCgi::appendParams(wire, 1, params);
+    FastCgi::appendStream(wire, FastCgi::STDIN, 1, body.data(), body.length());
+    FastCgi::appendStream(wire, FastCgi::STDIN, 1, NULL, 0);
+    
+    // Walk the records back, one byte short of the last one first
+    FastCgi::Record record;
+    std::size_t offset = 0;
+    bool partial = !FastCgi::parseRecord(wire.substr(0, 8), offset, record) && offset == 0;
+    int records = 0;
+    std::string stdinData;
+    std::string paramData;
+    while (FastCgi::parseRecord(wire, offset, record)) {
+        records++;
+        if (record.type == FastCgi::PARAMS) paramData += record.content;
+        if (record.type == FastCgi::STDIN) stdinData += record.content;
+    }
+    
+    // An END_REQUEST body: appStatus 3, protocolStatus 0
+    std::string end("\x01\x03\x00\x01\x00\x08\x00\x00\x00\x00\x00\x03\x00\x00\x00\x00", 16);
+    std::size_t endOffset = 0;
+    bool ended = FastCgi::parseRecord(end, endOffset, record) &&
+                 record.type == FastCgi::END_REQUEST && FastCgi::getAppStatus(record) == 3;
+    
+    // begin + params + empty params + 2 stdin + empty stdin
+    bool success = partial && records == 6 && offset == wire.length() && stdinData == body &&
+                   paramData.find("REQUEST_METHOD") != std::string::npos && ended;
+    
+    std::cout << "Records parsed: " << records << ", stdin bytes: " << stdinData.length() << std::endl;
+    std::cout << "Params bytes: " << paramData.length() << ", app status parsed: " << (ended ? "YES" : "NO") << std::endl;
+    
+    printResult(success, "FastCGI record round trip");
+    return success;
+}
+
+bool testCgiWorkerRouting() {
+    printTestHeader("CGI Worker Pool Routing");
+    
+    std::string python = CgiWorker::getPoolAddress("./html/script.py");
+    std::string perl = CgiWorker::getPoolAddress("/var/www/cgi/report.pl");
+    std::string native = CgiWorker::getPoolAddress("./html/test.cgi");
+    std::string tricky = CgiWorker::getPoolAddress("./html/archive.py.bak");
+    
+    bool success = python == "worker:.py" && perl == "worker:.pl" && native.empty() &&
+                   tricky.empty() && CgiWorker::isPoolAddress(python) &&
+                   !CgiWorker::isPoolAddress("unix:/run/php-fpm.sock") &&
+                   CgiWorker::getPoolAddresses().size() == 2;
+    
+    std::cout << "script.py -> " << python << ", report.pl -> " << perl << std::endl;
+    std::cout << "test.cgi and archive.py.bak are forked: " << (native.empty() && tricky.empty() ? "YES" : "NO") << std::endl;
+    
+    printResult(success, "Pooled extensions map to worker pools");
+    return success;
+}
+
+bool testCgiEnvironment() {
+    printTestHeader("CGI Environment");
+    
+    HttpRequest request;
+    request.parse("GET /cgi/env.py?name=value HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    std::vector<std::string> env = HttpServer::testBuildCgiEnvironment(request, "./html/cgi/env.py");
+    
+    int protocolEntries = 0;
+    std::string protocol;
+    bool hasQuery = false;
+    for (size_t i = 0; i < env.size(); i++) {
+        if (env[i].compare(0, 16, "SERVER_PROTOCOL=") == 0) {
+            protocolEntries++;
+            protocol = env[i];
+        }
+        if (env[i] == "QUERY_STRING=name=value") hasQuery = true;
+    }
+    
+    bool success = protocolEntries == 1 && protocol == "SERVER_PROTOCOL=HTTP/1.1" && hasQuery;
+    
+    std::cout << "Protocol entry: " << protocol << std::endl;
+    std::cout << "Query string split off: " << (hasQuery ? "YES" : "NO") << std::endl;
+    
+    printResult(success, "SERVER_PROTOCOL carries the request version as sent");
+    return success;
+}
+
 int main() {
     std::cout << "=====================================================" << std::endl;
     std::cout << "           HttpServer Comprehensive Test Suite      " << std::endl;
@@ -250,6 +344,15 @@ int main() {
     if (testServerConfiguration()) passedTests++;
     totalTests++;
     
+    if (testFastCgiRecords()) passedTests++;
+    totalTests++;
+    
+    if (testCgiWorkerRouting()) passedTests++;
+    totalTests++;
+    
+    if (testCgiEnvironment()) passedTests++;
+    totalTests++;
+    
     std::cout << "\n=====================================================" << std::endl;
     std::cout << "                    TEST SUMMARY                     " << std::endl;
     std::cout << "=====================================================" << std::endl;
@@ -0,0 +1,430 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_monitor.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 23:40:12 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/17 23:40:12 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+// Runs a Monitor in a child process on a temporary document root and drives it over real
+// sockets, for behaviour that only shows once the event loop is running.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../include/Config.hpp"
+#include "../include/Logger.hpp"
+#include "../include/Monitor.hpp"
+
+#define TEST_PORT 18181
+
+static std::string testRoot;
+
+std::string toString(size_t value) {
+    std::ostringstream oss;
+    oss << value;
+    return oss.str();
+}
+
+void printTestHeader(const std::string& testName) {
+    std::cout << "\n===========================================" << std::endl;
+    std::cout << "  " << testName << std::endl;
+    std::cout << "===========================================" << std::endl;
+}
+
+void printResult(bool success, const std::string& testName) {
+    std::cout << "[" << (success ? "PASS" : "FAIL") << "] " << testName << std::endl;
+}
+
+void writeFile(const std::string& name, const std::string& content, mode_t mode) {
+    const std::string path = testRoot + "/" + name;
+    std::ofstream     file(path.c_str());
+    file << content;
+    file.close();
+    chmod(path.c_str(), mode);
+}
+
+void createTestFiles() {
+    char directory[] = "/tmp/webserv_monitor_test_XXXXXX";
+    testRoot = mkdtemp(directory);
+    writeFile("index.html", "<h1>monitor test</h1>\n", 0644);
+    // Writes far more than a socket buffer holds, so the script is still running when
+    // the client goes away
+    writeFile("big.cgi",
+              "#!/bin/sh\n"
+              "printf 'Content-Type: text/plain\\r\\n\\r\\n'\n"
+              "head -c 8000000 /dev/zero\n",
+              0755);
+    writeFile("small.cgi",
+              "#!/bin/sh\n"
+              "printf 'Content-Type: text/plain\\r\\n\\r\\nsmall\\n'\n",
+              0755);
+    // Streams its output in small records, so the upstream connection keeps reporting data
+    writeFile("stream.py",
+              "import sys, time\n"
+              "sys.stdout.write('Content-Type: text/plain\\r\\n\\r\\n')\n"
+              "for i in range(3000):\n"
+              "    sys.stdout.write('a' * 4096)\n"
+              "    sys.stdout.flush()\n"
+              "    time.sleep(0.0005)\n",
+              0644);
+    writeFile("hello.pl", "print \"Content-Type: text/plain\\r\\n\\r\\nhello from perl\\n\";\n", 0644);
+}
+
+void removeTestFiles() {
+    const char* names[] = {"index.html", "big.cgi", "small.cgi", "stream.py", "hello.pl"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        unlink((testRoot + "/" + names[i]).c_str());
+    }
+    rmdir(testRoot.c_str());
+}
+
+// Starts a server on TEST_PORT with the given global directives. With relativeRoot, the
+// server runs from the parent of the test root and names it by its bare directory name.
+// Returns its pid once it accepts connections, or -1
+pid_t startServer(const std::string& directives, bool relativeRoot = false) {
+    const std::string::size_type slash = testRoot.rfind('/');
+    const std::string root = relativeRoot ? testRoot.substr(slash + 1) : testRoot;
+    const std::string configPath = testRoot + "/test.conf";
+    std::ofstream     file(configPath.c_str());
+    file << directives << "server {\n    listen " << TEST_PORT << ";\n    root " << root
+         << ";\n    index index.html;\n\n    location / {\n        root " << root
+         << ";\n        allow_methods GET POST;\n    }\n}\n";
+    file.close();
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (relativeRoot && chdir(testRoot.substr(0, slash).c_str()) < 0) {
+            _exit(1);
+        }
+        std::ofstream devNull("/dev/null");
+        Logger        logger(devNull, false);
+        Config        config(logger);
+        int           status = 1;
+        if (config.load(configPath)) {
+            Monitor monitor(logger);
+            if (monitor.init(config) == 0) {
+                monitor.beginLoop();
+                status = 0;
+            }
+        }
+        _exit(status);
+    }
+    for (int attempt = 0; pid > 0 && attempt < 100; attempt++) {
+        int fdesc = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(TEST_PORT);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool connected = connect(fdesc, reinterpret_cast<struct sockaddr*>(&address),
+                                 sizeof(address)) == 0;
+        close(fdesc);
+        if (connected) {
+            return pid;
+        }
+        usleep(20000);
+    }
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+    return -1;
+}
+
+// Stops the server. Returns whether it was still running and shut down cleanly
+bool stopServer(pid_t pid) {
+    int status = 0;
+
+    if (waitpid(pid, &status, WNOHANG) != 0) {
+        std::cout << "Server died before the end of the test" << std::endl;
+        return false;
+    }
+    kill(pid, SIGTERM);
+    waitpid(pid, &status, 0);
+    unlink((testRoot + "/test.conf").c_str());
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int connectClient() {
+    int                fdesc = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(TEST_PORT);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fdesc, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fdesc);
+        return -1;
+    }
+    struct timeval timeout = {5, 0};
+    setsockopt(fdesc, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fdesc;
+}
+
+bool sendAll(int fdesc, const std::string& data) {
+    return send(fdesc, data.data(), data.length(), MSG_NOSIGNAL) ==
+           static_cast<ssize_t>(data.length());
+}
+
+// Sends a request on a fresh connection and returns the whole response
+std::string fetchResponse(const std::string& path) {
+    int fdesc = connectClient();
+    if (fdesc < 0) {
+        return "";
+    }
+    sendAll(fdesc, "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    std::string response;
+    char        buffer[4096];
+    ssize_t     bytesRead;
+    while ((bytesRead = recv(fdesc, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, static_cast<size_t>(bytesRead));
+    }
+    close(fdesc);
+    return response;
+}
+
+// The status line of the response to path
+std::string fetchStatusLine(const std::string& path) {
+    const std::string response = fetchResponse(path);
+    return response.substr(0, response.find("\r\n"));
+}
+
+// Sends requests for path and half-closes each client while the response is being produced
+void halfCloseClients(const std::string& path) {
+    for (int i = 0; i < 20; i++) {
+        int fdesc = connectClient();
+        sendAll(fdesc, "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        usleep(10000 * (i % 5));
+        shutdown(fdesc, SHUT_WR);
+        usleep(30000);
+        close(fdesc);
+    }
+}
+
+// Clients that send a CGI request and half-close while the script writes close the script's
+// pipes along with them, while events for those pipes may still be queued
+bool testCgiClientHalfClose() {
+    printTestHeader("CGI Client Half-Close");
+
+    pid_t pid = startServer("");
+    if (pid < 0) {
+        printResult(false, "CGI client half-close (server did not start)");
+        return false;
+    }
+    halfCloseClients("/big.cgi");
+    const std::string statusLine = fetchStatusLine("/index.html");
+    const bool        stopped = stopServer(pid);
+
+    std::cout << "After half-closes: '" << statusLine << "', clean exit: "
+              << (stopped ? "YES" : "NO") << std::endl;
+    bool success = statusLine == "HTTP/1.1 200 OK" && stopped;
+    printResult(success, "CGI client half-close");
+    return success;
+}
+
+// The same for a script run by a CGI worker pool: the client takes its FastCGI upstream
+// connection with it, under both event backends
+bool testFastCgiClientHalfClose() {
+    printTestHeader("FastCGI Client Half-Close");
+
+    const char* backends[] = {"epoll", "poll"};
+    int         passed = 0;
+    int         total = 0;
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        pid_t pid = startServer("cgi_workers 2;\nevent_backend " + std::string(backends[i]) +
+                                ";\n");
+        // epoll only exists on Linux
+        if (pid < 0) {
+            std::cout << backends[i] << ": not available" << std::endl;
+            continue;
+        }
+        total++;
+        halfCloseClients("/stream.py");
+        const std::string statusLine = fetchStatusLine("/index.html");
+        const bool        stopped = stopServer(pid);
+
+        std::cout << backends[i] << ": '" << statusLine << "', clean exit: "
+                  << (stopped ? "YES" : "NO") << std::endl;
+        if (statusLine == "HTTP/1.1 200 OK" && stopped) {
+            passed++;
+        }
+    }
+    bool success = total > 0 && passed == total;
+    printResult(success, "FastCGI client half-close (" + toString(passed) + "/" +
+                             toString(total) + ")");
+    return success;
+}
+
+// CPU time the process has used so far, in clock ticks, or -1 where /proc is unavailable
+long getCpuTicks(pid_t pid) {
+    std::ostringstream path;
+    path << "/proc/" << pid << "/stat";
+    std::ifstream file(path.str().c_str());
+    std::string   stat;
+    std::getline(file, stat);
+
+    // The fields after the command name, which may itself hold spaces
+    std::string::size_type end = stat.rfind(')');
+    if (end == std::string::npos) {
+        return -1;
+    }
+    std::istringstream fields(stat.substr(end + 2));
+    std::string        field;
+    long               utime = 0;
+    long               stime = 0;
+    for (int i = 3; i <= 13 && fields >> field; i++) {
+    }
+    fields >> utime >> stime;
+    return fields ? utime + stime : -1;
+}
+
+// Reads until count responses have started arriving, or the receive timeout runs out
+size_t readResponses(int fdesc, size_t count) {
+    std::string data;
+    char        buffer[4096];
+    size_t      found = 0;
+
+    while (found < count) {
+        ssize_t bytesRead = recv(fdesc, buffer, sizeof(buffer), 0);
+        if (bytesRead <= 0) {
+            break;
+        }
+        data.append(buffer, static_cast<size_t>(bytesRead));
+        found = 0;
+        for (size_t pos = data.find("HTTP/1.1 200 OK"); pos != std::string::npos;
+             pos = data.find("HTTP/1.1 200 OK", pos + 1)) {
+            found++;
+        }
+    }
+    return found;
+}
+
+// Once a keep-alive CGI response is sent, the request pipelined behind it must be served and
+// the idle connection must leave the loop asleep until the next request
+bool testKeepAliveCgiIdle() {
+    printTestHeader("Keep-Alive CGI Idle");
+
+    const char* backends[] = {"epoll", "poll"};
+    int         passed = 0;
+    int         total = 0;
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        pid_t pid = startServer("event_backend " + std::string(backends[i]) + ";\n");
+        if (pid < 0) {
+            std::cout << backends[i] << ": not available" << std::endl;
+            continue;
+        }
+        total++;
+        int fdesc = connectClient();
+        sendAll(fdesc,
+                "GET /small.cgi HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        const size_t pipelined = readResponses(fdesc, 2);
+
+        const long before = getCpuTicks(pid);
+        sleep(1);
+        const long idleTicks = getCpuTicks(pid) - before;
+
+        sendAll(fdesc, "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        const size_t after = readResponses(fdesc, 1);
+        close(fdesc);
+        const bool stopped = stopServer(pid);
+
+        std::cout << backends[i] << ": pipelined " << pipelined << "/2, idle CPU ticks "
+                  << (before < 0 ? "unknown" : toString(static_cast<size_t>(idleTicks)))
+                  << ", next request " << (after == 1 ? "served" : "lost") << std::endl;
+        // A spinning loop burns the whole second; ten ticks leave room for a busy machine
+        if (pipelined == 2 && (before < 0 || idleTicks < 10) && after == 1 && stopped) {
+            passed++;
+        }
+    }
+    bool success = total > 0 && passed == total;
+    printResult(success, "Keep-alive CGI idle (" + toString(passed) + "/" + toString(total) +
+                             ")");
+    return success;
+}
+
+// A worker-pool Perl script under a relative root: do FILE must not look the bare path up in
+// @INC, where the working directory is missing on current Perls
+bool testPerlWorkerRelativeRoot() {
+    printTestHeader("Perl Worker Relative Root");
+
+    pid_t pid = startServer("cgi_workers 1;\n", true);
+    if (pid < 0) {
+        printResult(false, "Perl worker relative root (server did not start)");
+        return false;
+    }
+    const std::string response = fetchResponse("/hello.pl");
+    const bool        stopped = stopServer(pid);
+
+    const std::string::size_type bodyPos = response.find("\r\n\r\n");
+    const std::string body = bodyPos == std::string::npos ? "" : response.substr(bodyPos + 4);
+    // The body may arrive chunked, so only its text is looked for
+    const bool ran = body.find("hello from perl\n") != std::string::npos;
+    std::cout << "Status: '" << response.substr(0, response.find("\r\n"))
+              << "', script output: " << (ran ? "YES" : "NO")
+              << ", clean exit: " << (stopped ? "YES" : "NO") << std::endl;
+    bool success = response.compare(0, 15, "HTTP/1.1 200 OK") == 0 && ran && stopped;
+    printResult(success, "Perl worker relative root");
+    return success;
+}
+
+int main() {
+    std::cout << "=====================================================" << std::endl;
+    std::cout << "              Event Loop Test Suite                 " << std::endl;
+    std::cout << "=====================================================" << std::endl;
+
+    // Clients disappear on purpose
+    signal(SIGPIPE, SIG_IGN);
+    createTestFiles();
+
+    int totalTests = 0;
+    int passedTests = 0;
+
+    if (testCgiClientHalfClose()) passedTests++;
+    totalTests++;
+
+    if (testFastCgiClientHalfClose()) passedTests++;
+    totalTests++;
+
+    if (testKeepAliveCgiIdle()) passedTests++;
+    totalTests++;
+
+    if (testPerlWorkerRelativeRoot()) passedTests++;
+    totalTests++;
+
+    removeTestFiles();
+
+    std::cout << "\n=====================================================" << std::endl;
+    std::cout << "                    TEST SUMMARY                     " << std::endl;
+    std::cout << "=====================================================" << std::endl;
+    std::cout << "Tests Passed: " << passedTests << "/" << totalTests << std::endl;
+
+    if (passedTests == totalTests) {
+        std::cout << "🎉 ALL EVENT LOOP TESTS PASSED!" << std::endl;
+    } else {
+        std::cout << "❌ Some tests failed. Review the event loop." << std::endl;
+    }
+
+    std::cout << "=====================================================" << std::endl;
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
@@ -14,6 +14,7 @@
 #include <sstream>
 #include <string>
 #include <fstream>
+#include <unistd.h>
 
 #include "../include/HttpServer.hpp"
 #include "../include/HttpRequest.hpp"
@@ -272,6 +273,138 @@ bool testMultipleIndexFiles() {
     return success;
 }
 
+bool testCachedFileHeaders() {
+    printTestHeader("Cached File Headers Test");
+    
+    Config config = createTestConfigWithServer();
+    Logger logger(std::cout, false);
+    HttpServer server(config, logger);
+    
+    Config::Server mockServer;
+    
+    // The second request is served from the in-memory cache with precomputed entity headers
+    HttpResponse first = server.testServeStaticFile("/tmp/webserv_test_files/index.html", mockServer);
+    HttpResponse second = server.testServeStaticFile("/tmp/webserv_test_files/index.html", mockServer);
+    std::string head = second.toString().substr(0, second.toString().length() - second.getContentLength());
+    
+    std::size_t lengthHeader = head.find("Content-Length: ");
+    bool success = second.getStatusCode() == 200 && second.getBody() == first.getBody() &&
+                  lengthHeader != std::string::npos &&
+                  head.find("Content-Length: ", lengthHeader + 1) == std::string::npos &&
+                  head.find("Content-Type: text/html") != std::string::npos &&
+                  head.find("ETag: \"") != std::string::npos &&
+                  head.find("Last-Modified: ") != std::string::npos &&
+                  first.toString() == second.toString();
+    
+    std::cout << "Head:\n" << head;
+    
+    printResult(success, "Cached file headers");
+    return success;
+}
+
+bool testDisabledFileCache() {
+    printTestHeader("Disabled File Cache Test");
+    
+    // open_file_cache 0 turns the cache off; files must still be found, just never kept
+    const std::string configPath = "/tmp/webserv_test_files/nocache.conf";
+    std::ofstream configFile(configPath.c_str());
+    configFile << "open_file_cache 0;\nserver {\n    listen 18182;\n    root /tmp/webserv_test_files;\n"
+               << "    index index.html;\n\n    location / {\n        root /tmp/webserv_test_files;\n"
+               << "        allow_methods GET HEAD;\n    }\n}\n";
+    configFile.close();
+    
+    Logger logger(std::cout, false);
+    Config config(logger);
+    bool loaded = config.load(configPath);
+    unlink(configPath.c_str());
+    if (!loaded || config.getServers().empty()) {
+        printResult(false, "Disabled file cache (config not loaded)");
+        return false;
+    }
+    HttpServer server(config, logger);
+    const Config::Server& configServer = config.getServers()[0];
+    
+    HttpResponse first = server.testServeStaticFile("/tmp/webserv_test_files/index.html", configServer);
+    HttpResponse second = server.testServeStaticFile("/tmp/webserv_test_files/test.txt", configServer);
+    HttpResponse missing = server.testServeStaticFile("/tmp/webserv_test_files/missing.txt", configServer);
+    
+    HttpRequest getRequest;
+    getRequest.parse("GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    HttpResponse viaGet = server.processRequest(getRequest, 18182);
+    HttpRequest headRequest;
+    headRequest.parse("HEAD /test.txt HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    HttpResponse viaHead = server.processRequest(headRequest, 18182);
+    
+    std::cout << "Direct: " << first.getStatusCode() << ", " << second.getStatusCode()
+              << ", missing: " << missing.getStatusCode() << std::endl;
+    std::cout << "GET: " << viaGet.getStatusCode() << ", HEAD: " << viaHead.getStatusCode() << std::endl;
+    
+    bool success = first.getStatusCode() == 200 &&
+                  first.getBody().find("Hello from index.html") != std::string::npos &&
+                  second.getStatusCode() == 200 && second.getBody() == "test\n" &&
+                  missing.getStatusCode() == 404 && viaGet.getStatusCode() == 200 &&
+                  viaHead.getStatusCode() == 200;
+    
+    printResult(success, "Disabled file cache");
+    return success;
+}
+
+// The value of header name in a serialized response, or an empty string
+std::string findHeader(const std::string& response, const std::string& name) {
+    std::size_t start = response.find("\r\n" + name + ": ");
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += name.length() + 4;
+    return response.substr(start, response.find("\r\n", start) - start);
+}
+
+bool testHeadEntityHeaders() {
+    printTestHeader("HEAD Entity Headers Test");
+    
+    const std::string configPath = "/tmp/webserv_test_files/head.conf";
+    std::ofstream configFile(configPath.c_str());
+    configFile << "server {\n    listen 18182;\n    root /tmp/webserv_test_files;\n"
+               << "    index index.html;\n\n    location / {\n        root /tmp/webserv_test_files;\n"
+               << "        allow_methods GET HEAD;\n    }\n}\n";
+    configFile.close();
+    
+    Logger logger(std::cout, false);
+    Config config(logger);
+    bool loaded = config.load(configPath);
+    unlink(configPath.c_str());
+    if (!loaded || config.getServers().empty()) {
+        printResult(false, "HEAD entity headers (config not loaded)");
+        return false;
+    }
+    HttpServer server(config, logger);
+    
+    // HEAD answers with the head GET would send, validators included, and no body
+    HttpRequest headRequest;
+    headRequest.parse("HEAD /test.txt HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    HttpResponse viaHead = server.processRequest(headRequest, 18182);
+    HttpRequest getRequest;
+    getRequest.parse("GET /test.txt HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    HttpResponse viaGet = server.processRequest(getRequest, 18182);
+    
+    std::string head = viaHead.toString();
+    std::string get = viaGet.toString();
+    const char* names[] = {"Content-Type", "Content-Length", "ETag", "Last-Modified"};
+    bool sameHeaders = true;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        std::string value = findHeader(head, names[i]);
+        std::cout << names[i] << ": " << value << std::endl;
+        sameHeaders = sameHeaders && !value.empty() && value == findHeader(get, names[i]);
+    }
+    
+    bool success = viaHead.getStatusCode() == 200 && viaGet.getStatusCode() == 200 &&
+                  sameHeaders && findHeader(head, "Content-Length") == "5" &&
+                  head.substr(head.length() - 4) == "\r\n\r\n" && viaHead.getContentLength() == 0;
+    
+    printResult(success, "HEAD entity headers");
+    return success;
+}
+
 int main() {
     std::cout << "=====================================================" << std::endl;
     std::cout << "           Static File Serving Test Suite           " << std::endl;
@@ -301,6 +434,15 @@ int main() {
     if (testMultipleIndexFiles()) passedTests++;
     totalTests++;
     
+    if (testCachedFileHeaders()) passedTests++;
+    totalTests++;
+    
+    if (testDisabledFileCache()) passedTests++;
+    totalTests++;
+    
+    if (testHeadEntityHeaders()) passedTests++;
+    totalTests++;
+    
     std::cout << "\n=====================================================" << std::endl;
     std::cout << "                    TEST SUMMARY                     " << std::endl;
     std::cout << "=====================================================" << std::endl;
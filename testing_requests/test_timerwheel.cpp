@@ -0,0 +1,263 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_timerwheel.cpp                                :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: ribana-b <ribana-b@student.42malaga.com>   +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 01:02:19 by ribana-b          #+#    #+# Malaga      */
+/*   Updated: 2026/10/18 01:02:19 by ribana-b         ###   ########.com      */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/TimerWheel.hpp"
+
+void printTestHeader(const std::string& testName) {
+    std::cout << "\n===========================================" << std::endl;
+    std::cout << "  " << testName << std::endl;
+    std::cout << "===========================================" << std::endl;
+}
+
+void printResult(bool success, const std::string& testName) {
+    std::cout << "[" << (success ? "PASS" : "FAIL") << "] " << testName << std::endl;
+}
+
+// Advances the wheel to now and returns the names of the timers that expired, in order
+std::string expire(TimerWheel& wheel, time_t now) {
+    std::string       names;
+    TimerWheel::Node* node = NULL;
+
+    wheel.advance(now);
+    while ((node = wheel.popExpired()) != NULL) {
+        names += *static_cast<const char*>(node->data);
+    }
+    return names;
+}
+
+// Owns its timer the way a Connection does; data points at a one-letter name. A wheel starts
+// at the current second, so each test counts its deadlines from time(NULL)
+struct Timer {
+    TimerWheel::Node node;
+    char             name;
+
+    explicit Timer(char timerName) : name(timerName) { node.data = &name; }
+};
+
+bool testScheduleAndExpire() {
+    printTestHeader("Schedule And Expire");
+
+    TimerWheel   wheel;
+    const time_t start = time(NULL);
+    Timer        a('a');
+    Timer        b('b');
+    Timer        c('c');
+    wheel.schedule(a.node, start + 5);
+    wheel.schedule(b.node, start + 2);
+    wheel.schedule(c.node, start + 10);
+
+    const std::string early = expire(wheel, start + 1);
+    const std::string second = expire(wheel, start + 2);
+    const std::string middle = expire(wheel, start + 7);
+    const std::string last = expire(wheel, start + 10);
+    const std::string after = expire(wheel, start + 20);
+
+    std::cout << "Expired: '" << early << "' '" << second << "' '" << middle << "' '" << last
+              << "' '" << after << "'" << std::endl;
+    bool success = early.empty() && second == "b" && middle == "a" && last == "c" &&
+                   after.empty() && !a.node.isLinked() && !c.node.isLinked();
+    printResult(success, "Schedule and expire");
+    return success;
+}
+
+bool testPastDeadline() {
+    printTestHeader("Past Deadline");
+
+    TimerWheel   wheel;
+    const time_t start = time(NULL);
+    Timer        late('l');
+    wheel.advance(start + 3);
+    wheel.schedule(late.node, start);
+
+    // A deadline already past fires on the next second processed, not a lap later
+    const int         waitMs = wheel.getWaitMs(start + 3, 30000);
+    const std::string fired = expire(wheel, start + 4);
+
+    std::cout << "Wait: " << waitMs << " ms, fired: '" << fired << "'" << std::endl;
+    bool success = waitMs <= 1000 && fired == "l";
+    printResult(success, "Past deadline");
+    return success;
+}
+
+bool testReschedule() {
+    printTestHeader("Reschedule");
+
+    TimerWheel   wheel;
+    const time_t start = time(NULL);
+    Timer        a('a');
+    Timer        b('b');
+    wheel.schedule(a.node, start + 3);
+    wheel.schedule(b.node, start + 3);
+    // Moving a timer, later or earlier, leaves nothing behind in its old slot
+    wheel.schedule(a.node, start + 8);
+    wheel.schedule(b.node, start + 1);
+    wheel.schedule(b.node, start + 2);
+
+    const std::string first = expire(wheel, start + 1);
+    const std::string second = expire(wheel, start + 3);
+    const std::string third = expire(wheel, start + 8);
+
+    std::cout << "Expired: '" << first << "' '" << second << "' '" << third << "'" << std::endl;
+    bool success = first.empty() && second == "b" && third == "a";
+    printResult(success, "Reschedule");
+    return success;
+}
+
+bool testCancelByDestructor() {
+    printTestHeader("Cancel By Destructor");
+
+    TimerWheel   wheel;
+    const time_t start = time(NULL);
+    Timer        kept('k');
+    {
+        Timer dropped('d');
+        wheel.schedule(dropped.node, start + 2);
+        wheel.schedule(kept.node, start + 2);
+    }
+    const std::string scheduled = expire(wheel, start + 2);
+
+    // An owner deleted after its timer expired, but before it was popped, drops out too
+    Timer* gone = new Timer('g');
+    Timer  stays('s');
+    wheel.schedule(gone->node, start + 4);
+    wheel.schedule(stays.node, start + 4);
+    wheel.advance(start + 4);
+    delete gone;
+    const std::string expired = expire(wheel, start + 4);
+
+    std::cout << "Expired: '" << scheduled << "' and '" << expired << "'" << std::endl;
+    bool success = scheduled == "k" && expired == "s";
+    printResult(success, "Cancel by destructor");
+    return success;
+}
+
+bool testWheelLap() {
+    printTestHeader("Wheel Lap");
+
+    TimerWheel   wheel;
+    const time_t start = time(NULL);
+    Timer        near('n');
+    Timer        far('f');
+    Timer        jumped('j');
+    // Both land in the same slot, one lap apart
+    wheel.schedule(near.node, start + 44);
+    wheel.schedule(far.node, start + 44 + TIMER_WHEEL_SLOTS);
+    wheel.schedule(jumped.node, start + 3 * TIMER_WHEEL_SLOTS);
+
+    const std::string firstLap = expire(wheel, start + 44);
+    const std::string beforeDue = expire(wheel, start + 43 + TIMER_WHEEL_SLOTS);
+    const std::string secondLap = expire(wheel, start + 44 + TIMER_WHEEL_SLOTS);
+    // A long stall visits every slot once and still finds what fell due
+    const std::string afterStall = expire(wheel, start + 5 * TIMER_WHEEL_SLOTS);
+
+    std::cout << "Expired: '" << firstLap << "' '" << beforeDue << "' '" << secondLap << "' '"
+              << afterStall << "'" << std::endl;
+    bool success = firstLap == "n" && beforeDue.empty() && secondLap == "f" &&
+                   afterStall == "j" && far.node.expires == start + 44 + TIMER_WHEEL_SLOTS;
+    printResult(success, "Wheel lap");
+    return success;
+}
+
+bool testWaitTime() {
+    printTestHeader("Wait Time");
+
+    TimerWheel   wheel;
+    const time_t start = time(NULL);
+    Timer        a('a');
+    const int    empty = wheel.getWaitMs(start, 30000);
+    wheel.schedule(a.node, start + 3);
+    const int until = wheel.getWaitMs(start, 30000);
+    const int capped = wheel.getWaitMs(start, 2000);
+    wheel.advance(start + 3);
+    const int due = wheel.getWaitMs(start + 3, 30000);
+    expire(wheel, start + 3);
+
+    std::cout << "Empty: " << empty << " ms, until: " << until << " ms, capped: " << capped
+              << " ms, due: " << due << " ms" << std::endl;
+    bool success = empty == 30000 && until <= 3000 && until >= 2000 && capped == 2000 && due == 0;
+    printResult(success, "Wait time");
+    return success;
+}
+
+bool testOwnersOutliveWheel() {
+    printTestHeader("Owners Outlive Wheel");
+
+    std::vector<Timer*> timers;
+    {
+        TimerWheel   wheel;
+        const time_t start = time(NULL);
+        for (int i = 0; i < 10; i++) {
+            timers.push_back(new Timer('x'));
+            wheel.schedule(timers.back()->node, start + 1 + i * 100);
+        }
+        wheel.advance(start + 1);
+    }
+    // The wheel detached every node, so the owners go away without touching it
+    bool detached = true;
+    for (size_t i = 0; i < timers.size(); i++) {
+        detached = detached && !timers[i]->node.isLinked();
+        delete timers[i];
+    }
+    std::cout << "All detached: " << (detached ? "YES" : "NO") << std::endl;
+    printResult(detached, "Owners outlive wheel");
+    return detached;
+}
+
+int main() {
+    std::cout << "=====================================================" << std::endl;
+    std::cout << "             TimerWheel Test Suite                  " << std::endl;
+    std::cout << "=====================================================" << std::endl;
+
+    int totalTests = 0;
+    int passedTests = 0;
+
+    if (testScheduleAndExpire()) passedTests++;
+    totalTests++;
+
+    if (testPastDeadline()) passedTests++;
+    totalTests++;
+
+    if (testReschedule()) passedTests++;
+    totalTests++;
+
+    if (testCancelByDestructor()) passedTests++;
+    totalTests++;
+
+    if (testWheelLap()) passedTests++;
+    totalTests++;
+
+    if (testWaitTime()) passedTests++;
+    totalTests++;
+
+    if (testOwnersOutliveWheel()) passedTests++;
+    totalTests++;
+
+    std::cout << "\n=====================================================" << std::endl;
+    std::cout << "                    TEST SUMMARY                     " << std::endl;
+    std::cout << "=====================================================" << std::endl;
+    std::cout << "Tests Passed: " << passedTests << "/" << totalTests << std::endl;
+
+    if (passedTests == totalTests) {
+        std::cout << "🎉 ALL TIMER WHEEL TESTS PASSED!" << std::endl;
+    } else {
+        std::cout << "❌ Some tests failed. Review the TimerWheel implementation." << std::endl;
+    }
+
+    std::cout << "=====================================================" << std::endl;
+
+    return (passedTests == totalTests) ? 0 : 1;
+}